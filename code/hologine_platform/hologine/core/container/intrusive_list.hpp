@@ -229,15 +229,7 @@ namespace holo
 			
 			if (next != nullptr)
 			{
-				position->previous = node;
-			}
-
-			// Update the next point of 'position->previous'
-			Node* previous = position->previous;
-
-			if (previous != nullptr)
-			{
-				previous->next = node;
+				next->previous = node;
 			}
 			
 			// Update the next pointer of 'position'
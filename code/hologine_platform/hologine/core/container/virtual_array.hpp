@@ -0,0 +1,373 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#ifndef HOLOGINE_CORE_CONTAINER_VIRTUAL_ARRAY_HPP_
+#define HOLOGINE_CORE_CONTAINER_VIRTUAL_ARRAY_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include "core/exception.hpp"
+#include "core/math/util.hpp"
+#include "core/memory/allocator.hpp"
+#include "core/memory/memory_region.hpp"
+
+namespace holo
+{
+	// A growable array with stable element addresses.
+	//
+	// A virtual array reserves enough address space for its maximum number of
+	// elements up front, and commits pages as elements are appended. Elements
+	// are thus never moved or copied when the array grows, and pointers to
+	// elements remain valid until the element is removed.
+	//
+	// Since reserving address space is cheap, the maximum can (and should) be
+	// generous; only the committed pages cost memory.
+	template <class Type>
+	class virtual_array
+	{
+		virtual_array(const virtual_array&) = delete;
+		virtual_array& operator =(const virtual_array&) = delete;
+
+		public:
+			typedef Type* iterator;
+			typedef const Type* const_iterator;
+
+			// The minimum number of bytes committed at a time.
+			static const std::size_t minimum_commit_size = 0x10000u;
+
+			// Constructs an empty virtual array able to store up to 'max_count'
+			// elements.
+			//
+			// No memory is committed until an element is added.
+			explicit virtual_array(std::size_t max_count);
+
+			// Move constructor.
+			//
+			// The elements are not moved; 'other' is left empty.
+			virtual_array(virtual_array&& other);
+
+			// Destroys every element and releases the reserved range.
+			~virtual_array();
+
+			// Appends a copy of 'value'.
+			//
+			// Returns a pointer to the new element, or NULL if the array is full or
+			// memory could not be committed; an exception is pushed in such a case.
+			Type* push_back(const Type& value);
+
+			// Appends 'value', moving it into the array.
+			//
+			// Returns a pointer to the new element, or NULL on failure.
+			Type* push_back(Type&& value);
+
+			// Constructs an element at the end of the array from 'arguments'.
+			//
+			// Returns a pointer to the new element, or NULL on failure.
+			template <class... Arguments>
+			Type* emplace_back(Arguments&&... arguments);
+
+			// Appends copies of 'count' elements from 'values'.
+			//
+			// Memory for every element is committed at once. Returns a pointer to
+			// the first new element, or NULL on failure, in which case nothing is
+			// appended.
+			Type* append(const Type* values, std::size_t count);
+
+			// Appends 'count' default constructed elements.
+			//
+			// Returns a pointer to the first new element, or NULL on failure, in
+			// which case nothing is appended.
+			Type* append(std::size_t count);
+
+			// Destroys the last element.
+			//
+			// The array must not be empty.
+			void pop_back();
+
+			// Destroys every element.
+			//
+			// Committed memory is kept for later use.
+			void clear();
+
+			// Commits enough memory for 'count' elements.
+			//
+			// Returns false if 'count' is larger than the maximum count or the
+			// memory could not be committed.
+			bool reserve(std::size_t count);
+
+			// Accesses the element at 'index'.
+			Type& operator [](std::size_t index);
+			const Type& operator [](std::size_t index) const;
+
+			// Gets a pointer to the first element.
+			//
+			// Elements are stored contiguously.
+			Type* get_data();
+			const Type* get_data() const;
+
+			// Gets the number of elements.
+			std::size_t get_count() const;
+
+			// Gets the maximum number of elements.
+			std::size_t get_max_count() const;
+
+			// Gets the number of elements that fit in the committed memory.
+			std::size_t get_committed_count() const;
+
+			// Gets if the array has no elements.
+			bool is_empty() const;
+
+			// Iterators over the elements, in order.
+			iterator begin();
+			iterator end();
+			const_iterator begin() const;
+			const_iterator end() const;
+
+		private:
+			// Commits enough memory for 'count' elements, if it is not already
+			// committed.
+			bool commit(std::size_t count);
+
+			// Memory region backing the elements.
+			holo::memory_region memory_region;
+
+			// Pointer to the first element.
+			Type* elements;
+
+			// The number of elements.
+			std::size_t count;
+
+			// The maximum number of elements.
+			std::size_t max_count;
+	};
+
+	template <class Type>
+	const std::size_t virtual_array<Type>::minimum_commit_size;
+
+	template <class Type>
+	virtual_array<Type>::virtual_array(std::size_t max_count) :
+		memory_region(holo::memory_region::get_minimum_size(max_count * sizeof(Type))),
+		elements(nullptr),
+		count(0),
+		max_count(max_count)
+	{
+		// Reserve (but don't commit) the range right away, so the base never
+		// changes.
+		elements = (Type*)memory_region.grow(0);
+	}
+
+	template <class Type>
+	virtual_array<Type>::virtual_array(virtual_array&& other) :
+		memory_region(std::move(other.memory_region)),
+		elements(other.elements),
+		count(other.count),
+		max_count(other.max_count)
+	{
+		other.elements = nullptr;
+		other.count = 0;
+		other.max_count = 0;
+	}
+
+	template <class Type>
+	virtual_array<Type>::~virtual_array()
+	{
+		clear();
+	}
+
+	template <class Type>
+	Type* virtual_array<Type>::push_back(const Type& value)
+	{
+		return emplace_back(value);
+	}
+
+	template <class Type>
+	Type* virtual_array<Type>::push_back(Type&& value)
+	{
+		return emplace_back(std::move(value));
+	}
+
+	template <class Type>
+	template <class... Arguments>
+	Type* virtual_array<Type>::emplace_back(Arguments&&... arguments)
+	{
+		if (!commit(count + 1))
+		{
+			return nullptr;
+		}
+
+		Type* element = new(&elements[count]) Type(std::forward<Arguments>(arguments)...);
+		++count;
+
+		return element;
+	}
+
+	template <class Type>
+	Type* virtual_array<Type>::append(const Type* values, std::size_t count)
+	{
+		if (!commit(this->count + count))
+		{
+			return nullptr;
+		}
+
+		Type* first = &elements[this->count];
+		std::uninitialized_copy(values, values + count, first);
+		this->count += count;
+
+		return first;
+	}
+
+	template <class Type>
+	Type* virtual_array<Type>::append(std::size_t count)
+	{
+		if (!commit(this->count + count))
+		{
+			return nullptr;
+		}
+
+		Type* first = &elements[this->count];
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			new(&first[i]) Type();
+		}
+		this->count += count;
+
+		return first;
+	}
+
+	template <class Type>
+	void virtual_array<Type>::pop_back()
+	{
+		holo_assert(count > 0);
+
+		elements[--count].~Type();
+	}
+
+	template <class Type>
+	void virtual_array<Type>::clear()
+	{
+		while (count > 0)
+		{
+			pop_back();
+		}
+	}
+
+	template <class Type>
+	bool virtual_array<Type>::reserve(std::size_t count)
+	{
+		return commit(count);
+	}
+
+	template <class Type>
+	Type& virtual_array<Type>::operator [](std::size_t index)
+	{
+		holo_assert(index < count);
+
+		return elements[index];
+	}
+
+	template <class Type>
+	const Type& virtual_array<Type>::operator [](std::size_t index) const
+	{
+		holo_assert(index < count);
+
+		return elements[index];
+	}
+
+	template <class Type>
+	Type* virtual_array<Type>::get_data()
+	{
+		return elements;
+	}
+
+	template <class Type>
+	const Type* virtual_array<Type>::get_data() const
+	{
+		return elements;
+	}
+
+	template <class Type>
+	std::size_t virtual_array<Type>::get_count() const
+	{
+		return count;
+	}
+
+	template <class Type>
+	std::size_t virtual_array<Type>::get_max_count() const
+	{
+		return max_count;
+	}
+
+	template <class Type>
+	std::size_t virtual_array<Type>::get_committed_count() const
+	{
+		return memory_region.get_current_size() / sizeof(Type);
+	}
+
+	template <class Type>
+	bool virtual_array<Type>::is_empty() const
+	{
+		return count == 0;
+	}
+
+	template <class Type>
+	typename virtual_array<Type>::iterator virtual_array<Type>::begin()
+	{
+		return elements;
+	}
+
+	template <class Type>
+	typename virtual_array<Type>::iterator virtual_array<Type>::end()
+	{
+		return elements + count;
+	}
+
+	template <class Type>
+	typename virtual_array<Type>::const_iterator virtual_array<Type>::begin() const
+	{
+		return elements;
+	}
+
+	template <class Type>
+	typename virtual_array<Type>::const_iterator virtual_array<Type>::end() const
+	{
+		return elements + count;
+	}
+
+	template <class Type>
+	bool virtual_array<Type>::commit(std::size_t count)
+	{
+		if (count > max_count || elements == nullptr)
+		{
+			push_exception(exception::out_of_memory);
+
+			return false;
+		}
+
+		std::size_t required_size = count * sizeof(Type);
+		std::size_t committed_size = memory_region.get_current_size();
+		if (required_size <= committed_size)
+		{
+			return true;
+		}
+
+		// Commit whole pages, and at least a few at a time, to keep the number
+		// of calls to the platform down. The region is then always committed to
+		// a page boundary.
+		std::size_t grow_size = std::max(required_size - committed_size, minimum_commit_size);
+		grow_size = math::round_up(grow_size, holo::memory_region::get_page_size());
+		grow_size = std::min(grow_size, memory_region.get_reserved_size() - committed_size);
+
+		return memory_region.grow(grow_size) != nullptr;
+	}
+}
+
+#endif
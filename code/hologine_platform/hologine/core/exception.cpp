@@ -86,6 +86,8 @@ const holo::exception_code holo::exception::invalid_argument =
 	holo::exception_code_generator::generate_exception_code("holo_exception_invalid_argument");
 const holo::exception_code holo::exception::platform =
 	holo::exception_code_generator::generate_exception_code("holo_exception_platform");
+const holo::exception_code holo::exception::unsupported =
+	holo::exception_code_generator::generate_exception_code("holo_exception_unsupported");
 
 // Implementation of the exception handler.
 static holo::thread_local_variable<holo::exception_handler> holo_exception_handler;
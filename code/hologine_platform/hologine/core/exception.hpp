@@ -131,6 +131,13 @@ namespace holo
 		// Generally, platform exceptions should provide the platform-specific
 		// error code.
 		extern const exception_code platform;
+
+		// Represents an error where the operation is not supported by the
+		// underlying platform.
+		//
+		// For example, a memory region asked to track dirty pages on a platform
+		// that cannot track writes generates this error.
+		extern const exception_code unsupported;
 	}
 
 	// A method that is called when an exception is pushed on to the stack.
@@ -0,0 +1,144 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include <algorithm>
+#include <cstring>
+#include "core/exception.hpp"
+#include "core/io/ring_buffer.hpp"
+
+holo::ring_buffer::ring_buffer(std::size_t capacity) :
+	memory_region(
+		holo::memory_region::get_minimum_size(capacity),
+		holo::memory_region::flag_mirrored),
+	memory(nullptr),
+	capacity(0),
+	read_position(0),
+	write_position(0)
+{
+	memory = (std::uint8_t*)memory_region.claim();
+
+	if (memory != nullptr)
+	{
+		this->capacity = memory_region.get_reserved_size();
+	}
+}
+
+holo::ring_buffer::~ring_buffer()
+{
+	// Nothing.
+}
+
+std::size_t holo::ring_buffer::get_capacity() const
+{
+	return capacity;
+}
+
+std::size_t holo::ring_buffer::get_readable_size() const
+{
+	return (std::size_t)(
+		write_position.load(std::memory_order_acquire) -
+		read_position.load(std::memory_order_acquire));
+}
+
+std::size_t holo::ring_buffer::get_writable_size() const
+{
+	return capacity - get_readable_size();
+}
+
+std::uint64_t holo::ring_buffer::get_read_position() const
+{
+	return read_position.load(std::memory_order_acquire);
+}
+
+std::uint64_t holo::ring_buffer::get_write_position() const
+{
+	return write_position.load(std::memory_order_acquire);
+}
+
+std::uint8_t* holo::ring_buffer::begin_write(std::size_t* size)
+{
+	// Only the producer advances the write position, so a relaxed load of it
+	// is enough; the read position tells how much the consumer released.
+	std::uint64_t position = write_position.load(std::memory_order_relaxed);
+	*size = capacity - (std::size_t)(position - read_position.load(std::memory_order_acquire));
+
+	if (capacity == 0)
+	{
+		return nullptr;
+	}
+
+	return memory + position % capacity;
+}
+
+void holo::ring_buffer::end_write(std::size_t count)
+{
+	holo_assert(count <= get_writable_size());
+
+	// Publish the bytes to the consumer.
+	write_position.fetch_add(count, std::memory_order_release);
+}
+
+const std::uint8_t* holo::ring_buffer::begin_read(std::size_t* size)
+{
+	std::uint64_t position = read_position.load(std::memory_order_relaxed);
+	*size = (std::size_t)(write_position.load(std::memory_order_acquire) - position);
+
+	if (capacity == 0)
+	{
+		return nullptr;
+	}
+
+	return memory + position % capacity;
+}
+
+void holo::ring_buffer::end_read(std::size_t count)
+{
+	holo_assert(count <= get_readable_size());
+
+	// Hand the space back to the producer.
+	read_position.fetch_add(count, std::memory_order_release);
+}
+
+std::size_t holo::ring_buffer::write(const std::uint8_t* data, std::size_t count)
+{
+	std::size_t size;
+	std::uint8_t* span = begin_write(&size);
+
+	count = std::min(count, size);
+	if (count > 0)
+	{
+		std::memcpy(span, data, count);
+		end_write(count);
+	}
+
+	return count;
+}
+
+std::size_t holo::ring_buffer::read(std::uint8_t* data, std::size_t count)
+{
+	std::size_t size;
+	const std::uint8_t* span = begin_read(&size);
+
+	count = std::min(count, size);
+	if (count > 0)
+	{
+		std::memcpy(data, span, count);
+		end_read(count);
+	}
+
+	return count;
+}
+
+std::size_t holo::ring_buffer::skip(std::size_t count)
+{
+	count = std::min(count, get_readable_size());
+	end_read(count);
+
+	return count;
+}
@@ -0,0 +1,118 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#ifndef HOLOGINE_CORE_IO_RING_BUFFER_HPP_
+#define HOLOGINE_CORE_IO_RING_BUFFER_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "core/memory/memory_region.hpp"
+
+namespace holo
+{
+	// A queue of bytes in a fixed amount of memory.
+	//
+	// The buffer is backed by a mirrored holo::memory_region, so the bytes
+	// past the end of the buffer are the bytes at its beginning. Data that
+	// wraps around is therefore still contiguous: reads and writes are a single
+	// memcpy, and the readable and writable spans can be handed out as plain
+	// pointers for zero-copy access.
+	//
+	// One thread may write to the buffer while another reads from it. Any more
+	// producers or consumers must be serialized by the caller.
+	class ring_buffer final
+	{
+		ring_buffer(const ring_buffer&) = delete;
+		ring_buffer& operator =(const ring_buffer&) = delete;
+
+		public:
+			// Constructs a ring buffer of at least 'capacity' bytes.
+			//
+			// The capacity is rounded up to the page size. If the memory could not
+			// be mapped, an exception is pushed and the capacity is zero.
+			explicit ring_buffer(std::size_t capacity);
+
+			// Unmaps the buffer.
+			~ring_buffer();
+
+			// Gets the number of bytes the buffer can hold.
+			std::size_t get_capacity() const;
+
+			// Gets the number of bytes waiting to be read.
+			std::size_t get_readable_size() const;
+
+			// Gets the number of bytes that can be written before the buffer is
+			// full.
+			std::size_t get_writable_size() const;
+
+			// Gets the total number of bytes read since the buffer was created.
+			std::uint64_t get_read_position() const;
+
+			// Gets the total number of bytes written since the buffer was created.
+			std::uint64_t get_write_position() const;
+
+			// Gets a pointer to the free space of the buffer and stores its size
+			// in 'size'.
+			//
+			// The span is contiguous, even if it wraps around. Bytes written to it
+			// are published by holo::ring_buffer::end_write(std::size_t).
+			std::uint8_t* begin_write(std::size_t* size);
+
+			// Publishes 'count' bytes written to the span returned by
+			// holo::ring_buffer::begin_write(std::size_t*).
+			void end_write(std::size_t count);
+
+			// Gets a pointer to the bytes waiting to be read and stores their
+			// number in 'size'.
+			//
+			// The span is contiguous, even if it wraps around. The bytes stay in
+			// the buffer until released by holo::ring_buffer::end_read(std::size_t).
+			const std::uint8_t* begin_read(std::size_t* size);
+
+			// Releases 'count' bytes read from the span returned by
+			// holo::ring_buffer::begin_read(std::size_t*).
+			void end_read(std::size_t count);
+
+			// Writes up to 'count' bytes from 'data'.
+			//
+			// Returns the number of bytes written, which is less than 'count' if
+			// the buffer filled up.
+			std::size_t write(const std::uint8_t* data, std::size_t count);
+
+			// Reads up to 'count' bytes into 'data'.
+			//
+			// Returns the number of bytes read, which is less than 'count' if the
+			// buffer ran out.
+			std::size_t read(std::uint8_t* data, std::size_t count);
+
+			// Discards up to 'count' bytes waiting to be read.
+			//
+			// Returns the number of bytes discarded.
+			std::size_t skip(std::size_t count);
+
+		private:
+			// The mirrored memory region backing the buffer.
+			holo::memory_region memory_region;
+
+			// The base of the buffer, or NULL if the region could not be mapped.
+			std::uint8_t* memory;
+
+			// The size of the buffer, not counting the mirror.
+			std::size_t capacity;
+
+			// Total number of bytes read; only advanced by the consumer.
+			std::atomic<std::uint64_t> read_position;
+
+			// Total number of bytes written; only advanced by the producer.
+			std::atomic<std::uint64_t> write_position;
+	};
+}
+
+#endif
@@ -0,0 +1,86 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include "core/exception.hpp"
+#include "core/io/ring_buffer.hpp"
+#include "core/io/ring_buffer_stream.hpp"
+
+holo::ring_buffer_stream::ring_buffer_stream(
+	holo::ring_buffer* ring_buffer,
+	bool readable,
+	bool writable) :
+		ring_buffer(ring_buffer),
+		is_readable(readable),
+		is_writable(writable)
+{
+	holo_assert(ring_buffer);
+}
+
+std::size_t holo::ring_buffer_stream::read(std::uint8_t* data, std::size_t count)
+{
+	if (!is_readable)
+	{
+		return 0;
+	}
+
+	return ring_buffer->read(data, count);
+}
+
+std::size_t holo::ring_buffer_stream::write(const std::uint8_t* data, std::size_t count)
+{
+	if (!is_writable)
+	{
+		return 0;
+	}
+
+	return ring_buffer->write(data, count);
+}
+
+bool holo::ring_buffer_stream::seek(std::uint64_t offset, int flags)
+{
+	// Bytes can't be un-read or un-written, so only skipping ahead makes sense.
+	if (!is_readable || flags != seek_flags::forward_relative)
+	{
+		return false;
+	}
+
+	if (offset > ring_buffer->get_readable_size())
+	{
+		return false;
+	}
+
+	ring_buffer->skip((std::size_t)offset);
+
+	return true;
+}
+
+std::uint64_t holo::ring_buffer_stream::get_position() const
+{
+	if (is_readable)
+	{
+		return ring_buffer->get_read_position();
+	}
+
+	return ring_buffer->get_write_position();
+}
+
+bool holo::ring_buffer_stream::get_readable() const
+{
+	return is_readable;
+}
+
+bool holo::ring_buffer_stream::get_writable() const
+{
+	return is_writable;
+}
+
+std::uint64_t holo::ring_buffer_stream::get_length() const
+{
+	return ring_buffer->get_write_position();
+}
@@ -0,0 +1,73 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#ifndef HOLOGINE_CORE_IO_RING_BUFFER_STREAM_HPP_
+#define HOLOGINE_CORE_IO_RING_BUFFER_STREAM_HPP_
+
+#include <cstdint>
+#include "core/io/stream_interface.hpp"
+
+namespace holo
+{
+	class ring_buffer;
+
+	// Stream reader or writer on one end of a holo::ring_buffer.
+	//
+	// A producer writes to a writable stream, and a consumer reads the same
+	// bytes back from a readable stream on the same ring buffer. Reads and
+	// writes are partial once the buffer runs empty or full, respectively.
+	//
+	// The position of a readable stream is the number of bytes read from the
+	// ring buffer; otherwise, it is the number of bytes written. The length is
+	// the number of bytes written, so a reader can tell how many bytes are
+	// waiting. The only seek supported is skipping ahead on a readable stream.
+	class ring_buffer_stream : public stream_interface
+	{
+		public:
+			// Creates a stream on 'ring_buffer' with the specified read/write
+			// access.
+			//
+			// A stream may be both readable and writable, in which case it acts
+			// as a queue.
+			ring_buffer_stream(holo::ring_buffer* ring_buffer, bool readable, bool writable);
+
+			// Implementation.
+			std::size_t read(std::uint8_t* data, std::size_t count) override;
+
+			// Implementation.
+			std::size_t write(const std::uint8_t* data, std::size_t count) override;
+
+			// Implementation.
+			bool seek(std::uint64_t offset, int flags) override;
+
+			// Implementation.
+			std::uint64_t get_position() const override;
+
+			// Implementation.
+			bool get_readable() const override;
+
+			// Implementation.
+			bool get_writable() const override;
+
+			// Implementation.
+			std::uint64_t get_length() const override;
+
+		private:
+			// The ring buffer.
+			holo::ring_buffer* ring_buffer;
+
+			// Whether or not we can read data.
+			bool is_readable;
+
+			// Whether or not we can write data.
+			bool is_writable;
+	};
+}
+
+#endif
@@ -26,7 +26,7 @@ namespace holo
 		template <std::size_t N>
 		struct mask
 		{
-			static const std::size_t value = (1 << (N + 1)) - 1;
+			static const std::size_t value = (std::size_t(1) << N) - 1;
 		};
 
 		// Ensures when 'N' is 0, mask::value == 0.
@@ -105,6 +105,38 @@ namespace holo
 			#endif
 		}
 
+		// Returns the index of the least-significant set bit.
+		//
+		// The behavior is undefined if value is zero.
+		inline std::uint32_t bit_scan_forward(std::uint32_t value)
+		{
+			#ifdef HOLOGINE_INTRINSICS_GCC_COMPATIBLE
+				return __builtin_ctz(value);
+			#elif HOLOGINE_INTRINSICS_MSVC_COMPATIBLE
+				unsigned long index;
+				_BitScanForward(&index, value);
+				return index;
+			#else
+				#error holo::bit_scan_forward only has intrinsic implementations
+			#endif
+		}
+
+		// Returns the index of the least-significant set bit.
+		//
+		// The behavior is undefined if value is zero.
+		inline std::uint64_t bit_scan_forward(std::uint64_t value)
+		{
+			#ifdef HOLOGINE_INTRINSICS_GCC_COMPATIBLE
+				return __builtin_ctzll(value);
+			#elif HOLOGINE_INTRINSICS_MSVC_COMPATIBLE
+				unsigned long index;
+				_BitScanForward64(&index, value);
+				return index;
+			#else
+				#error holo::bit_scan_forward only has intrinsic implementations
+			#endif
+		}
+
 		// Calculates the log2 of a 32-bit integer using bitwise operations.
 		//
 		// The result is rounded down. Therefore, bit_log2(2 ^ X) is greater than
@@ -22,7 +22,7 @@ std::uint32_t holo::math::next_power_of_two(std::uint32_t value)
 	return ++value;
 }
 
-std::uint64_t holo::math::new_power_of_two(std::uint64_t value)
+std::uint64_t holo::math::next_power_of_two(std::uint64_t value)
 {
 	--value;
 	
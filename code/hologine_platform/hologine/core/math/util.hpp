@@ -73,14 +73,14 @@ namespace holo
 			// Any other non-power of two will be the same.
 			//
 			// Simple!
-			return value != 0 && !(value & ~(value - 1));
+			return value != 0 && !(value & (value - 1));
 		}
 		
 		// Gets the next-highest power-of-two of a 32-bit unsigned integer.
 		std::uint32_t next_power_of_two(std::uint32_t value);
 		
 		// Gets the next highest power-of-two of a 64-bit unsigned integer.
-		std::uint64_t new_power_of_two(std::uint64_t value);
+		std::uint64_t next_power_of_two(std::uint64_t value);
 	}
 }
 
@@ -0,0 +1,150 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include "core/io/binary_writer.hpp"
+#include "core/memory/allocation_statistics.hpp"
+
+double holo::get_internal_fragmentation(const holo::allocation_statistics& statistics)
+{
+	if (statistics.allocated_bytes == 0)
+	{
+		return 0.0;
+	}
+
+	return 1.0 - (double)statistics.requested_bytes / (double)statistics.allocated_bytes;
+}
+
+bool holo::write_allocation_statistics(
+	holo::binary_writer* writer,
+	const holo::allocation_statistics& statistics)
+{
+	return
+	(
+		writer->write_ulong(statistics.live_objects) &&
+		writer->write_ulong(statistics.live_bytes) &&
+		writer->write_ulong(statistics.peak_objects) &&
+		writer->write_ulong(statistics.peak_bytes) &&
+		writer->write_ulong(statistics.committed_bytes) &&
+		writer->write_ulong(statistics.reserved_bytes) &&
+		writer->write_ulong(statistics.allocation_count) &&
+		writer->write_ulong(statistics.deallocation_count) &&
+		writer->write_ulong(statistics.requested_bytes) &&
+		writer->write_ulong(statistics.allocated_bytes)
+	);
+}
+
+holo::allocation_counter::allocation_counter() :
+	enabled(false),
+	live_objects(0),
+	live_bytes(0),
+	peak_objects(0),
+	peak_bytes(0),
+	committed_bytes(0),
+	reserved_bytes(0),
+	allocation_count(0),
+	deallocation_count(0),
+	requested_bytes(0),
+	allocated_bytes(0)
+{
+	// Nothing.
+}
+
+void holo::allocation_counter::set_enabled(bool enable)
+{
+	enabled.store(enable, std::memory_order_relaxed);
+}
+
+bool holo::allocation_counter::get_enabled() const
+{
+	return enabled.load(std::memory_order_relaxed);
+}
+
+// Only a single thread records at a time, so the counters are updated with
+// plain loads and stores rather than (much more expensive) atomic
+// read-modify-write operations. The atomics only make snapshots safe.
+void holo::allocation_counter::record_allocation(
+	std::size_t requested_size,
+	std::size_t allocated_size,
+	std::size_t object_count)
+{
+	if (!enabled.load(std::memory_order_relaxed))
+	{
+		return;
+	}
+
+	std::size_t objects = live_objects.load(std::memory_order_relaxed) + object_count;
+	std::size_t bytes = live_bytes.load(std::memory_order_relaxed) + allocated_size;
+
+	live_objects.store(objects, std::memory_order_relaxed);
+	live_bytes.store(bytes, std::memory_order_relaxed);
+	update_peak(peak_objects, objects);
+	update_peak(peak_bytes, bytes);
+
+	allocation_count.store(
+		allocation_count.load(std::memory_order_relaxed) + object_count,
+		std::memory_order_relaxed);
+	requested_bytes.store(
+		requested_bytes.load(std::memory_order_relaxed) + requested_size,
+		std::memory_order_relaxed);
+	allocated_bytes.store(
+		allocated_bytes.load(std::memory_order_relaxed) + allocated_size,
+		std::memory_order_relaxed);
+}
+
+void holo::allocation_counter::record_deallocation(
+	std::size_t allocated_size,
+	std::size_t object_count)
+{
+	if (!enabled.load(std::memory_order_relaxed))
+	{
+		return;
+	}
+
+	// Objects allocated before the counter was enabled may be freed after, so
+	// don't let the live counts wrap around.
+	std::size_t objects = live_objects.load(std::memory_order_relaxed);
+	std::size_t bytes = live_bytes.load(std::memory_order_relaxed);
+
+	live_objects.store(objects > object_count ? objects - object_count : 0, std::memory_order_relaxed);
+	live_bytes.store(bytes > allocated_size ? bytes - allocated_size : 0, std::memory_order_relaxed);
+
+	deallocation_count.store(
+		deallocation_count.load(std::memory_order_relaxed) + object_count,
+		std::memory_order_relaxed);
+}
+
+void holo::allocation_counter::record_memory(
+	std::size_t committed_bytes,
+	std::size_t reserved_bytes)
+{
+	this->committed_bytes.store(committed_bytes, std::memory_order_relaxed);
+	this->reserved_bytes.store(reserved_bytes, std::memory_order_relaxed);
+}
+
+void holo::allocation_counter::get_statistics(holo::allocation_statistics* statistics) const
+{
+	statistics->live_objects = live_objects.load(std::memory_order_relaxed);
+	statistics->live_bytes = live_bytes.load(std::memory_order_relaxed);
+	statistics->peak_objects = peak_objects.load(std::memory_order_relaxed);
+	statistics->peak_bytes = peak_bytes.load(std::memory_order_relaxed);
+	statistics->committed_bytes = committed_bytes.load(std::memory_order_relaxed);
+	statistics->reserved_bytes = reserved_bytes.load(std::memory_order_relaxed);
+	statistics->allocation_count = allocation_count.load(std::memory_order_relaxed);
+	statistics->deallocation_count = deallocation_count.load(std::memory_order_relaxed);
+	statistics->requested_bytes = requested_bytes.load(std::memory_order_relaxed);
+	statistics->allocated_bytes = allocated_bytes.load(std::memory_order_relaxed);
+}
+
+void holo::allocation_counter::update_peak(std::atomic<std::size_t>& peak, std::size_t value)
+{
+	if (value > peak.load(std::memory_order_relaxed))
+	{
+		peak.store(value, std::memory_order_relaxed);
+	}
+}
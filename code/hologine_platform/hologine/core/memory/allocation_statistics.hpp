@@ -0,0 +1,142 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#ifndef HOLOGINE_CORE_MEMORY_ALLOCATION_STATISTICS_HPP_
+#define HOLOGINE_CORE_MEMORY_ALLOCATION_STATISTICS_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace holo
+{
+	class binary_writer;
+
+	// A snapshot of the usage of an allocator, or a portion of one (such as a
+	// single size class of a holo::heap_allocator).
+	struct allocation_statistics
+	{
+		// Number of live objects.
+		std::size_t live_objects;
+
+		// Bytes occupied by live objects, including any padding up to the size of
+		// the block backing the object.
+		std::size_t live_bytes;
+
+		// The largest value 'live_objects' has reached.
+		std::size_t peak_objects;
+
+		// The largest value 'live_bytes' has reached.
+		std::size_t peak_bytes;
+
+		// Bytes of memory committed to back allocations.
+		std::size_t committed_bytes;
+
+		// Bytes of address space reserved to back allocations.
+		std::size_t reserved_bytes;
+
+		// Total number of allocations made.
+		std::uint64_t allocation_count;
+
+		// Total number of deallocations made.
+		std::uint64_t deallocation_count;
+
+		// Total bytes requested by all allocations made.
+		std::uint64_t requested_bytes;
+
+		// Total bytes handed out by all allocations made, including padding.
+		std::uint64_t allocated_bytes;
+	};
+
+	// Gets the internal fragmentation of the allocations described by
+	// 'statistics'.
+	//
+	// This is the portion of all bytes handed out that were not requested (i.e.,
+	// padding), from 0 (none) to 1. It is computed over every allocation made
+	// while statistics were enabled, not only the live ones.
+	double get_internal_fragmentation(const holo::allocation_statistics& statistics);
+
+	// Writes 'statistics' using the provided holo::binary_writer.
+	//
+	// Each field is written, in declaration order, as an unsigned 64-bit
+	// integer.
+	//
+	// Returns true on success, false if the stream could not be written.
+	bool write_allocation_statistics(
+		holo::binary_writer* writer,
+		const holo::allocation_statistics& statistics);
+
+	// Accumulates holo::allocation_statistics for an allocator.
+	//
+	// Recording allocations is opt-in; until enabled, the counter only tracks
+	// committed and reserved memory.
+	//
+	// Only one thread may record to the counter at a time (for example, the
+	// thread that owns the allocator, or any thread holding the allocator's
+	// lock), but snapshots can be taken by any thread at any time. Individual
+	// fields of a snapshot are exact, but a snapshot taken while another thread
+	// is recording may mix values from before and after an allocation.
+	class allocation_counter final
+	{
+		allocation_counter(const allocation_counter&) = delete;
+		allocation_counter& operator =(const allocation_counter&) = delete;
+
+		public:
+			// Creates a disabled counter with all statistics zeroed.
+			allocation_counter();
+
+			// Enables or disables recording allocations.
+			//
+			// Statistics gathered so far are kept when disabled.
+			void set_enabled(bool enable);
+
+			// Returns true if recording allocations is enabled.
+			bool get_enabled() const;
+
+			// Records the allocation of 'object_count' objects totalling
+			// 'requested_size' bytes, satisfied by 'allocated_size' bytes.
+			void record_allocation(
+				std::size_t requested_size,
+				std::size_t allocated_size,
+				std::size_t object_count = 1);
+
+			// Records the deallocation of 'object_count' objects spanning
+			// 'allocated_size' bytes.
+			void record_deallocation(std::size_t allocated_size, std::size_t object_count = 1);
+
+			// Records the amount of memory committed and reserved by the allocator.
+			//
+			// This is tracked even when the counter is disabled.
+			void record_memory(std::size_t committed_bytes, std::size_t reserved_bytes);
+
+			// Takes a snapshot of the statistics.
+			void get_statistics(holo::allocation_statistics* statistics) const;
+
+		private:
+			// Updates a peak value.
+			static void update_peak(std::atomic<std::size_t>& peak, std::size_t value);
+
+			// Whether or not recording allocations is enabled.
+			std::atomic<bool> enabled;
+
+			// See holo::allocation_statistics.
+			std::atomic<std::size_t> live_objects;
+			std::atomic<std::size_t> live_bytes;
+			std::atomic<std::size_t> peak_objects;
+			std::atomic<std::size_t> peak_bytes;
+			std::atomic<std::size_t> committed_bytes;
+			std::atomic<std::size_t> reserved_bytes;
+			std::atomic<std::uint64_t> allocation_count;
+			std::atomic<std::uint64_t> deallocation_count;
+			std::atomic<std::uint64_t> requested_bytes;
+			std::atomic<std::uint64_t> allocated_bytes;
+	};
+}
+
+#endif
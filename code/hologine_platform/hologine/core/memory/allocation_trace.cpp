@@ -0,0 +1,295 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include <cstring>
+#include "core/exception.hpp"
+#include "core/io/stream_interface.hpp"
+#include "core/math/bits.hpp"
+#include "core/math/util.hpp"
+#include "core/memory/allocation_trace.hpp"
+
+namespace
+{
+	// Identifies a trace.
+	const std::uint8_t trace_magic[] = { 'H', 'A', 'T', 'R' };
+
+	// Version of the encoding; bumped whenever it changes.
+	const std::uint8_t trace_version = 1;
+
+	// The bits of the first byte of an event holding its kind. The rest hold
+	// the log2 of the alignment.
+	const std::uint8_t event_kind_mask = 0x03u;
+	const std::uint8_t event_alignment_shift = 2;
+}
+
+// Encodes 'value' seven bits at a time, least significant bits first, setting
+// the high bit of every byte but the last.
+static std::size_t encode_integer(std::uint64_t value, std::uint8_t* output)
+{
+	std::size_t length = 0;
+
+	while (value >= 0x80u)
+	{
+		output[length++] = (std::uint8_t)(value | 0x80u);
+		value >>= 7;
+	}
+	output[length++] = (std::uint8_t)value;
+
+	return length;
+}
+
+// Maps signed distances to unsigned integers so that small distances either way
+// encode to few bytes.
+static std::uint64_t encode_distance(std::uint64_t from, std::uint64_t to)
+{
+	std::int64_t distance = (std::int64_t)(to - from);
+
+	return ((std::uint64_t)distance << 1) ^ (std::uint64_t)(distance >> 63);
+}
+
+// Reverses encode_distance(std::uint64_t, std::uint64_t).
+static std::uint64_t decode_distance(std::uint64_t from, std::uint64_t value)
+{
+	std::uint64_t distance = (value >> 1) ^ (std::uint64_t)(-(std::int64_t)(value & 1));
+
+	return from + distance;
+}
+
+const std::size_t holo::allocation_trace_writer::buffer_size;
+const std::size_t holo::allocation_trace_writer::max_event_size;
+
+holo::allocation_trace_writer::allocation_trace_writer(holo::stream_interface* stream) :
+	stream(stream),
+	buffer_length(0),
+	previous_timestamp(0),
+	previous_address(0),
+	event_count(0),
+	is_failed(false)
+{
+	holo_assert(stream != nullptr);
+
+	std::memcpy(buffer, trace_magic, sizeof(trace_magic));
+	buffer[sizeof(trace_magic)] = trace_version;
+	buffer_length = sizeof(trace_magic) + 1;
+}
+
+holo::allocation_trace_writer::~allocation_trace_writer()
+{
+	flush();
+}
+
+bool holo::allocation_trace_writer::write(const holo::allocation_event& event)
+{
+	if (is_failed)
+	{
+		return false;
+	}
+
+	if (buffer_length + max_event_size > buffer_size && !flush())
+	{
+		return false;
+	}
+
+	holo_assert(event.timestamp >= previous_timestamp);
+	holo_assert(event.kind == allocation_event::kind_deallocate ||
+		math::is_power_of_two((std::uint64_t)event.alignment));
+
+	std::uint8_t header = (std::uint8_t)event.kind;
+	if (event.kind != allocation_event::kind_deallocate)
+	{
+		header |= (std::uint8_t)(math::bit_log2((std::uint64_t)event.alignment) << event_alignment_shift);
+	}
+
+	std::uint8_t* output = buffer + buffer_length;
+	std::size_t length = 0;
+
+	output[length++] = header;
+	length += encode_integer(event.thread, output + length);
+	length += encode_integer(event.timestamp - previous_timestamp, output + length);
+	if (event.kind != allocation_event::kind_deallocate)
+	{
+		length += encode_integer(event.size, output + length);
+	}
+	length += encode_integer(encode_distance(previous_address, event.address), output + length);
+
+	buffer_length += length;
+	previous_timestamp = event.timestamp;
+	previous_address = event.address;
+	++event_count;
+
+	return true;
+}
+
+bool holo::allocation_trace_writer::flush()
+{
+	if (is_failed)
+	{
+		return false;
+	}
+
+	if (buffer_length > 0 && stream->write(buffer, buffer_length) != buffer_length)
+	{
+		push_exception(exception::invalid_operation);
+		is_failed = true;
+
+		return false;
+	}
+
+	buffer_length = 0;
+
+	return true;
+}
+
+std::uint64_t holo::allocation_trace_writer::get_event_count() const
+{
+	return event_count;
+}
+
+const std::size_t holo::allocation_trace_reader::buffer_size;
+
+holo::allocation_trace_reader::allocation_trace_reader(holo::stream_interface* stream) :
+	stream(stream),
+	buffer_length(0),
+	buffer_position(0),
+	previous_timestamp(0),
+	previous_address(0),
+	is_header_valid(false),
+	is_trace_corrupt(false)
+{
+	holo_assert(stream != nullptr);
+
+	std::uint8_t header[sizeof(trace_magic) + 1];
+	for (std::size_t i = 0; i < sizeof(header); ++i)
+	{
+		if (!read_byte(&header[i]))
+		{
+			push_exception(exception::invalid_argument);
+
+			return;
+		}
+	}
+
+	if (std::memcmp(header, trace_magic, sizeof(trace_magic)) != 0 ||
+		header[sizeof(trace_magic)] != trace_version)
+	{
+		push_exception(exception::invalid_argument);
+
+		return;
+	}
+
+	is_header_valid = true;
+}
+
+bool holo::allocation_trace_reader::read(holo::allocation_event* event)
+{
+	if (!is_header_valid || is_trace_corrupt)
+	{
+		return false;
+	}
+
+	std::uint8_t header;
+	if (!read_byte(&header))
+	{
+		// A clean end of the trace.
+		return false;
+	}
+
+	event->kind = header & event_kind_mask;
+	if (event->kind > allocation_event::kind_sized_deallocate)
+	{
+		push_exception(exception::invalid_operation);
+		is_trace_corrupt = true;
+
+		return false;
+	}
+
+	std::uint64_t thread;
+	std::uint64_t timestamp;
+	std::uint64_t size = 0;
+	std::uint64_t address;
+	if (!read_integer(&thread) ||
+		!read_integer(&timestamp) ||
+		(event->kind != allocation_event::kind_deallocate && !read_integer(&size)) ||
+		!read_integer(&address))
+	{
+		push_exception(exception::invalid_operation);
+		is_trace_corrupt = true;
+
+		return false;
+	}
+
+	previous_timestamp += timestamp;
+	previous_address = decode_distance(previous_address, address);
+
+	event->thread = (std::uint32_t)thread;
+	event->timestamp = previous_timestamp;
+	event->address = previous_address;
+	event->size = (std::size_t)size;
+	if (event->kind == allocation_event::kind_deallocate)
+	{
+		event->alignment = 0;
+	}
+	else
+	{
+		event->alignment = (std::size_t)1 << (header >> event_alignment_shift);
+	}
+
+	return true;
+}
+
+bool holo::allocation_trace_reader::is_valid() const
+{
+	return is_header_valid;
+}
+
+bool holo::allocation_trace_reader::is_corrupt() const
+{
+	return is_trace_corrupt;
+}
+
+bool holo::allocation_trace_reader::read_byte(std::uint8_t* value)
+{
+	if (buffer_position == buffer_length)
+	{
+		buffer_length = stream->read(buffer, buffer_size);
+		buffer_position = 0;
+
+		if (buffer_length == 0)
+		{
+			return false;
+		}
+	}
+
+	*value = buffer[buffer_position++];
+
+	return true;
+}
+
+bool holo::allocation_trace_reader::read_integer(std::uint64_t* value)
+{
+	*value = 0;
+
+	for (std::size_t shift = 0; shift < 64; shift += 7)
+	{
+		std::uint8_t byte;
+		if (!read_byte(&byte))
+		{
+			return false;
+		}
+
+		*value |= (std::uint64_t)(byte & 0x7fu) << shift;
+		if (!(byte & 0x80u))
+		{
+			return true;
+		}
+	}
+
+	// Too many bytes; the trace is corrupt.
+	return false;
+}
@@ -0,0 +1,196 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#ifndef HOLOGINE_CORE_MEMORY_ALLOCATION_TRACE_HPP_
+#define HOLOGINE_CORE_MEMORY_ALLOCATION_TRACE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace holo
+{
+	class stream_interface;
+
+	// A single allocator call recorded in an allocation trace.
+	struct allocation_event
+	{
+		// The kinds of events.
+		enum
+		{
+			// A call to holo::allocator::allocate(std::size_t, std::size_t).
+			kind_allocate = 0,
+
+			// A call to holo::allocator::deallocate(void*).
+			kind_deallocate = 1,
+
+			// A call to holo::allocator::deallocate(void*, std::size_t,
+			// std::size_t).
+			kind_sized_deallocate = 2
+		};
+
+		// The kind of event.
+		int kind;
+
+		// Index of the thread that made the call, in order of each thread's
+		// first call.
+		std::uint32_t thread;
+
+		// Time of the call, in nanoseconds since the trace started.
+		std::uint64_t timestamp;
+
+		// The address returned by an allocation, or passed to a deallocation.
+		//
+		// A failed allocation is recorded with an address of zero. Addresses are
+		// only meaningful to tell apart allocations in the same trace.
+		std::uint64_t address;
+
+		// The requested size; zero for an unsized deallocation.
+		std::size_t size;
+
+		// The requested alignment; zero for an unsized deallocation.
+		std::size_t alignment;
+	};
+
+	// Encodes allocation events compactly to a stream.
+	//
+	// A trace starts with a short header, followed by the events in order.
+	// Each event takes a byte for its kind and alignment, followed by
+	// variable-length integers for the thread, the time since the previous
+	// event, the size, and the distance from the previous address; a typical
+	// event fits in a handful of bytes.
+	//
+	// Events are buffered and written to the stream in blocks. The writer is
+	// not thread safe.
+	class allocation_trace_writer final
+	{
+		allocation_trace_writer(const allocation_trace_writer&) = delete;
+		allocation_trace_writer& operator =(const allocation_trace_writer&) = delete;
+
+		public:
+			// Creates a writer that writes a trace to 'stream', starting with the
+			// header.
+			explicit allocation_trace_writer(holo::stream_interface* stream);
+
+			// Flushes any buffered events.
+			~allocation_trace_writer();
+
+			// Encodes 'event'.
+			//
+			// Timestamps must not decrease. Returns false if the stream could not
+			// be written; the trace is then truncated, and further events are
+			// dropped.
+			bool write(const holo::allocation_event& event);
+
+			// Writes buffered events to the stream.
+			//
+			// Returns false if the stream could not be written, in which case
+			// holo::exception::invalid_operation is pushed.
+			bool flush();
+
+			// Gets the number of events written.
+			std::uint64_t get_event_count() const;
+
+		private:
+			// Number of events buffered before they're written to the stream.
+			static const std::size_t buffer_size = 0x1000u;
+
+			// The largest an encoded event can be.
+			static const std::size_t max_event_size = 0x40u;
+
+			// The stream.
+			holo::stream_interface* stream;
+
+			// Encoded events yet to be written.
+			std::uint8_t buffer[buffer_size];
+
+			// Number of bytes in the buffer.
+			std::size_t buffer_length;
+
+			// Timestamp of the previous event.
+			std::uint64_t previous_timestamp;
+
+			// Address of the previous event.
+			std::uint64_t previous_address;
+
+			// Number of events written.
+			std::uint64_t event_count;
+
+			// Whether writing to the stream failed.
+			bool is_failed;
+	};
+
+	// Decodes the events of a trace written by holo::allocation_trace_writer.
+	class allocation_trace_reader final
+	{
+		allocation_trace_reader(const allocation_trace_reader&) = delete;
+		allocation_trace_reader& operator =(const allocation_trace_reader&) = delete;
+
+		public:
+			// Creates a reader that reads the trace in 'stream', starting with the
+			// header.
+			//
+			// If the header is missing or of an unknown version,
+			// holo::exception::invalid_argument is pushed and the reader is
+			// invalid.
+			explicit allocation_trace_reader(holo::stream_interface* stream);
+
+			// Decodes the next event into 'event'.
+			//
+			// Returns false at the end of the trace. If the trace is truncated in
+			// the middle of an event, or an event is malformed,
+			// holo::exception::invalid_operation is pushed as well and the reader
+			// is marked corrupt.
+			bool read(holo::allocation_event* event);
+
+			// Gets if the header was valid.
+			bool is_valid() const;
+
+			// Gets if reading stopped at a truncated or malformed event, rather
+			// than at the end of the trace.
+			bool is_corrupt() const;
+
+		private:
+			// Number of bytes read from the stream at a time.
+			static const std::size_t buffer_size = 0x1000u;
+
+			// Reads the next byte, refilling the buffer as needed.
+			//
+			// Returns false at the end of the stream.
+			bool read_byte(std::uint8_t* value);
+
+			// Decodes a variable-length integer.
+			bool read_integer(std::uint64_t* value);
+
+			// The stream.
+			holo::stream_interface* stream;
+
+			// Bytes read from the stream.
+			std::uint8_t buffer[buffer_size];
+
+			// Number of bytes in the buffer.
+			std::size_t buffer_length;
+
+			// Position of the next byte in the buffer.
+			std::size_t buffer_position;
+
+			// Timestamp of the previous event.
+			std::uint64_t previous_timestamp;
+
+			// Address of the previous event.
+			std::uint64_t previous_address;
+
+			// Whether the header was valid.
+			bool is_header_valid;
+
+			// Whether a truncated or malformed event was read.
+			bool is_trace_corrupt;
+	};
+}
+
+#endif
@@ -12,6 +12,43 @@
 
 const std::size_t holo::allocator::default_alignment;
 
+void holo::allocator::deallocate(void* pointer, std::size_t, std::size_t)
+{
+	deallocate(pointer);
+}
+
+std::size_t holo::allocator::get_usable_size(void*)
+{
+	return 0;
+}
+
+std::size_t holo::allocator::allocate_batch(
+	std::size_t size,
+	std::size_t count,
+	void** pointers,
+	std::size_t alignment)
+{
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		pointers[i] = allocate(size, alignment);
+
+		if (pointers[i] == nullptr)
+		{
+			return i;
+		}
+	}
+
+	return count;
+}
+
+void holo::allocator::deallocate_batch(void** pointers, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		deallocate(pointers[i]);
+	}
+}
+
 void* holo::allocator::align_pointer(void* pointer, std::size_t align)
 {
 	// Maximum potential offset required to align the pointer.
@@ -65,6 +65,55 @@ namespace holo
 			// corresponding 'allocate' method. If this condition is not met, then
 			// memory corruption can (and most likely will) occur.
 			virtual void deallocate(void* pointer) = 0;
+
+			// Deallocates a block of memory whose size and alignment are known.
+			//
+			// 'size' and 'alignment' must be the values provided to the
+			// corresponding 'allocate' method. Allocators may use them to avoid
+			// looking up the block, so passing the wrong values can (and most
+			// likely will) corrupt memory.
+			//
+			// The default implementation ignores the size and alignment and calls
+			// holo::allocator::deallocate(void*).
+			virtual void deallocate(void* pointer, std::size_t size, std::size_t alignment = default_alignment);
+
+			// Gets the number of bytes that can be used starting at 'pointer'.
+			//
+			// This is at least the size provided to the corresponding 'allocate'
+			// method, but may be larger if the allocator rounded the request up.
+			// The pointer must have been allocated by this allocator.
+			//
+			// Allocators that don't track the size of their blocks return 0. This is
+			// the default implementation.
+			virtual std::size_t get_usable_size(void* pointer);
+
+			// Allocates 'count' blocks of memory, each 'size' bytes large and
+			// aligned on 'alignment' byte boundaries, storing the pointers in
+			// 'pointers'.
+			//
+			// Returns the number of blocks allocated. If this is less than 'count',
+			// an exception describing the failure will be at the top of the stack;
+			// the blocks that were allocated are still valid and must be freed.
+			//
+			// The default implementation simply calls
+			// holo::allocator::allocate(std::size_t, std::size_t) 'count' times.
+			// Allocators that can hand out several blocks at once more cheaply
+			// should override this method.
+			virtual std::size_t allocate_batch(
+				std::size_t size,
+				std::size_t count,
+				void** pointers,
+				std::size_t alignment = default_alignment);
+
+			// Deallocates 'count' blocks of memory stored in 'pointers'.
+			//
+			// The same requirements as holo::allocator::deallocate(void*) apply to
+			// every block. The blocks do not need to have been allocated by the
+			// same call to holo::allocator::allocate_batch().
+			//
+			// The default implementation simply calls
+			// holo::allocator::deallocate(void*) 'count' times.
+			virtual void deallocate_batch(void** pointers, std::size_t count);
 			
 			// Allocates and constructs an object using the provided alignment, in
 			// bytes.
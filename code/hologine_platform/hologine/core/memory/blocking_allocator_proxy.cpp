@@ -30,3 +30,35 @@ void holo::blocking_allocator_proxy::deallocate(void* pointer)
 
 	return allocator->deallocate(pointer);
 }
+
+void holo::blocking_allocator_proxy::deallocate(void* pointer, std::size_t size, std::size_t alignment)
+{
+	holo::scoped_lock lock(mutex);
+
+	allocator->deallocate(pointer, size, alignment);
+}
+
+std::size_t holo::blocking_allocator_proxy::get_usable_size(void* pointer)
+{
+	holo::scoped_lock lock(mutex);
+
+	return allocator->get_usable_size(pointer);
+}
+
+std::size_t holo::blocking_allocator_proxy::allocate_batch(
+	std::size_t size,
+	std::size_t count,
+	void** pointers,
+	std::size_t alignment)
+{
+	holo::scoped_lock lock(mutex);
+
+	return allocator->allocate_batch(size, count, pointers, alignment);
+}
+
+void holo::blocking_allocator_proxy::deallocate_batch(void** pointers, std::size_t count)
+{
+	holo::scoped_lock lock(mutex);
+
+	allocator->deallocate_batch(pointers, count);
+}
@@ -31,6 +31,29 @@ namespace holo
 			// Implementation.
 			void deallocate(void* pointer);
 
+			// Implementation.
+			void deallocate(void* pointer, std::size_t size, std::size_t alignment = default_alignment) override;
+
+			// Implementation.
+			//
+			// The mutex is claimed for the query, since the underlying allocator
+			// may examine shared state.
+			std::size_t get_usable_size(void* pointer) override;
+
+			// Implementation.
+			//
+			// The mutex is claimed once for the entire batch.
+			std::size_t allocate_batch(
+				std::size_t size,
+				std::size_t count,
+				void** pointers,
+				std::size_t alignment = default_alignment) override;
+
+			// Implementation.
+			//
+			// The mutex is claimed once for the entire batch.
+			void deallocate_batch(void** pointers, std::size_t count) override;
+
 		private:
 			// Underlying allocator to use.
 			holo::allocator* allocator;
@@ -0,0 +1,368 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include <algorithm>
+#include "core/exception.hpp"
+#include "core/container/intrusive_list.hpp"
+#include "core/math/bits.hpp"
+#include "core/memory/buddy_allocator.hpp"
+
+const std::size_t holo::buddy_allocator::maximum_order_count;
+const std::uint8_t holo::buddy_allocator::state_free;
+const std::uint8_t holo::buddy_allocator::state_allocated;
+const std::uint8_t holo::buddy_allocator::state_order_mask;
+
+holo::buddy_allocator::buddy_allocator(
+	holo::memory_arena_pool* arena_pool,
+	std::size_t min_block_size) :
+		arena_pool(arena_pool),
+		min_block_size(0),
+		min_block_shift(get_min_block_shift(arena_pool->get_arena_size(), min_block_size)),
+		order_count(0),
+		states_per_arena(arena_pool->get_arena_size() >> min_block_shift),
+		states(arena_pool->get_reserved_arena_count() * states_per_arena),
+		arena_list_head(nullptr),
+		arena_count(0),
+		counter()
+{
+	holo_assert(arena_pool != nullptr);
+
+	std::size_t arena_shift = math::bit_log2((std::uint64_t)arena_pool->get_arena_size());
+
+	this->min_block_size = (std::size_t)1 << min_block_shift;
+	order_count = arena_shift - min_block_shift + 1;
+	holo_assert(order_count <= maximum_order_count);
+
+	for (std::size_t i = 0; i < maximum_order_count; ++i)
+	{
+		free_lists[i] = nullptr;
+		free_block_counts[i] = 0;
+	}
+}
+
+holo::buddy_allocator::~buddy_allocator()
+{
+	arena_record* current = arena_list_head;
+
+	while (current != nullptr)
+	{
+		arena_record* next = current->next;
+
+		arena_pool->give_arena(current);
+
+		current = next;
+	}
+}
+
+void* holo::buddy_allocator::allocate(std::size_t size, std::size_t alignment)
+{
+	std::size_t order = get_order(size, alignment);
+	if (order >= order_count)
+	{
+		push_exception(exception::invalid_argument);
+
+		return nullptr;
+	}
+
+	// Find the smallest free block that fits, or start over with a fresh arena.
+	std::size_t current = order;
+	while (current < order_count && free_lists[current] == nullptr)
+	{
+		++current;
+	}
+
+	arena_record* arena;
+	std::size_t index;
+	if (current < order_count)
+	{
+		void* block = free_lists[current];
+		arena = arena_pool->get_arena(block);
+		index = get_pointer_distance(block, arena->base) >> min_block_shift;
+
+		remove_free_block(arena, index, current);
+	}
+	else
+	{
+		arena = request_empty_arena();
+		if (arena == nullptr)
+		{
+			return nullptr;
+		}
+
+		index = 0;
+		current = order_count - 1;
+	}
+
+	// Split the block in halves, keeping the lower half, until it is the
+	// right size.
+	while (current > order)
+	{
+		--current;
+		insert_free_block(arena, index + ((std::size_t)1 << current), current);
+	}
+
+	get_states(arena)[index] = state_allocated | (std::uint8_t)order;
+
+	std::size_t block_size = min_block_size << order;
+	counter.record_allocation(size, block_size);
+
+	return (char*)arena->base + (index << min_block_shift);
+}
+
+void holo::buddy_allocator::deallocate(void* pointer)
+{
+	std::size_t index;
+	arena_record* arena = get_block_arena(pointer, &index);
+
+	std::uint8_t* arena_states = get_states(arena);
+	holo_assert(arena_states[index] & state_allocated);
+
+	std::size_t order = arena_states[index] & state_order_mask;
+	arena_states[index] = 0;
+
+	counter.record_deallocation(min_block_size << order);
+
+	// Merge with the buddy for as long as it is free and whole (i.e., not
+	// split into smaller blocks).
+	while (order + 1 < order_count)
+	{
+		std::size_t buddy_index = index ^ ((std::size_t)1 << order);
+		if (arena_states[buddy_index] != (state_free | order))
+		{
+			break;
+		}
+
+		remove_free_block(arena, buddy_index, order);
+
+		index = std::min(index, buddy_index);
+		++order;
+	}
+
+	if (order + 1 == order_count)
+	{
+		release_arena(arena);
+	}
+	else
+	{
+		insert_free_block(arena, index, order);
+	}
+}
+
+void holo::buddy_allocator::deallocate(void* pointer, std::size_t size, std::size_t alignment)
+{
+	(void)size;
+	(void)alignment;
+	holo_assert(get_usable_size(pointer) == min_block_size << get_order(size, alignment));
+
+	deallocate(pointer);
+}
+
+std::size_t holo::buddy_allocator::get_usable_size(void* pointer)
+{
+	std::size_t index;
+	arena_record* arena = get_block_arena(pointer, &index);
+
+	std::size_t order = get_states(arena)[index] & state_order_mask;
+	void* block = (char*)arena->base + (index << min_block_shift);
+
+	return (min_block_size << order) - get_pointer_distance(pointer, block);
+}
+
+void* holo::buddy_allocator::get_block(void* pointer)
+{
+	std::size_t index;
+	arena_record* arena = get_block_arena(pointer, &index);
+
+	return (char*)arena->base + (index << min_block_shift);
+}
+
+std::size_t holo::buddy_allocator::get_min_block_size() const
+{
+	return min_block_size;
+}
+
+std::size_t holo::buddy_allocator::get_max_block_size() const
+{
+	return min_block_size << (order_count - 1);
+}
+
+std::size_t holo::buddy_allocator::get_order_count() const
+{
+	return order_count;
+}
+
+std::size_t holo::buddy_allocator::get_free_block_count(std::size_t order) const
+{
+	holo_assert(order < order_count);
+
+	return free_block_counts[order];
+}
+
+std::size_t holo::buddy_allocator::get_arena_count() const
+{
+	return arena_count;
+}
+
+void holo::buddy_allocator::set_statistics_enabled(bool enable)
+{
+	counter.set_enabled(enable);
+}
+
+void holo::buddy_allocator::get_statistics(holo::allocation_statistics* statistics) const
+{
+	counter.get_statistics(statistics);
+}
+
+std::size_t holo::buddy_allocator::get_order(std::size_t size, std::size_t alignment) const
+{
+	// Blocks are aligned on their size, so a stricter alignment only means a
+	// larger block.
+	std::size_t block_size = std::max(std::max(size, alignment), min_block_size);
+	if (block_size > get_max_block_size())
+	{
+		return order_count;
+	}
+
+	std::size_t block_shift = math::bit_log2((std::uint64_t)(block_size - 1)) + 1;
+	return block_shift - min_block_shift;
+}
+
+std::size_t holo::buddy_allocator::get_min_block_shift(
+	std::size_t arena_size,
+	std::size_t min_block_size)
+{
+	// Round up to a power of two, then clamp to a whole arena.
+	min_block_size = std::max(min_block_size, default_alignment);
+	std::size_t min_block_shift = math::bit_log2((std::uint64_t)(min_block_size - 1)) + 1;
+
+	return std::min(min_block_shift, (std::size_t)math::bit_log2((std::uint64_t)arena_size));
+}
+
+std::uint8_t* holo::buddy_allocator::get_states(arena_record* arena)
+{
+	return &states[arena_pool->get_arena_index(arena) * states_per_arena];
+}
+
+holo::buddy_allocator::arena_record* holo::buddy_allocator::get_block_arena(
+	void* pointer,
+	std::size_t* index)
+{
+	arena_record* arena = arena_pool->get_arena(pointer);
+	holo_assert(arena != nullptr && arena->allocator == this);
+
+	// The pointer may be anywhere within the block. A block of order 'n' is
+	// aligned on 2^n minimum blocks, so try each order in turn until the
+	// state at the rounded down index is an allocated block covering the
+	// pointer.
+	std::uint8_t* arena_states = get_states(arena);
+	std::size_t pointer_index = get_pointer_distance(pointer, arena->base) >> min_block_shift;
+	for (std::size_t order = 0; order < order_count; ++order)
+	{
+		std::size_t block_index = pointer_index & ~(((std::size_t)1 << order) - 1);
+		std::uint8_t state = arena_states[block_index];
+
+		if ((state & state_allocated) && (std::size_t)(state & state_order_mask) >= order)
+		{
+			*index = block_index;
+			return arena;
+		}
+	}
+
+	holo_assert(false);
+	*index = 0;
+
+	return arena;
+}
+
+void holo::buddy_allocator::insert_free_block(
+	arena_record* arena,
+	std::size_t index,
+	std::size_t order)
+{
+	free_block* block = (free_block*)((char*)arena->base + (index << min_block_shift));
+
+	block->previous = nullptr;
+	block->next = free_lists[order];
+	if (free_lists[order] != nullptr)
+	{
+		free_lists[order]->previous = block;
+	}
+	free_lists[order] = block;
+	++free_block_counts[order];
+
+	get_states(arena)[index] = state_free | (std::uint8_t)order;
+}
+
+void holo::buddy_allocator::remove_free_block(
+	arena_record* arena,
+	std::size_t index,
+	std::size_t order)
+{
+	free_block* block = (free_block*)((char*)arena->base + (index << min_block_shift));
+
+	if (free_lists[order] == block)
+	{
+		free_lists[order] = block->next;
+	}
+	intrusive_list::remove(block);
+	--free_block_counts[order];
+
+	get_states(arena)[index] = 0;
+}
+
+holo::buddy_allocator::arena_record* holo::buddy_allocator::request_empty_arena()
+{
+	arena_record* arena = arena_pool->take_arena();
+
+	if (arena != nullptr)
+	{
+		// Commit the states of every arena up to this one. The states of a
+		// released arena are all zero, so they can be reused as is.
+		std::size_t state_count = (arena_pool->get_arena_index(arena) + 1) * states_per_arena;
+		if (states.get_count() < state_count &&
+			states.append(state_count - states.get_count()) == nullptr)
+		{
+			arena_pool->give_arena(arena);
+
+			return nullptr;
+		}
+
+		arena->allocator = this;
+		arena->previous = nullptr;
+		arena->next = arena_list_head;
+		if (arena_list_head != nullptr)
+		{
+			arena_list_head->previous = arena;
+		}
+		arena_list_head = arena;
+
+		++arena_count;
+		counter.record_memory(
+			arena_count * arena_pool->get_arena_size(),
+			arena_count * arena_pool->get_arena_size());
+	}
+
+	return arena;
+}
+
+void holo::buddy_allocator::release_arena(arena_record* arena)
+{
+	if (arena_list_head == arena)
+	{
+		arena_list_head = arena->next;
+	}
+	intrusive_list::remove(arena);
+
+	arena_pool->give_arena(arena);
+
+	--arena_count;
+	counter.record_memory(
+		arena_count * arena_pool->get_arena_size(),
+		arena_count * arena_pool->get_arena_size());
+}
@@ -0,0 +1,208 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#ifndef HOLOGINE_CORE_MEMORY_BUDDY_ALLOCATOR_HPP_
+#define HOLOGINE_CORE_MEMORY_BUDDY_ALLOCATOR_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include "core/container/virtual_array.hpp"
+#include "core/memory/allocation_statistics.hpp"
+#include "core/memory/allocator.hpp"
+#include "core/memory/memory_arena_pool.hpp"
+
+namespace holo
+{
+	// Allocates power of two blocks from arenas using the buddy system.
+	//
+	// An arena starts out as a single free block. Allocations round up to the
+	// next power of two (the block's order), and larger free blocks are split
+	// in halves until a block of the right order remains. When a block is
+	// freed, it is merged with its buddy (the other half of the block it was
+	// split from) for as long as the buddy is free too; an arena that merges
+	// back into a single block is given back to the arena pool.
+	//
+	// Both allocation and deallocation take O(log n) steps, where n is the
+	// number of orders. Blocks are aligned on their own size.
+	//
+	// The order of every block is kept in a table outside the arenas, so
+	// blocks carry no header and a single allocation can take a whole arena.
+	//
+	// A buddy allocator is not thread safe.
+	class buddy_allocator final : public allocator
+	{
+		public:
+			// Constructs a buddy allocator backed by arenas from 'arena_pool'.
+			//
+			// 'min_block_size' is the size of the smallest block, and is rounded up
+			// to a power of two no smaller than the default alignment. It is
+			// clamped to the arena size. The largest block is a whole arena.
+			buddy_allocator(holo::memory_arena_pool* arena_pool, std::size_t min_block_size);
+
+			// Gives every arena back to the arena pool.
+			//
+			// Any memory allocated by this instance is no longer valid.
+			~buddy_allocator();
+
+			using holo::allocator::deallocate;
+
+			// Allocates a block of at least 'size' bytes, aligned on 'alignment'
+			// bytes.
+			//
+			// Returns the base of the block on success, NULL on failure. If 'size'
+			// or 'alignment' is larger than an arena, then
+			// holo::exception::invalid_argument is pushed. Otherwise, failure occurs
+			// if no more arenas could be taken from the arena pool.
+			void* allocate(std::size_t size, std::size_t alignment = default_alignment) override;
+
+			// Deallocates a block, merging it with its free buddies.
+			void deallocate(void* pointer) override;
+
+			// Deallocates a block of a known size.
+			//
+			// The order of the block is still looked up in order to merge it, so
+			// 'size' and 'alignment' are only checked.
+			void deallocate(void* pointer, std::size_t size, std::size_t alignment = default_alignment) override;
+
+			// Gets the number of bytes usable starting at 'pointer'.
+			//
+			// This is the remainder of the block past the pointer.
+			std::size_t get_usable_size(void* pointer) override;
+
+			// Gets the base of the allocated block containing 'pointer'.
+			//
+			// The pointer must have been allocated by this buddy allocator.
+			void* get_block(void* pointer);
+
+			// Gets the size of the smallest block.
+			std::size_t get_min_block_size() const;
+
+			// Gets the size of the largest block.
+			//
+			// This is the size of an arena.
+			std::size_t get_max_block_size() const;
+
+			// Gets the number of orders, i.e., distinct block sizes.
+			std::size_t get_order_count() const;
+
+			// Gets the number of free blocks of the provided order.
+			//
+			// The size of a block of order 'n' is the minimum block size times
+			// two to the power of 'n'.
+			std::size_t get_free_block_count(std::size_t order) const;
+
+			// Gets the number of arenas held by the allocator.
+			std::size_t get_arena_count() const;
+
+			// Enables or disables gathering allocation statistics.
+			//
+			// Statistics are disabled by default.
+			void set_statistics_enabled(bool enable);
+
+			// Takes a snapshot of the allocation statistics.
+			//
+			// Committed and reserved bytes count the arenas held by the allocator.
+			void get_statistics(holo::allocation_statistics* statistics) const;
+
+		private:
+			typedef holo::memory_arena_pool::arena_record arena_record;
+
+			// A free block, linked into the free list of its order.
+			struct free_block
+			{
+				// The next free block of the same order.
+				free_block* next;
+
+				// The previous free block of the same order.
+				free_block* previous;
+			};
+
+			// The maximum number of orders.
+			static const std::size_t maximum_order_count = 48;
+
+			// Marks the state of a free block.
+			static const std::uint8_t state_free = 0x80u;
+
+			// Marks the state of an allocated block.
+			static const std::uint8_t state_allocated = 0x40u;
+
+			// Masks the order out of a block state.
+			static const std::uint8_t state_order_mask = 0x3fu;
+
+			// Gets the order of the smallest block that fits 'size' bytes aligned
+			// on 'alignment' bytes.
+			//
+			// Returns holo::buddy_allocator::get_order_count() if no block fits.
+			std::size_t get_order(std::size_t size, std::size_t alignment) const;
+
+			// Gets the log2 of the minimum block size, rounded up to a power of two
+			// and clamped to 'arena_size'.
+			static std::size_t get_min_block_shift(std::size_t arena_size, std::size_t min_block_size);
+
+			// Gets the block states of an arena.
+			//
+			// There is one state per minimum block. The state of a block is stored
+			// at the index of its first minimum block; the other states it covers
+			// are zero.
+			std::uint8_t* get_states(arena_record* arena);
+
+			// Gets the arena of an allocated block, and the index of its state.
+			arena_record* get_block_arena(void* pointer, std::size_t* index);
+
+			// Pushes a block onto the free list of 'order' and marks it free.
+			void insert_free_block(arena_record* arena, std::size_t index, std::size_t order);
+
+			// Removes a block from the free list of 'order' and clears its state.
+			void remove_free_block(arena_record* arena, std::size_t index, std::size_t order);
+
+			// Takes a new arena from the arena pool.
+			//
+			// The whole arena is left as a single block of the largest order, not
+			// on any free list.
+			arena_record* request_empty_arena();
+
+			// Gives an arena back to the arena pool.
+			void release_arena(arena_record* arena);
+
+			// The arena pool.
+			holo::memory_arena_pool* arena_pool;
+
+			// The size of the smallest block.
+			std::size_t min_block_size;
+
+			// The log2 of the minimum block size.
+			std::size_t min_block_shift;
+
+			// The number of orders.
+			std::size_t order_count;
+
+			// The number of minimum blocks in an arena.
+			std::size_t states_per_arena;
+
+			// The state of each minimum block, indexed by arena.
+			holo::virtual_array<std::uint8_t> states;
+
+			// Free lists, one per order.
+			free_block* free_lists[maximum_order_count];
+
+			// Number of blocks on each free list.
+			std::size_t free_block_counts[maximum_order_count];
+
+			// The arenas held by the allocator.
+			arena_record* arena_list_head;
+
+			// The number of arenas held by the allocator.
+			std::size_t arena_count;
+
+			// Allocation statistics.
+			holo::allocation_counter counter;
+	};
+}
+
+#endif
@@ -0,0 +1,285 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include <algorithm>
+#include "core/exception.hpp"
+#include "core/memory/caching_allocator_proxy.hpp"
+#include "core/threading/scoped_lock.hpp"
+
+const std::size_t holo::caching_allocator_proxy::max_transfer_count;
+
+holo::caching_allocator_proxy::caching_allocator_proxy(
+	holo::heap_allocator* heap_allocator,
+	std::size_t batch_size) :
+		heap_allocator(heap_allocator),
+		batch_size(batch_size),
+		thread_cache_list(nullptr)
+{
+	holo_assert(heap_allocator != nullptr);
+}
+
+holo::caching_allocator_proxy::~caching_allocator_proxy()
+{
+	holo::scoped_lock lock(mutex);
+
+	while (thread_cache_list != nullptr)
+	{
+		destroy_thread_cache(thread_cache_list);
+	}
+}
+
+void* holo::caching_allocator_proxy::allocate(std::size_t size, std::size_t alignment)
+{
+	// Blocks in a size class are only guaranteed to be aligned to the default
+	// alignment. Stricter alignments are passed through.
+	std::size_t size_class = heap_allocator->get_size_class(size);
+	if (alignment <= default_alignment && size_class < heap_allocator->get_size_class_count())
+	{
+		thread_cache* cache = get_thread_cache();
+
+		if (cache != nullptr)
+		{
+			magazine* magazine = &cache->magazines[size_class];
+
+			if (magazine->count == 0 && !refill(magazine, size_class))
+			{
+				return nullptr;
+			}
+
+			cached_block* block = magazine->blocks;
+			magazine->blocks = block->next;
+			--magazine->count;
+
+			return block;
+		}
+	}
+
+	holo::scoped_lock lock(mutex);
+
+	return heap_allocator->allocate(size, alignment);
+}
+
+void holo::caching_allocator_proxy::deallocate(void* pointer)
+{
+	thread_cache* cache = get_thread_cache();
+	if (cache == nullptr)
+	{
+		holo::scoped_lock lock(mutex);
+		heap_allocator->deallocate(pointer);
+
+		return;
+	}
+
+	// The pointer may be offset from the base of the block if it was allocated
+	// with a strict alignment; cache the base.
+	std::size_t size_class;
+	cached_block* block = (cached_block*)heap_allocator->get_block(pointer, &size_class);
+
+	// Large allocations aren't cached.
+	if (block == nullptr)
+	{
+		holo::scoped_lock lock(mutex);
+		heap_allocator->deallocate(pointer);
+
+		return;
+	}
+
+	cache_block(cache, block, size_class);
+}
+
+void holo::caching_allocator_proxy::deallocate(void* pointer, std::size_t size, std::size_t alignment)
+{
+	// Blocks allocated with a default alignment begin at the block base, so the
+	// pointer can be cached as is.
+	std::size_t size_class = heap_allocator->get_size_class(size);
+	if (alignment <= default_alignment && size_class < heap_allocator->get_size_class_count())
+	{
+		thread_cache* cache = get_thread_cache();
+
+		if (cache != nullptr)
+		{
+			cache_block(cache, (cached_block*)pointer, size_class);
+
+			return;
+		}
+	}
+
+	holo::scoped_lock lock(mutex);
+
+	heap_allocator->deallocate(pointer, size, alignment);
+}
+
+std::size_t holo::caching_allocator_proxy::get_usable_size(void* pointer)
+{
+	// Size class pools are fixed once the heap is constructed and large
+	// allocation headers are only touched by their owner.
+	return heap_allocator->get_usable_size(pointer);
+}
+
+void holo::caching_allocator_proxy::release_thread_cache()
+{
+	thread_cache* cache = thread_caches;
+
+	if (cache != nullptr)
+	{
+		thread_caches = nullptr;
+
+		holo::scoped_lock lock(mutex);
+		destroy_thread_cache(cache);
+	}
+}
+
+std::size_t holo::caching_allocator_proxy::get_cached_count(std::size_t size_class) const
+{
+	holo_assert(size_class < heap_allocator->get_size_class_count());
+
+	thread_cache* cache = thread_caches;
+	if (cache == nullptr)
+	{
+		return 0;
+	}
+
+	return cache->magazines[size_class].count;
+}
+
+holo::caching_allocator_proxy::thread_cache* holo::caching_allocator_proxy::get_thread_cache()
+{
+	thread_cache* cache = thread_caches;
+
+	if (cache == nullptr && thread_caches.is_valid())
+	{
+		std::size_t size_class_count = heap_allocator->get_size_class_count();
+		std::size_t cache_size =
+			sizeof(thread_cache) + (size_class_count - 1) * sizeof(magazine);
+
+		holo::scoped_lock lock(mutex);
+
+		cache = (thread_cache*)heap_allocator->allocate(cache_size);
+		if (cache != nullptr)
+		{
+			for (std::size_t i = 0; i < size_class_count; ++i)
+			{
+				cache->magazines[i].blocks = nullptr;
+				cache->magazines[i].count = 0;
+			}
+
+			cache->previous = nullptr;
+			cache->next = thread_cache_list;
+			if (thread_cache_list != nullptr)
+			{
+				thread_cache_list->previous = cache;
+			}
+			thread_cache_list = cache;
+
+			thread_caches = cache;
+		}
+	}
+
+	return cache;
+}
+
+std::size_t holo::caching_allocator_proxy::get_batch_count(std::size_t size_class) const
+{
+	return std::max(batch_size / heap_allocator->get_size_class_size(size_class), (std::size_t)1);
+}
+
+bool holo::caching_allocator_proxy::refill(magazine* magazine, std::size_t size_class)
+{
+	std::size_t batch_count = get_batch_count(size_class);
+	std::size_t block_size = heap_allocator->get_size_class_size(size_class);
+
+	holo::scoped_lock lock(mutex);
+
+	void* blocks[max_transfer_count];
+	while (magazine->count < batch_count)
+	{
+		std::size_t count = std::min(batch_count - magazine->count, max_transfer_count);
+		std::size_t allocated = heap_allocator->allocate_batch(block_size, count, blocks);
+
+		for (std::size_t i = 0; i < allocated; ++i)
+		{
+			cached_block* block = (cached_block*)blocks[i];
+			block->next = magazine->blocks;
+			magazine->blocks = block;
+		}
+		magazine->count += allocated;
+
+		if (allocated < count)
+		{
+			// A partial batch is still good enough.
+			break;
+		}
+	}
+
+	return magazine->count > 0;
+}
+
+void holo::caching_allocator_proxy::flush(magazine* magazine, std::size_t count)
+{
+	void* blocks[max_transfer_count];
+	while (count > 0 && magazine->blocks != nullptr)
+	{
+		std::size_t flushed = 0;
+		while (flushed < count && flushed < max_transfer_count && magazine->blocks != nullptr)
+		{
+			cached_block* block = magazine->blocks;
+			magazine->blocks = block->next;
+
+			blocks[flushed] = block;
+			++flushed;
+		}
+		magazine->count -= flushed;
+		count -= flushed;
+
+		heap_allocator->deallocate_batch(blocks, flushed);
+	}
+}
+
+void holo::caching_allocator_proxy::cache_block(
+	thread_cache* cache, cached_block* block, std::size_t size_class)
+{
+	magazine* magazine = &cache->magazines[size_class];
+	block->next = magazine->blocks;
+	magazine->blocks = block;
+	++magazine->count;
+
+	// Keep the magazine between one and two batches large, so a thread that
+	// alternates between allocating and freeing doesn't thrash the lock.
+	std::size_t batch_count = get_batch_count(size_class);
+	if (magazine->count > batch_count * 2)
+	{
+		holo::scoped_lock lock(mutex);
+		flush(magazine, batch_count);
+	}
+}
+
+void holo::caching_allocator_proxy::destroy_thread_cache(thread_cache* cache)
+{
+	std::size_t size_class_count = heap_allocator->get_size_class_count();
+	for (std::size_t i = 0; i < size_class_count; ++i)
+	{
+		flush(&cache->magazines[i], cache->magazines[i].count);
+	}
+
+	if (cache->previous != nullptr)
+	{
+		cache->previous->next = cache->next;
+	}
+	else
+	{
+		thread_cache_list = cache->next;
+	}
+
+	if (cache->next != nullptr)
+	{
+		cache->next->previous = cache->previous;
+	}
+
+	heap_allocator->deallocate(cache);
+}
@@ -0,0 +1,173 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#ifndef HOLOGINE_CORE_MEMORY_CACHING_ALLOCATOR_PROXY_HPP_
+#define HOLOGINE_CORE_MEMORY_CACHING_ALLOCATOR_PROXY_HPP_
+
+#include <cstddef>
+#include "core/memory/allocator.hpp"
+#include "core/memory/heap_allocator.hpp"
+#include "core/threading/mutex.hpp"
+#include "core/threading/thread_local_variable.hpp"
+
+namespace holo
+{
+	// A thread-safe front end to a holo::heap_allocator that caches blocks
+	// per thread.
+	//
+	// Each thread keeps a small magazine of free blocks for every size class of
+	// the heap. Allocations and deallocations that fit in a size class are
+	// served from the calling thread's magazine without taking a lock. When a
+	// magazine runs dry, it is refilled with a batch of blocks from the heap;
+	// when it grows too large, a batch is flushed back. Only these batch
+	// operations, and allocations too large or too strictly aligned for the
+	// cache, lock the heap.
+	//
+	// Blocks may be freed on a thread other than the one that allocated them;
+	// they simply end up in the freeing thread's cache.
+	//
+	// The heap allocator must not be used directly while the proxy exists,
+	// since the proxy's lock does not protect such access.
+	class caching_allocator_proxy final : public allocator
+	{
+		public:
+			// Constructs a caching proxy to the provided heap allocator.
+			//
+			// 'batch_size' is the number of bytes moved between a magazine and the
+			// heap at a time. Each magazine holds at most twice this amount (and
+			// always at least one block).
+			caching_allocator_proxy(holo::heap_allocator* heap_allocator, std::size_t batch_size = 0x4000u);
+
+			// Returns the blocks held by every thread's cache to the heap.
+			//
+			// No thread may use the proxy during or after destruction.
+			~caching_allocator_proxy();
+
+			// Implementation.
+			void* allocate(std::size_t size, std::size_t alignment = default_alignment) override;
+
+			// Implementation.
+			void deallocate(void* pointer) override;
+
+			// Implementation.
+			//
+			// Blocks allocated with the default alignment are pushed on to the
+			// magazine of the size class computed from 'size', without looking up
+			// the block.
+			void deallocate(void* pointer, std::size_t size, std::size_t alignment = default_alignment) override;
+
+			// Implementation.
+			//
+			// The heap allocator can answer this without claiming the mutex.
+			std::size_t get_usable_size(void* pointer) override;
+
+			// Returns the blocks cached by the calling thread to the heap and
+			// releases the thread's cache.
+			//
+			// A thread should call this before it exits; otherwise its cached blocks
+			// are only reclaimed when the proxy is destroyed. The thread can keep
+			// using the proxy afterwards, in which case a new cache is created.
+			void release_thread_cache();
+
+			// Gets the number of blocks of a size class cached by the calling
+			// thread.
+			//
+			// 'size_class' is a size class of the heap; see
+			// holo::heap_allocator::get_size_class(std::size_t, std::size_t).
+			std::size_t get_cached_count(std::size_t size_class) const;
+
+		private:
+			// Most blocks moved between a magazine and the heap by a single batch
+			// call.
+			static const std::size_t max_transfer_count = 0x40u;
+
+			// A free block in a magazine.
+			struct cached_block
+			{
+				cached_block* next;
+			};
+
+			// Free blocks of a single size class.
+			struct magazine
+			{
+				// Singly linked list of free blocks, most recently freed first.
+				cached_block* blocks;
+
+				// Number of blocks in the list.
+				std::size_t count;
+			};
+
+			// The cache of a single thread.
+			struct thread_cache
+			{
+				// Next cache in the list of all caches.
+				thread_cache* next;
+
+				// Previous cache in the list of all caches.
+				thread_cache* previous;
+
+				// Magazines, one per size class of the heap.
+				//
+				// The array is allocated along with the cache and is actually
+				// holo::heap_allocator::get_size_class_count() elements long.
+				magazine magazines[1];
+			};
+
+			// Gets the calling thread's cache, creating it if necessary.
+			//
+			// Returns NULL if the cache could not be created.
+			thread_cache* get_thread_cache();
+
+			// Gets the number of blocks moved between a magazine and the heap at a
+			// time for the provided size class.
+			std::size_t get_batch_count(std::size_t size_class) const;
+
+			// Refills an empty magazine with a batch of blocks from the heap.
+			//
+			// Blocks are taken with holo::heap_allocator::allocate_batch(), at
+			// most max_transfer_count at a time.
+			//
+			// Returns false if not a single block could be allocated.
+			bool refill(magazine* magazine, std::size_t size_class);
+
+			// Returns up to 'count' blocks from the magazine to the heap.
+			//
+			// Blocks are returned with holo::heap_allocator::deallocate_batch(),
+			// at most max_transfer_count at a time. The heap lock must be held.
+			void flush(magazine* magazine, std::size_t count);
+
+			// Pushes a block on to the magazine of its size class, flushing a batch
+			// if the magazine grows too large.
+			void cache_block(thread_cache* cache, cached_block* block, std::size_t size_class);
+
+			// Returns every block in the cache to the heap, unlinks it, and frees
+			// it.
+			//
+			// The heap lock must be held.
+			void destroy_thread_cache(thread_cache* cache);
+
+			// The underlying heap.
+			holo::heap_allocator* heap_allocator;
+
+			// Number of bytes moved between a magazine and the heap at once.
+			std::size_t batch_size;
+
+			// The calling thread's cache.
+			holo::thread_local_variable<thread_cache> thread_caches;
+
+			// List of all thread caches, so they can be reclaimed when the proxy is
+			// destroyed.
+			thread_cache* thread_cache_list;
+
+			// Protects the heap and the list of caches.
+			holo::mutex mutex;
+	};
+}
+
+#endif
@@ -0,0 +1,394 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include <cstring>
+#include "core/exception.hpp"
+#include "core/container/intrusive_list.hpp"
+#include "core/math/util.hpp"
+#include "core/memory/allocator.hpp"
+#include "core/memory/compacting_pool.hpp"
+
+const std::size_t holo::compacting_pool::handle_type;
+const std::uint32_t holo::compacting_pool::free_slot_flag;
+const std::uint32_t holo::compacting_pool::no_slot;
+
+holo::compacting_pool::compacting_pool(
+	holo::memory_arena_pool* arena_pool,
+	std::size_t object_size,
+	std::size_t max_object_count,
+	move_callback move,
+	void* userdata) :
+		arena_pool(arena_pool),
+		object_size(math::round_up(object_size, holo::allocator::default_alignment)),
+		object_count(0),
+		owners_offset(0),
+		header_offset(0),
+		move(move),
+		userdata(userdata),
+		table(max_object_count),
+		first_free_entry(no_slot),
+		arena_list_head(nullptr),
+		arena_count(0),
+		live_count(0),
+		counter()
+{
+	holo_assert(arena_pool != nullptr);
+	holo_assert(object_size > 0);
+	holo_assert(max_object_count < no_slot);
+	holo_assert(max_object_count <= handle_definition::max_index);
+
+	// Each slot costs the object plus its owner; the header goes at the very
+	// end of the arena.
+	std::size_t arena_size = arena_pool->get_arena_size();
+	header_offset = arena_size - sizeof(arena_header);
+	object_count = header_offset / (this->object_size + sizeof(std::uint32_t));
+	owners_offset = header_offset - object_count * sizeof(std::uint32_t);
+
+	holo_assert(object_count > 0);
+	holo_assert(object_count < no_slot);
+}
+
+holo::compacting_pool::~compacting_pool()
+{
+	arena_record* current = arena_list_head;
+
+	while (current != nullptr)
+	{
+		arena_record* next = current->next;
+
+		arena_pool->give_arena(current);
+
+		current = next;
+	}
+}
+
+holo::handle holo::compacting_pool::allocate()
+{
+	// Find a table entry first; it's cheaper to back out of.
+	std::uint32_t entry_index;
+	if (first_free_entry != no_slot)
+	{
+		entry_index = first_free_entry;
+	}
+	else if (table.get_count() < table.get_max_count())
+	{
+		entry_index = (std::uint32_t)table.get_count();
+
+		table_entry entry;
+		entry.object = nullptr;
+		entry.age = 1;
+		entry.next_free_entry = no_slot;
+
+		if (table.push_back(entry) == nullptr)
+		{
+			return 0;
+		}
+
+		first_free_entry = entry_index;
+	}
+	else
+	{
+		push_exception(exception::out_of_memory);
+
+		return 0;
+	}
+
+	// Filling the densest arena first leaves sparse arenas to drain.
+	arena_record* arena = get_densest_free_arena(nullptr);
+	if (arena == nullptr)
+	{
+		arena = request_empty_arena();
+
+		if (arena == nullptr)
+		{
+			return 0;
+		}
+	}
+
+	table_entry& entry = table[entry_index];
+	first_free_entry = entry.next_free_entry;
+	entry.object = take_slot(arena, entry_index);
+
+	++live_count;
+	counter.record_allocation(object_size, object_size);
+
+	return handle_definition::encode(entry.age, 0, entry_index);
+}
+
+void holo::compacting_pool::deallocate(holo::handle handle)
+{
+	void* object = get(handle);
+	holo_assert(object != nullptr);
+
+	if (object == nullptr)
+	{
+		return;
+	}
+
+	std::uint32_t entry_index = (std::uint32_t)handle_definition::decode_index(handle);
+	table_entry& entry = table[entry_index];
+
+	entry.object = nullptr;
+	entry.age = (std::uint32_t)handle_definition::increment_age(entry.age);
+	entry.next_free_entry = first_free_entry;
+	first_free_entry = entry_index;
+
+	release_slot(arena_pool->get_arena(object), object);
+
+	--live_count;
+	counter.record_deallocation(object_size);
+}
+
+void* holo::compacting_pool::get(holo::handle handle) const
+{
+	if (!handle_definition::is_type(handle))
+	{
+		return nullptr;
+	}
+
+	std::size_t index = handle_definition::decode_index(handle);
+	if (index >= table.get_count())
+	{
+		return nullptr;
+	}
+
+	const table_entry& entry = table[index];
+	if (entry.object == nullptr || entry.age != handle_definition::decode_age(handle))
+	{
+		return nullptr;
+	}
+
+	return entry.object;
+}
+
+bool holo::compacting_pool::is_valid(holo::handle handle) const
+{
+	return get(handle) != nullptr;
+}
+
+std::size_t holo::compacting_pool::defragment(std::size_t max_move_count)
+{
+	std::size_t moved = 0;
+
+	while (moved < max_move_count)
+	{
+		// Pick the sparsest arena as the source, and total up the room in the
+		// other arenas.
+		arena_record* source = nullptr;
+		std::size_t free_count = 0;
+		for (arena_record* i = arena_list_head; i != nullptr; i = i->next)
+		{
+			free_count += i->free_node_count;
+
+			if (source == nullptr || i->free_node_count > source->free_node_count)
+			{
+				source = i;
+			}
+		}
+
+		if (source == nullptr)
+		{
+			break;
+		}
+
+		// Moving objects only pays off if the source can be emptied entirely.
+		std::size_t source_live_count = object_count - source->free_node_count;
+		if (free_count - source->free_node_count < source_live_count)
+		{
+			break;
+		}
+
+		std::uint32_t* owners = get_owners(source);
+		for (std::size_t slot = 0; slot < object_count && moved < max_move_count; ++slot)
+		{
+			if (owners[slot] & free_slot_flag)
+			{
+				continue;
+			}
+
+			arena_record* destination = get_densest_free_arena(source);
+			holo_assert(destination != nullptr);
+
+			std::uint32_t entry_index = owners[slot];
+			table_entry& entry = table[entry_index];
+
+			void* object = take_slot(destination, entry_index);
+			if (move != nullptr)
+			{
+				move(object, entry.object, userdata);
+			}
+			else
+			{
+				std::memcpy(object, entry.object, object_size);
+			}
+
+			void* previous_object = entry.object;
+			entry.object = object;
+			++moved;
+
+			// The last release gives the arena back, so stop touching it then.
+			bool is_last = source->free_node_count + 1 == object_count;
+			release_slot(source, previous_object);
+
+			if (is_last)
+			{
+				break;
+			}
+		}
+	}
+
+	return moved;
+}
+
+std::size_t holo::compacting_pool::get_object_size() const
+{
+	return object_size;
+}
+
+std::size_t holo::compacting_pool::get_object_count() const
+{
+	return object_count;
+}
+
+std::size_t holo::compacting_pool::get_live_count() const
+{
+	return live_count;
+}
+
+std::size_t holo::compacting_pool::get_arena_count() const
+{
+	return arena_count;
+}
+
+void holo::compacting_pool::set_statistics_enabled(bool enable)
+{
+	counter.set_enabled(enable);
+}
+
+void holo::compacting_pool::get_statistics(holo::allocation_statistics* statistics) const
+{
+	counter.get_statistics(statistics);
+}
+
+holo::compacting_pool::arena_header* holo::compacting_pool::get_header(arena_record* arena) const
+{
+	return (arena_header*)((char*)arena->base + header_offset);
+}
+
+std::uint32_t* holo::compacting_pool::get_owners(arena_record* arena) const
+{
+	return (std::uint32_t*)((char*)arena->base + owners_offset);
+}
+
+void* holo::compacting_pool::get_slot(arena_record* arena, std::size_t slot) const
+{
+	return (char*)arena->base + slot * object_size;
+}
+
+holo::compacting_pool::arena_record* holo::compacting_pool::get_densest_free_arena(
+	arena_record* exclude) const
+{
+	arena_record* densest = nullptr;
+
+	for (arena_record* i = arena_list_head; i != nullptr; i = i->next)
+	{
+		if (i == exclude || i->free_node_count == 0)
+		{
+			continue;
+		}
+
+		if (densest == nullptr || i->free_node_count < densest->free_node_count)
+		{
+			densest = i;
+		}
+	}
+
+	return densest;
+}
+
+void* holo::compacting_pool::take_slot(arena_record* arena, std::uint32_t entry_index)
+{
+	arena_header* header = get_header(arena);
+	std::uint32_t* owners = get_owners(arena);
+
+	std::uint32_t slot = header->first_free_slot;
+	holo_assert(slot != no_slot);
+	holo_assert(owners[slot] & free_slot_flag);
+
+	header->first_free_slot = owners[slot] & ~free_slot_flag;
+	owners[slot] = entry_index;
+	--arena->free_node_count;
+
+	return get_slot(arena, slot);
+}
+
+void holo::compacting_pool::release_slot(arena_record* arena, void* object)
+{
+	holo_assert(arena != nullptr);
+
+	std::uint32_t slot = (std::uint32_t)(((char*)object - (char*)arena->base) / object_size);
+	std::uint32_t* owners = get_owners(arena);
+	holo_assert(!(owners[slot] & free_slot_flag));
+
+	arena_header* header = get_header(arena);
+	owners[slot] = free_slot_flag | header->first_free_slot;
+	header->first_free_slot = slot;
+	++arena->free_node_count;
+
+	if (arena->free_node_count == object_count)
+	{
+		if (arena_list_head == arena)
+		{
+			arena_list_head = arena->next;
+		}
+		intrusive_list::remove(arena);
+
+		arena_pool->give_arena(arena);
+
+		--arena_count;
+		counter.record_memory(
+			arena_count * arena_pool->get_arena_size(),
+			arena_count * arena_pool->get_arena_size());
+	}
+}
+
+holo::compacting_pool::arena_record* holo::compacting_pool::request_empty_arena()
+{
+	arena_record* arena = arena_pool->take_arena();
+
+	if (arena != nullptr)
+	{
+		arena->free_node_count = object_count;
+
+		// Thread every slot onto the free list, lowest first.
+		std::uint32_t* owners = get_owners(arena);
+		for (std::size_t i = 0; i < object_count; ++i)
+		{
+			owners[i] = free_slot_flag | (std::uint32_t)(i + 1);
+		}
+		owners[object_count - 1] = free_slot_flag | no_slot;
+
+		get_header(arena)->first_free_slot = 0;
+
+		arena->previous = nullptr;
+		arena->next = arena_list_head;
+		if (arena_list_head != nullptr)
+		{
+			arena_list_head->previous = arena;
+		}
+		arena_list_head = arena;
+
+		++arena_count;
+		counter.record_memory(
+			arena_count * arena_pool->get_arena_size(),
+			arena_count * arena_pool->get_arena_size());
+	}
+
+	return arena;
+}
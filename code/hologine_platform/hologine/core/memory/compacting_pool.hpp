@@ -0,0 +1,228 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#ifndef HOLOGINE_CORE_MEMORY_COMPACTING_POOL_HPP_
+#define HOLOGINE_CORE_MEMORY_COMPACTING_POOL_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include "core/handle.hpp"
+#include "core/container/virtual_array.hpp"
+#include "core/memory/allocation_statistics.hpp"
+#include "core/memory/memory_arena_pool.hpp"
+
+namespace holo
+{
+	// A pool of uniformly sized objects that can be compacted.
+	//
+	// Objects in a compacting pool are referenced by holo::handle rather than by
+	// pointer. A handle indexes an indirection table holding the current address
+	// of the object, so the pool is free to move objects around. Over time, a
+	// plain holo::pool_allocator can end up with many mostly empty arenas, each
+	// pinned by a handful of long-lived objects; the compacting pool instead
+	// moves objects out of sparse arenas and into denser ones, then gives the
+	// emptied arenas back to the holo::memory_arena_pool.
+	//
+	// Compaction is incremental: each call to
+	// holo::compacting_pool::defragment(std::size_t) moves a bounded number of
+	// objects, so it can be spread over several frames.
+	//
+	// Objects are moved with memcpy, unless a move callback is provided.
+	// Pointers obtained from holo::compacting_pool::get(holo::handle) are only
+	// valid until the next defragmentation step.
+	//
+	// A compacting pool is not thread safe.
+	class compacting_pool
+	{
+		compacting_pool(const compacting_pool&) = delete;
+		compacting_pool& operator =(const compacting_pool&) = delete;
+
+		public:
+			// The handle type of objects in a compacting pool.
+			static const std::size_t handle_type = 0x01;
+
+			// Encodes handles to objects in a compacting pool.
+			//
+			// Scope is unused; the index refers to the indirection table.
+			typedef holo::handle_definition<handle_type, 25, 0, 31> handle_definition;
+
+			// Moves an object from 'source' to 'destination'.
+			//
+			// The object at 'source' is no longer live afterwards.
+			typedef void (* move_callback)(void* destination, void* source, void* userdata);
+
+			// Constructs a compacting pool for up to 'max_object_count' objects of
+			// 'object_size' bytes each, backed by arenas from 'arena_pool'.
+			//
+			// 'object_size' is rounded up to the default alignment. If 'move' is
+			// not NULL, it is invoked with 'userdata' to move objects; otherwise,
+			// objects are assumed to be trivially relocatable.
+			compacting_pool(
+				holo::memory_arena_pool* arena_pool,
+				std::size_t object_size,
+				std::size_t max_object_count,
+				move_callback move = nullptr,
+				void* userdata = nullptr);
+
+			// Returns every arena to the arena pool.
+			~compacting_pool();
+
+			// Allocates an object.
+			//
+			// Returns a handle to the object, or zero on failure. Failure occurs if
+			// the maximum number of objects are live or no more arenas can be taken
+			// from the arena pool.
+			holo::handle allocate();
+
+			// Deallocates the object referenced by 'handle'.
+			//
+			// The handle, and any copies of it, are then stale.
+			void deallocate(holo::handle handle);
+
+			// Gets the current address of the object referenced by 'handle'.
+			//
+			// Returns NULL if the handle is stale or does not belong to a compacting
+			// pool.
+			void* get(holo::handle handle) const;
+
+			// Gets if 'handle' references a live object.
+			bool is_valid(holo::handle handle) const;
+
+			// Performs one incremental step of compaction, moving at most
+			// 'max_move_count' objects.
+			//
+			// Objects are moved out of the sparsest arena into the densest arenas
+			// with room. A sparse arena is only drained if the other arenas have
+			// room for all of its objects, and once drained it is given back to the
+			// arena pool.
+			//
+			// Returns the number of objects moved. Zero means the pool cannot be
+			// compacted any further.
+			std::size_t defragment(std::size_t max_move_count);
+
+			// Gets the size of an object.
+			std::size_t get_object_size() const;
+
+			// Gets the maximum number of objects that fit in an arena.
+			std::size_t get_object_count() const;
+
+			// Gets the number of live objects.
+			std::size_t get_live_count() const;
+
+			// Gets the number of arenas held by the pool.
+			std::size_t get_arena_count() const;
+
+			// Enables or disables gathering allocation statistics.
+			//
+			// Statistics are disabled by default.
+			void set_statistics_enabled(bool enable);
+
+			// Takes a snapshot of the allocation statistics.
+			//
+			// Committed and reserved bytes count the arenas held by the pool.
+			void get_statistics(holo::allocation_statistics* statistics) const;
+
+		private:
+			typedef holo::memory_arena_pool::arena_record arena_record;
+
+			// An entry of the indirection table.
+			struct table_entry
+			{
+				// Current address of the object, or NULL if the entry is free.
+				void* object;
+
+				// Age of the entry, bumped when the object is deallocated.
+				std::uint32_t age;
+
+				// Index of the next free entry, if the entry is free.
+				std::uint32_t next_free_entry;
+			};
+
+			// Bookkeeping stored at the end of every arena, after the slot owners.
+			struct arena_header
+			{
+				// Index of the first free slot, or 'no_slot' if the arena is full.
+				std::uint32_t first_free_slot;
+			};
+
+			// Marks a free slot in the slot owner array. The rest of the value is
+			// the index of the next free slot.
+			static const std::uint32_t free_slot_flag = 0x80000000u;
+
+			// Marks the end of a free list.
+			static const std::uint32_t no_slot = 0x7fffffffu;
+
+			// Gets the header of an arena.
+			arena_header* get_header(arena_record* arena) const;
+
+			// Gets the slot owner array of an arena.
+			//
+			// Each live slot stores the index of its table entry.
+			std::uint32_t* get_owners(arena_record* arena) const;
+
+			// Gets the address of a slot in an arena.
+			void* get_slot(arena_record* arena, std::size_t slot) const;
+
+			// Gets the densest arena with a free slot, other than 'exclude'.
+			//
+			// Returns NULL if there is no such arena.
+			arena_record* get_densest_free_arena(arena_record* exclude) const;
+
+			// Takes a free slot from 'arena' for the table entry 'entry_index'.
+			void* take_slot(arena_record* arena, std::uint32_t entry_index);
+
+			// Frees the slot holding 'object'.
+			//
+			// If this empties the arena, it is given back to the arena pool.
+			void release_slot(arena_record* arena, void* object);
+
+			// Takes a new arena from the arena pool.
+			arena_record* request_empty_arena();
+
+			// The arena pool.
+			holo::memory_arena_pool* arena_pool;
+
+			// The size of an object.
+			std::size_t object_size;
+
+			// The number of objects per arena.
+			std::size_t object_count;
+
+			// Offset of the slot owner array from the base of an arena.
+			std::size_t owners_offset;
+
+			// Offset of the arena header from the base of an arena.
+			std::size_t header_offset;
+
+			// The move callback and its userdata.
+			move_callback move;
+			void* userdata;
+
+			// The indirection table.
+			holo::virtual_array<table_entry> table;
+
+			// Index of the first free table entry, or 'no_slot' if every entry is
+			// in use.
+			std::uint32_t first_free_entry;
+
+			// The arenas held by the pool.
+			arena_record* arena_list_head;
+
+			// The number of arenas held by the pool.
+			std::size_t arena_count;
+
+			// The number of live objects.
+			std::size_t live_count;
+
+			// Allocation statistics.
+			holo::allocation_counter counter;
+	};
+}
+
+#endif
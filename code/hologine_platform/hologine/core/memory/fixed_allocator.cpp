@@ -7,6 +7,7 @@
 //
 // For licensing information, review the LICENSE file located at the root
 // directory of the source package.
+#include <utility>
 #include "core/math/util.hpp"
 #include "core/memory/fixed_allocator.hpp"
 #include "core/memory/memory_region.hpp"
@@ -15,10 +16,21 @@ holo::fixed_allocator::fixed_allocator(
 	std::size_t size,
 	std::size_t object_size,
 	std::size_t alignment) :
-		memory_region(size),
+		fixed_allocator(holo::memory_region(size), object_size, alignment)
+{
+	// Nothing.
+}
+
+holo::fixed_allocator::fixed_allocator(
+	holo::memory_region&& region,
+	std::size_t object_size,
+	std::size_t alignment) :
+		memory_region(std::move(region)),
 		memory(nullptr),
 		free_nodes(nullptr),
-		object_size(object_size)
+		node_size(0),
+		object_size(object_size),
+		counter()
 {
 	holo_assert(object_size >= sizeof(free_node));
 
@@ -47,24 +59,29 @@ holo::fixed_allocator::fixed_allocator(
 		// Determine how much space is available for nodes.
 		std::size_t max_size = memory_region.get_current_size();
 		std::size_t node_span_size = max_size - get_pointer_distance(memory, base_memory);
-		std::size_t node_count = node_span_size / node_count;
+		std::size_t node_count = node_span_size / node_size;
 
-		// Reserve 'node_count' nodes, starting backwards.
+		// Build the free list backwards.
 		//
 		// Remember, the free node list is in order of most recent to least recent.
 		// A naive forward iteration would put the nodes at the end of the region
 		// which could potentially be counterproductive if nodes are used linearly,
 		// from low to high.
-		char* current_node = (char*)memory + (node_count - 1) * node_size;
-		while (current_node > base_memory)
+		for (std::size_t i = node_count; i > 0; --i)
 		{
-			// holo::fixed_allocator::deallocate will happily convert any pointer to
-			// a free node. Make use of that behavior.
-			deallocate(current_node);
+			free_node* node = (free_node*)((char*)memory + (i - 1) * node_size);
 
-			current_node -= node_size;
+			node->next = free_nodes;
+			free_nodes = node;
 		}
 	}
+
+	counter.record_memory(memory_region.get_current_size(), memory_region.get_reserved_size());
+}
+
+holo::fixed_allocator::~fixed_allocator()
+{
+	// Nothing.
 }
 
 void* holo::fixed_allocator::allocate(std::size_t size, std::size_t)
@@ -81,6 +98,8 @@ void* holo::fixed_allocator::allocate(std::size_t size, std::size_t)
 	if (current_free_node != nullptr)
 	{
 		free_nodes = current_free_node->next;
+
+		counter.record_allocation(size, node_size);
 	}
 	else
 	{
@@ -98,4 +117,85 @@ void holo::fixed_allocator::deallocate(void* pointer)
 
 	new_free_node->next = free_nodes;
 	free_nodes = new_free_node;
+
+	counter.record_deallocation(node_size);
+}
+
+std::size_t holo::fixed_allocator::get_usable_size(void*)
+{
+	return node_size;
+}
+
+std::size_t holo::fixed_allocator::allocate_batch(
+	std::size_t size,
+	std::size_t count,
+	void** pointers,
+	std::size_t)
+{
+	if (size > object_size)
+	{
+		push_exception(exception::invalid_argument);
+
+		return 0;
+	}
+
+	std::size_t allocated = 0;
+	free_node* current_free_node = free_nodes;
+
+	while (allocated < count && current_free_node != nullptr)
+	{
+		pointers[allocated++] = current_free_node;
+		current_free_node = current_free_node->next;
+	}
+
+	free_nodes = current_free_node;
+
+	if (allocated < count)
+	{
+		push_exception(exception::out_of_memory);
+	}
+
+	counter.record_allocation(size * allocated, node_size * allocated, allocated);
+
+	return allocated;
+}
+
+void holo::fixed_allocator::deallocate_batch(void** pointers, std::size_t count)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	// Chain the objects together, in order, then make them the head of the
+	// free list.
+	for (std::size_t i = 0; i < count - 1; ++i)
+	{
+		((free_node*)pointers[i])->next = (free_node*)pointers[i + 1];
+	}
+
+	((free_node*)pointers[count - 1])->next = free_nodes;
+	free_nodes = (free_node*)pointers[0];
+
+	counter.record_deallocation(node_size * count, count);
+}
+
+std::size_t holo::fixed_allocator::get_offset(const void* pointer) const
+{
+	return memory_region.get_offset(pointer);
+}
+
+void* holo::fixed_allocator::get_pointer(std::size_t offset) const
+{
+	return memory_region.get_pointer(offset);
+}
+
+void holo::fixed_allocator::set_statistics_enabled(bool enable)
+{
+	counter.set_enabled(enable);
+}
+
+void holo::fixed_allocator::get_statistics(holo::allocation_statistics* statistics) const
+{
+	counter.get_statistics(statistics);
 }
@@ -11,6 +11,7 @@
 #define HOLOGINE_CORE_MEMORY_FIXED_ALLOCATOR_HPP_
 
 #include <cstddef>
+#include "core/memory/allocation_statistics.hpp"
 #include "core/memory/allocator.hpp"
 #include "core/memory/memory_region.hpp"
 
@@ -43,6 +44,19 @@ namespace holo
 				std::size_t object_size,
 				std::size_t alignment = default_alignment);
 
+			// Constructs the fixed allocator on top of an existing memory region,
+			// taking ownership of it.
+			//
+			// The whole region is claimed, so none of it may be committed yet, and
+			// it must be writable. This allows placing objects in memory other than
+			// anonymous pages, such as a shared memory region; see
+			// holo::fixed_allocator::get_offset(const void*). The other parameters
+			// behave as above.
+			fixed_allocator(
+				holo::memory_region&& region,
+				std::size_t object_size,
+				std::size_t alignment = default_alignment);
+
 			// Frees all allocated memory.
 			~fixed_allocator();
 
@@ -55,6 +69,48 @@ namespace holo
 			// Deallocates a previously allocated object.
 			void deallocate(void* pointer);
 
+			// Every object is the same size, so sized deallocation is no different.
+			using holo::allocator::deallocate;
+
+			// Gets the size of a node, which is the object size rounded up to the
+			// alignment provided in the constructor.
+			std::size_t get_usable_size(void* pointer) override;
+
+			// Allocates several objects by detaching them from the free list at
+			// once.
+			//
+			// The same requirements as holo::fixed_allocator::allocate(size_t,
+			// size_t) apply.
+			std::size_t allocate_batch(
+				std::size_t size,
+				std::size_t count,
+				void** pointers,
+				std::size_t alignment = default_alignment) override;
+
+			// Deallocates several objects by splicing them onto the free list at
+			// once.
+			void deallocate_batch(void** pointers, std::size_t count) override;
+
+			// Gets the offset of 'pointer' from the beginning of the memory region.
+			//
+			// For an allocator on top of a shared memory region, other processes
+			// can resolve the offset against their own mapping of the region.
+			std::size_t get_offset(const void* pointer) const;
+
+			// Gets a pointer to the object 'offset' bytes from the beginning of the
+			// memory region.
+			void* get_pointer(std::size_t offset) const;
+
+			// Enables or disables gathering allocation statistics.
+			//
+			// Statistics are disabled by default.
+			void set_statistics_enabled(bool enable);
+
+			// Takes a snapshot of the allocation statistics.
+			//
+			// This method can be called from any thread.
+			void get_statistics(holo::allocation_statistics* statistics) const;
+
 		private:
 			// Memory region that provides the backing store to the fixed allocator.
 			holo::memory_region memory_region;
@@ -85,6 +141,9 @@ namespace holo
 
 			// Object size, in bytes.
 			std::size_t object_size;
+
+			// Allocation statistics.
+			holo::allocation_counter counter;
 	};
 }
 
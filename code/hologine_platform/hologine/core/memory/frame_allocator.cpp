@@ -0,0 +1,123 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include <new>
+#include "core/exception.hpp"
+#include "core/memory/frame_allocator.hpp"
+#include "core/threading/scoped_lock.hpp"
+
+const std::size_t holo::frame_allocator::maximum_frame_count;
+
+holo::frame_allocator::frame_allocator(std::size_t frame_size, std::size_t frame_count) :
+	frame_allocators(nullptr),
+	frame_count(frame_count),
+	current_frame(0),
+	completed_frame_count(0)
+{
+	holo_assert(frame_count > 0);
+	holo_assert(frame_count <= maximum_frame_count);
+
+	frame_allocators = (holo::linear_allocator*)frame_allocators_buffer.get();
+
+	// Each linear allocator pushes holo::exception::out_of_memory on failure,
+	// so there is nothing else to check.
+	for (std::size_t i = 0; i < frame_count; ++i)
+	{
+		new(&frame_allocators[i]) holo::linear_allocator(frame_size);
+	}
+}
+
+holo::frame_allocator::~frame_allocator()
+{
+	for (std::size_t i = 0; i < frame_count; ++i)
+	{
+		frame_allocators[i].~linear_allocator();
+	}
+}
+
+void* holo::frame_allocator::allocate(std::size_t size, std::size_t alignment)
+{
+	return get_current_frame_allocator()->allocate(size, alignment);
+}
+
+void holo::frame_allocator::deallocate(void*)
+{
+	// Nothing.
+	//
+	// The frame's buffer is reset in bulk by holo::frame_allocator::begin_frame().
+}
+
+std::uint64_t holo::frame_allocator::begin_frame()
+{
+	std::uint64_t next_frame = current_frame.load(std::memory_order_relaxed) + 1;
+
+	// The buffer was last used 'frame_count' frames ago. Wait for consumers of
+	// that frame to finish before trampling over its data.
+	if (next_frame >= frame_count)
+	{
+		std::uint64_t previous_frame = next_frame - frame_count;
+
+		if (!is_frame_complete(previous_frame))
+		{
+			holo::scoped_lock lock(fence_mutex);
+
+			while (!is_frame_complete(previous_frame))
+			{
+				fence_condition.wait(lock);
+			}
+		}
+	}
+
+	get_frame_allocator(next_frame)->reset();
+	current_frame.store(next_frame, std::memory_order_release);
+
+	return next_frame;
+}
+
+void holo::frame_allocator::complete_frame(std::uint64_t frame)
+{
+	// Completing a frame that hasn't begun would let begin_frame() reset a
+	// buffer before its frame was ever consumed.
+	holo_assert(frame <= get_current_frame());
+
+	holo::scoped_lock lock(fence_mutex);
+
+	// Frames are completed in order, so completing an older frame again is
+	// harmless.
+	if (frame >= completed_frame_count.load(std::memory_order_relaxed))
+	{
+		completed_frame_count.store(frame + 1, std::memory_order_release);
+		fence_condition.notify_all();
+	}
+}
+
+bool holo::frame_allocator::is_frame_complete(std::uint64_t frame) const
+{
+	return frame < completed_frame_count.load(std::memory_order_acquire);
+}
+
+std::uint64_t holo::frame_allocator::get_current_frame() const
+{
+	return current_frame.load(std::memory_order_acquire);
+}
+
+std::size_t holo::frame_allocator::get_frame_count() const
+{
+	return frame_count;
+}
+
+holo::linear_allocator* holo::frame_allocator::get_current_frame_allocator()
+{
+	return get_frame_allocator(current_frame.load(std::memory_order_relaxed));
+}
+
+holo::linear_allocator* holo::frame_allocator::get_frame_allocator(std::uint64_t frame)
+{
+	return &frame_allocators[frame % frame_count];
+}
@@ -0,0 +1,135 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#ifndef HOLOGINE_CORE_MEMORY_FRAME_ALLOCATOR_HPP_
+#define HOLOGINE_CORE_MEMORY_FRAME_ALLOCATOR_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include "core/memory/allocator.hpp"
+#include "core/memory/buffer.hpp"
+#include "core/memory/linear_allocator.hpp"
+#include "core/threading/condition_variable.hpp"
+#include "core/threading/mutex.hpp"
+
+namespace holo
+{
+	// Allocates temporary memory that lives for a single frame.
+	//
+	// A frame allocator rotates through several linear allocators, one per
+	// frame in flight. Allocating is a pointer bump into the current frame's
+	// linear allocator, and nothing is ever deallocated individually; instead,
+	// a frame's memory is reclaimed all at once when the frame's buffer comes
+	// around again.
+	//
+	// Since other threads (e.g., a renderer) may still be consuming a frame's
+	// data after the producer moved on, a buffer is only reset once its frame
+	// has been completed by a call to holo::frame_allocator::complete_frame().
+	// Completing a frame acts as a fence: every earlier frame is completed as
+	// well.
+	//
+	// Allocation and holo::frame_allocator::begin_frame() must happen on a
+	// single thread. Frames can be completed from any thread.
+	class frame_allocator final : public allocator
+	{
+		public:
+			// The maximum number of frames in flight.
+			static const std::size_t maximum_frame_count = 4;
+
+			// Constructs a frame allocator with 'frame_count' buffers, each able to
+			// store 'frame_size' bytes.
+			//
+			// 'frame_count' must be between 1 and
+			// holo::frame_allocator::maximum_frame_count. On construction, frame 0
+			// is the current frame.
+			//
+			// If a buffer could not be created, holo::exception::out_of_memory is
+			// pushed and allocations from that buffer's frames will fail.
+			frame_allocator(std::size_t frame_size, std::size_t frame_count = 2);
+
+			// Releases every buffer.
+			//
+			// Frames still being consumed must be completed beforehand.
+			~frame_allocator();
+
+			// Allocates memory from the current frame.
+			//
+			// The memory is valid until the frame is completed.
+			void* allocate(std::size_t size, std::size_t alignment = default_alignment) override;
+
+			// This method does nothing. Memory is reclaimed when the frame's buffer
+			// is reused.
+			void deallocate(void* pointer) override;
+
+			// Sized deallocation does nothing as well.
+			using holo::allocator::deallocate;
+
+			// Begins the next frame and returns its number.
+			//
+			// If the buffer of the next frame is still in use by the frame
+			// 'frame_count' frames ago, this method blocks until that frame is
+			// completed. The buffer is then reset.
+			std::uint64_t begin_frame();
+
+			// Completes 'frame' and every frame before it, allowing their buffers to
+			// be reused.
+			//
+			// 'frame' must not be later than the current frame, as returned by
+			// holo::frame_allocator::get_current_frame(). Completing a frame that
+			// is already complete does nothing.
+			void complete_frame(std::uint64_t frame);
+
+			// Gets if 'frame' was completed.
+			bool is_frame_complete(std::uint64_t frame) const;
+
+			// Gets the number of the current frame.
+			std::uint64_t get_current_frame() const;
+
+			// Gets the number of frames in flight.
+			std::size_t get_frame_count() const;
+
+			// Gets the linear allocator of the current frame.
+			//
+			// This can be used to push and pop markers within a frame.
+			holo::linear_allocator* get_current_frame_allocator();
+
+		private:
+			// Gets the buffer used by 'frame'.
+			holo::linear_allocator* get_frame_allocator(std::uint64_t frame);
+
+			// Static buffer used to store the linear allocators.
+			holo::buffer<sizeof(holo::linear_allocator) * maximum_frame_count> frame_allocators_buffer;
+
+			// Pointer to an array of linear allocators, one per frame in flight.
+			//
+			// This is the value of frame_allocators_buffer::get().
+			holo::linear_allocator* frame_allocators;
+
+			// The number of frames in flight.
+			std::size_t frame_count;
+
+			// The current frame.
+			//
+			// Only the producer thread modifies the current frame, but consumers
+			// may query it.
+			std::atomic<std::uint64_t> current_frame;
+
+			// The number of completed frames; every frame less than this value is
+			// complete.
+			std::atomic<std::uint64_t> completed_frame_count;
+
+			// Mutex guarding the frame fence.
+			holo::mutex fence_mutex;
+
+			// Signaled when frames are completed.
+			holo::condition_variable fence_condition;
+	};
+}
+
+#endif
@@ -8,9 +8,13 @@
 // For licensing information, review the LICENSE file located at the root
 // directory of the source package.
 #include <algorithm>
+#include <utility>
 #include "core/exception.hpp"
 #include "core/math/bits.hpp"
 #include "core/math/util.hpp"
+#include "core/container/intrusive_list.hpp"
+#include "core/io/binary_writer.hpp"
+#include "core/io/endianness.hpp"
 #include "core/memory/heap_allocator.hpp"
 #include "core/memory/pool_allocator.hpp"
 
@@ -21,86 +25,467 @@ holo::heap_allocator::heap_allocator(
 	std::size_t pool_end) :
 		memory_arena_pool(arena_size, arena_count),
 		pool_allocators((holo::pool_allocator*)pool_allocators_buffer.get()),
-		minimum_pool_size(math::bit_log2(pool_start)),
-		maximum_pool_size(math::bit_log2(pool_end))
+		first_size_class(0),
+		size_class_count(0),
+		buddy_allocator(
+			&memory_arena_pool,
+			get_absolute_size_class_size(get_absolute_size_class(pool_end))),
+		large_allocations(nullptr),
+		large_allocation_count(0),
+		large_allocation_size(0),
+		large_allocation_reserved_size(0),
+		large_allocation_counter()
 {
 	holo_assert(pool_start > 0);
 	holo_assert(pool_end >= pool_start);
 
-	// Initialize pools. Each pool is a power of two larger than the previous.
-	pool_allocator* current = pool_allocators;
-	std::size_t current_size = minimum_pool_size;
+	// The smallest class must fit the smallest object a pool can store.
+	first_size_class = get_absolute_size_class(
+		std::max(pool_start, holo::pool_allocator::minimum_object_size));
 
-	// We want to include a pool with the maximum pool size, so be inclusive.
-	while (current_size <= maximum_pool_size)
+	// We want to include a pool that fits 'pool_end', so be inclusive.
+	size_class_count = get_absolute_size_class(pool_end) - first_size_class + 1;
+	holo_assert(size_class_count <= maximum_size_class_count);
+
+	// Initialize pools, one per size class.
+	for (std::size_t i = 0; i < size_class_count; ++i)
 	{
+		size_class_sizes[i] = get_absolute_size_class_size(first_size_class + i);
+
 		// The pool allocator does not perform any allocations.
 		//
 		// Therefore, don't check for errors!
-		new(current) holo::pool_allocator(&memory_arena_pool, 1 << current_size);
-
-		++current_size;
-		++current;
+		new(&pool_allocators[i]) holo::pool_allocator(&memory_arena_pool, size_class_sizes[i]);
 	}
 }
 
 holo::heap_allocator::~heap_allocator()
 {
-	std::size_t pool_count = maximum_pool_size - minimum_pool_size;
+	std::size_t pool_count = get_size_class_count();
 	std::size_t current_pool_index = 0;
 
 	while (current_pool_index < pool_count)
 	{
 		pool_allocators[current_pool_index++].~pool_allocator();
 	}
+
+	// Unmap any large allocations that were never freed.
+	while (large_allocations != nullptr)
+	{
+		deallocate_large((char*)large_allocations + large_allocation_header_size);
+	}
 }
 
 void* holo::heap_allocator::allocate(std::size_t size, std::size_t alignment)
 {
+	std::size_t pool_index = get_size_class(size, alignment);
+	if (pool_index >= get_size_class_count())
+	{
+		if (size <= get_medium_allocation_limit() && alignment <= get_medium_allocation_limit())
+		{
+			return buddy_allocator.allocate(size, alignment);
+		}
+
+		return allocate_large(size, alignment);
+	}
+
+	// Perform the allocation.
+	void* base_pointer = pool_allocators[pool_index].allocate(size);
+	if (base_pointer == nullptr)
+	{
+		return nullptr;
+	}
+
+	// Align and return.
+	return align_pointer(base_pointer, alignment);
+}
+
+void holo::heap_allocator::deallocate(void* pointer)
+{
+	auto record = memory_arena_pool.get_arena(pointer);
+	if (record == nullptr)
+	{
+		// Pointers outside the arena span can only be large allocations.
+		deallocate_large(pointer);
+
+		return;
+	}
+
+	// The arena belongs to either a pool or the buddy allocator.
+	record->allocator->deallocate(pointer);
+}
+
+void holo::heap_allocator::deallocate(void* pointer, std::size_t size, std::size_t alignment)
+{
+	std::size_t pool_index = get_size_class(size, alignment);
+	if (pool_index >= get_size_class_count())
+	{
+		if (size <= get_medium_allocation_limit() && alignment <= get_medium_allocation_limit())
+		{
+			buddy_allocator.deallocate(pointer, size, alignment);
+		}
+		else
+		{
+			deallocate_large(pointer);
+		}
+
+		return;
+	}
+
+	holo_assert(memory_arena_pool.get_arena(pointer)->allocator == &pool_allocators[pool_index]);
+
+	pool_allocators[pool_index].deallocate(pointer);
+}
+
+std::size_t holo::heap_allocator::get_usable_size(void* pointer)
+{
+	auto record = memory_arena_pool.get_arena(pointer);
+	if (record == nullptr)
+	{
+		return get_large_allocation(pointer)->usable_size;
+	}
+
+	if (record->allocator == &buddy_allocator)
+	{
+		return buddy_allocator.get_usable_size(pointer);
+	}
+
+	std::size_t size_class;
+	void* block = get_block(pointer, &size_class);
+
+	return size_class_sizes[size_class] - get_pointer_distance(pointer, block);
+}
+
+std::size_t holo::heap_allocator::allocate_batch(
+	std::size_t size,
+	std::size_t count,
+	void** pointers,
+	std::size_t alignment)
+{
+	std::size_t pool_index = get_size_class(size, alignment);
+	if (pool_index >= get_size_class_count())
+	{
+		// Medium and large allocations are made one at a time anyway.
+		return allocator::allocate_batch(size, count, pointers, alignment);
+	}
+
+	std::size_t allocated = pool_allocators[pool_index].allocate_batch(size, count, pointers);
+
+	if (alignment > default_alignment)
+	{
+		for (std::size_t i = 0; i < allocated; ++i)
+		{
+			pointers[i] = align_pointer(pointers[i], alignment);
+		}
+	}
+
+	return allocated;
+}
+
+void holo::heap_allocator::deallocate_batch(void** pointers, std::size_t count)
+{
+	std::size_t current = 0;
+
+	while (current < count)
+	{
+		auto record = memory_arena_pool.get_arena(pointers[current]);
+		if (record == nullptr)
+		{
+			deallocate_large(pointers[current]);
+			++current;
+
+			continue;
+		}
+
+		// Find the run of blocks belonging to the same allocator.
+		std::size_t end = current + 1;
+		while (end < count)
+		{
+			auto next_record = memory_arena_pool.get_arena(pointers[end]);
+			if (next_record == nullptr || next_record->allocator != record->allocator)
+			{
+				break;
+			}
+
+			++end;
+		}
+
+		record->allocator->deallocate_batch(pointers + current, end - current);
+		current = end;
+	}
+}
+
+std::size_t holo::heap_allocator::get_size_class_count() const
+{
+	return size_class_count;
+}
+
+std::size_t holo::heap_allocator::get_size_class(std::size_t size, std::size_t alignment) const
+{
+	// Every block is aligned on the default alignment (size classes are
+	// multiples of it, and arenas are aligned on their size). Any stricter
+	// alignment may require padding up to 'alignment - default_alignment' bytes.
 	std::size_t minimum_alignment = std::max(alignment, default_alignment);
 	std::size_t required_alignment = minimum_alignment - default_alignment;
 
-	// 'required_alignment' is 1 byte too much for sizes > 0. Adjust if necessary.
-	if (required_alignment > 0)
+	std::size_t final_size = size + required_alignment;
+
+	// Clamp to the smallest pool.
+	std::size_t size_class = std::max(get_absolute_size_class(final_size), first_size_class);
+	if (size_class - first_size_class >= size_class_count)
 	{
-		--required_alignment;
+		return size_class_count;
 	}
 
-	std::size_t final_size = required_alignment;
+	return size_class - first_size_class;
+}
+
+std::size_t holo::heap_allocator::get_size_class_size(std::size_t size_class) const
+{
+	return size_class_sizes[size_class];
+}
 
-	// Get the clamped pool index of a pool that's large enough for this
-	// allocation.
-	//
-	// This value is compared against maximum_pool_size to ensure there's an
-	// appropriate allocator.
-	std::size_t pool_index =
-		std::max(math::bit_log2(final_size), minimum_pool_size);
-	if (pool_index > maximum_pool_size)
+void* holo::heap_allocator::get_block(void* pointer, std::size_t* size_class)
+{
+	auto record = memory_arena_pool.get_arena(pointer);
+	if (record == nullptr)
 	{
-		push_exception(exception::out_of_memory);
+		// Make sure the pointer really is a large allocation.
+		get_large_allocation(pointer);
 
+		*size_class = get_size_class_count();
 		return nullptr;
 	}
 
-	// Adjust the pool index by 'minimum' size to retrieve the correct pool index
-	// into the array.
-	pool_index -= minimum_pool_size;
+	if (record->allocator == &buddy_allocator)
+	{
+		*size_class = get_size_class_count();
+		return nullptr;
+	}
 
-	// Perform the allocation.
-	void* base_pointer = pool_allocators[pool_index].allocate(size);
+	// Otherwise, the allocator of an arena is one of the pool allocators, so
+	// its position in the array is the size class.
+	std::size_t pool_index = (holo::pool_allocator*)record->allocator - pool_allocators;
+	*size_class = pool_index;
+
+	// Blocks are packed from the base of the arena, so the block base is the
+	// offset rounded down to the block size.
+	std::size_t offset = get_pointer_distance(pointer, record->base);
+	return (char*)record->base + (offset - offset % size_class_sizes[pool_index]);
+}
+
+std::size_t holo::heap_allocator::get_large_allocation_count() const
+{
+	return large_allocation_count;
+}
+
+std::size_t holo::heap_allocator::get_large_allocation_size() const
+{
+	return large_allocation_size;
+}
+
+void holo::heap_allocator::set_statistics_enabled(bool enable)
+{
+	std::size_t pool_count = get_size_class_count();
+	for (std::size_t i = 0; i < pool_count; ++i)
+	{
+		pool_allocators[i].set_statistics_enabled(enable);
+	}
+
+	buddy_allocator.set_statistics_enabled(enable);
+	large_allocation_counter.set_enabled(enable);
+}
+
+void holo::heap_allocator::get_size_class_statistics(
+	std::size_t size_class,
+	holo::allocation_statistics* statistics) const
+{
+	holo_assert(size_class <= get_size_class_count());
+
+	if (size_class == get_size_class_count())
+	{
+		large_allocation_counter.get_statistics(statistics);
+	}
+	else
+	{
+		pool_allocators[size_class].get_statistics(statistics);
+	}
+}
+
+void holo::heap_allocator::get_medium_allocation_statistics(
+	holo::allocation_statistics* statistics) const
+{
+	buddy_allocator.get_statistics(statistics);
+}
+
+std::size_t holo::heap_allocator::get_medium_allocation_limit() const
+{
+	return buddy_allocator.get_max_block_size();
+}
+
+void holo::heap_allocator::get_arena_pool_statistics(
+	holo::memory_arena_pool::statistics* statistics) const
+{
+	memory_arena_pool.get_statistics(statistics);
+}
+
+bool holo::heap_allocator::write_statistics(holo::stream_interface* stream) const
+{
+	holo::binary_writer writer(stream, holo::endianness::little);
+
+	holo::memory_arena_pool::statistics arena_pool_statistics;
+	get_arena_pool_statistics(&arena_pool_statistics);
+
+	bool success =
+		writer.write_ulong(arena_pool_statistics.arena_size) &&
+		writer.write_ulong(arena_pool_statistics.reserved_arenas) &&
+		writer.write_ulong(arena_pool_statistics.allocated_arenas) &&
+		writer.write_ulong(arena_pool_statistics.decommitted_arenas) &&
+		writer.write_ulong(arena_pool_statistics.arenas_in_use) &&
+		writer.write_ulong(arena_pool_statistics.peak_arenas_in_use) &&
+		writer.write_ulong(arena_pool_statistics.reserved_bytes) &&
+		writer.write_ulong(arena_pool_statistics.committed_bytes);
+
+	// Large allocations are written as the last size class.
+	std::size_t size_class_count = get_size_class_count();
+	success = success && writer.write_uint((std::uint32_t)(size_class_count + 1));
+
+	for (std::size_t i = 0; success && i <= size_class_count; ++i)
+	{
+		holo::allocation_statistics statistics;
+		get_size_class_statistics(i, &statistics);
+
+		std::size_t block_size = i < size_class_count ? get_size_class_size(i) : 0;
+		success =
+			writer.write_ulong(block_size) &&
+			holo::write_allocation_statistics(&writer, statistics);
+	}
+
+	return success;
+}
+
+std::size_t holo::heap_allocator::get_absolute_size_class(std::size_t size)
+{
+	if (size <= linear_size_class_end)
+	{
+		// Small classes are simply multiples of the default alignment. A size of
+		// zero is treated as the smallest class.
+		std::size_t blocks = (size + default_alignment - 1) / default_alignment;
+
+		return blocks == 0 ? 0 : blocks - 1;
+	}
+
+	// The power of two 'size' exceeds; the size falls in the group
+	// (2^group, 2^(group + 1)], which is divided in four.
+	std::size_t group = (std::size_t)math::bit_log2((std::uint64_t)(size - 1));
+	std::size_t group_shift = group - 2;
+
+	// The top three bits of 'size - 1' are 1xx; 'xx' is the class within the
+	// group.
+	std::size_t group_offset = ((size - 1) >> group_shift) - size_classes_per_group;
+
+	std::size_t linear_size_class_count = linear_size_class_end / default_alignment;
+	std::size_t first_group = math::bit_log2((std::uint64_t)linear_size_class_end);
+
+	return linear_size_class_count + (group - first_group) * size_classes_per_group + group_offset;
+}
+
+std::size_t holo::heap_allocator::get_absolute_size_class_size(std::size_t size_class)
+{
+	std::size_t linear_size_class_count = linear_size_class_end / default_alignment;
+	if (size_class < linear_size_class_count)
+	{
+		return (size_class + 1) * default_alignment;
+	}
+
+	std::size_t first_group = math::bit_log2((std::uint64_t)linear_size_class_end);
+	std::size_t group = first_group + (size_class - linear_size_class_count) / size_classes_per_group;
+	std::size_t group_offset = (size_class - linear_size_class_count) % size_classes_per_group;
+
+	std::size_t group_size = (std::size_t)1 << group;
+	return group_size + (group_offset + 1) * (group_size / size_classes_per_group);
+}
+
+void* holo::heap_allocator::allocate_large(std::size_t size, std::size_t alignment)
+{
+	// The region is page-aligned, so (like a size class) at most
+	// 'alignment - default_alignment' bytes of padding are needed between the
+	// header and the pointer.
+	std::size_t padding = std::max(alignment, default_alignment) - default_alignment;
+	std::size_t region_size = size + large_allocation_header_size + padding;
+
+	// Guard against overflow with absurd sizes.
+	if (region_size < size)
+	{
+		push_exception(exception::out_of_memory);
+
+		return nullptr;
+	}
+
+	holo::memory_region memory_region(region_size);
+	void* base_pointer = memory_region.grow(region_size);
 	if (base_pointer == nullptr)
 	{
 		return nullptr;
 	}
 
-	// Align and return.
-	return align_pointer(base_pointer, alignment);
+	void* pointer = align_pointer((char*)base_pointer + large_allocation_header_size, alignment);
+	large_allocation* allocation =
+		new((char*)pointer - large_allocation_header_size) large_allocation();
+
+	allocation->owner = this;
+	allocation->usable_size =
+		memory_region.get_current_size() - get_pointer_distance(pointer, base_pointer);
+	allocation->next = large_allocations;
+	allocation->previous = nullptr;
+
+	if (large_allocations != nullptr)
+	{
+		large_allocations->previous = allocation;
+	}
+	large_allocations = allocation;
+
+	++large_allocation_count;
+	large_allocation_size += memory_region.get_current_size();
+	large_allocation_reserved_size += memory_region.get_reserved_size();
+
+	large_allocation_counter.record_allocation(size, memory_region.get_current_size());
+	large_allocation_counter.record_memory(large_allocation_size, large_allocation_reserved_size);
+
+	// The header now owns the region.
+	allocation->memory_region = std::move(memory_region);
+
+	return pointer;
 }
 
-void holo::heap_allocator::deallocate(void* pointer)
+void holo::heap_allocator::deallocate_large(void* pointer)
 {
-	auto record = memory_arena_pool.get_arena(pointer);
-	holo_assert(record != nullptr);
+	large_allocation* allocation = get_large_allocation(pointer);
 
-	record->allocator->deallocate(pointer);
+	if (large_allocations == allocation)
+	{
+		large_allocations = allocation->next;
+	}
+	intrusive_list::remove(allocation);
+
+	--large_allocation_count;
+	large_allocation_size -= allocation->memory_region.get_current_size();
+	large_allocation_reserved_size -= allocation->memory_region.get_reserved_size();
+
+	large_allocation_counter.record_deallocation(allocation->memory_region.get_current_size());
+	large_allocation_counter.record_memory(large_allocation_size, large_allocation_reserved_size);
+
+	// The header is about to be unmapped along with the rest of the region, so
+	// move the region out before releasing it.
+	holo::memory_region memory_region(std::move(allocation->memory_region));
+	memory_region.reset(true);
+}
+
+holo::heap_allocator::large_allocation* holo::heap_allocator::get_large_allocation(void* pointer)
+{
+	large_allocation* allocation =
+		(large_allocation*)((char*)pointer - large_allocation_header_size);
+	holo_assert(allocation->owner == this);
+
+	return allocation;
 }
@@ -11,14 +11,18 @@
 #define HOLOGINE_CORE_MEMORY_HEAP_ALLOCATOR_HPP_
 
 #include <cstddef>
+#include "core/memory/allocation_statistics.hpp"
 #include "core/memory/allocator.hpp"
+#include "core/memory/buddy_allocator.hpp"
 #include "core/memory/buffer.hpp"
 #include "core/memory/memory_arena_pool.hpp"
+#include "core/memory/memory_region.hpp"
 #include "core/memory/pool_allocator.hpp"
 
 namespace holo
 {
 	class pool_allocator;
+	class stream_interface;
 
 	// Provides an interface to a general allocation strategy.
 	class heap_allocator final : public allocator
@@ -27,7 +31,7 @@ namespace holo
 			// Constructs a heap allocator with the provided parameters.
 			//
 			// 'arena_size' determines the minimum size of memory arenas
-			// allocated by the allocator and must be a power of two.
+			// allocated by the allocator and is rounded up to a power of two.
 			//
 			// 'arena_count' determines how many memory regions are permitted in
 			// total.
@@ -38,8 +42,15 @@ namespace holo
 			// allocation pattern. The behavior is implementation-specific, however.
 			//
 			// Therefore, the only guarantee is that a number of pools will be created
-			// to fit smaller allocations, and that the largest pool will be
-			// 'pool_end' bytes large, while the smallest will be 'pool_start'.
+			// to fit smaller allocations, and that the largest pool will be at least
+			// 'pool_end' bytes large, while the smallest will be at least
+			// 'pool_start'. Both are rounded up to the nearest size class; see
+			// holo::heap_allocator::get_size_class(std::size_t, std::size_t).
+			//
+			// Allocations too large for the largest pool, but no larger than an
+			// arena, are split out of arenas by a holo::buddy_allocator. Anything
+			// larger is given its own holo::memory_region, which is released as
+			// soon as the allocation is freed.
 			//
 			// Note: size parameters are in bytes.
 			explicit heap_allocator(
@@ -55,6 +66,10 @@ namespace holo
 
 			// Allocates a block of memory from the heap allocator.
 			//
+			// Allocations that don't fit in any size class are taken from the buddy
+			// allocator if they fit in an arena, and otherwise mapped directly from
+			// the platform, rounded up to the page size.
+			//
 			// If the allocation could not be made, then this method returns NULL and
 			// an appropriate exception is pushed.
 			void* allocate(std::size_t size, std::size_t alignment = default_alignment);
@@ -62,31 +77,220 @@ namespace holo
 			// Deallocates a block of memory previously obtained from this allocator.
 			void deallocate(void* pointer);
 
+			// Deallocates a block of memory of a known size.
+			//
+			// The size class is computed from 'size' and 'alignment' instead of
+			// looking up the arena containing the pointer, and the block is returned
+			// directly to the size class's pool.
+			void deallocate(void* pointer, std::size_t size, std::size_t alignment = default_alignment) override;
+
+			// Gets the number of bytes usable starting at 'pointer'.
+			//
+			// This is the remainder of the size class block (or, for medium
+			// allocations, the buddy block, and for large allocations, the mapped
+			// region) past the pointer.
+			std::size_t get_usable_size(void* pointer) override;
+
+			// Allocates several blocks of memory from the heap allocator.
+			//
+			// The size class is only computed once, and blocks are taken from the
+			// size class's pool in bulk. Medium and large allocations are made one
+			// at a time.
+			std::size_t allocate_batch(
+				std::size_t size,
+				std::size_t count,
+				void** pointers,
+				std::size_t alignment = default_alignment) override;
+
+			// Deallocates several blocks of memory previously obtained from this
+			// allocator.
+			//
+			// Consecutive blocks belonging to the same size class are returned to
+			// their pool in bulk.
+			void deallocate_batch(void** pointers, std::size_t count) override;
+
+			// Gets the number of size classes.
+			//
+			// Each size class is backed by its own holo::pool_allocator. Size
+			// classes are ordered from smallest to largest.
+			std::size_t get_size_class_count() const;
+
+			// Gets the smallest size class that can fit an allocation of 'size'
+			// bytes aligned to 'alignment' bytes.
+			//
+			// Up to 64 bytes, size classes are spaced 16 bytes apart. Past that,
+			// every power of two is divided into four evenly spaced size classes
+			// (e.g., 80, 96, 112, 128, then 160, 192, 224, 256, and so on), so past
+			// 64 bytes, less than a fifth of a block is wasted by rounding up. Every
+			// size class is a multiple of the default alignment.
+			//
+			// The lookup takes constant time.
+			//
+			// If the allocation is too large for any size class, this returns
+			// holo::heap_allocator::get_size_class_count().
+			std::size_t get_size_class(std::size_t size, std::size_t alignment = default_alignment) const;
+
+			// Gets the size, in bytes, of blocks in the provided size class.
+			std::size_t get_size_class_size(std::size_t size_class) const;
+
+			// Gets the base of the block containing 'pointer' and stores the size
+			// class of the block in 'size_class'.
+			//
+			// If the pointer is a medium or large allocation (i.e., it does not
+			// belong to any size class), then 'size_class' is set to
+			// holo::heap_allocator::get_size_class_count() and NULL is returned.
+			//
+			// The pointer must have been allocated by this heap allocator.
+			void* get_block(void* pointer, std::size_t* size_class);
+
+			// Gets the number of live large allocations.
+			std::size_t get_large_allocation_count() const;
+
+			// Gets the total size, in bytes, of memory committed for live large
+			// allocations.
+			std::size_t get_large_allocation_size() const;
+
+			// Enables or disables gathering allocation statistics for every size
+			// class, medium allocations, and large allocations.
+			//
+			// Statistics are disabled by default. Disabling them keeps the
+			// statistics gathered so far.
+			void set_statistics_enabled(bool enable);
+
+			// Takes a snapshot of the allocation statistics of a size class.
+			//
+			// If 'size_class' is holo::heap_allocator::get_size_class_count(), the
+			// statistics of large allocations are retrieved instead.
+			//
+			// This method can be called from any thread.
+			void get_size_class_statistics(
+				std::size_t size_class,
+				holo::allocation_statistics* statistics) const;
+
+			// Takes a snapshot of the allocation statistics of medium allocations,
+			// i.e., those made by the buddy allocator.
+			void get_medium_allocation_statistics(holo::allocation_statistics* statistics) const;
+
+			// Gets the largest allocation made by the buddy allocator.
+			//
+			// Allocations between the largest size class and this size are
+			// considered medium allocations.
+			std::size_t get_medium_allocation_limit() const;
+
+			// Takes a snapshot of the usage of the underlying arena pool.
+			//
+			// This method can be called from any thread.
+			void get_arena_pool_statistics(holo::memory_arena_pool::statistics* statistics) const;
+
+			// Writes a snapshot of all statistics to 'stream', in little endian.
+			//
+			// The arena pool statistics are written first, each field as an
+			// unsigned 64-bit integer. Then follows the number of size classes
+			// (including large allocations) as an unsigned 32-bit integer, and for
+			// each size class, the block size (zero for large allocations) as an
+			// unsigned 64-bit integer followed by the statistics, as written by
+			// holo::write_allocation_statistics().
+			//
+			// This method can be called from any thread.
+			//
+			// Returns true on success, false if the stream could not be written.
+			bool write_statistics(holo::stream_interface* stream) const;
+
 		private:
-			// The maximum number of pools allocated by the heap allocator.
+			// Header placed immediately before the pointer of a large allocation.
+			struct large_allocation
+			{
+				// The memory region backing the allocation.
+				//
+				// The header itself lives within this region.
+				holo::memory_region memory_region;
+
+				// The next large allocation.
+				large_allocation* next;
+
+				// The previous large allocation.
+				large_allocation* previous;
+
+				// The heap allocator that made the allocation.
+				heap_allocator* owner;
+
+				// Number of bytes mapped past the pointer.
+				std::size_t usable_size;
+			};
+
+			// Size of the large allocation header, rounded up so the header can sit
+			// immediately before an aligned pointer.
+			static const std::size_t large_allocation_header_size =
+				(sizeof(large_allocation) + default_alignment - 1) & ~(default_alignment - 1);
+
+			// Maps a dedicated memory region for an allocation too large for any
+			// size class.
+			void* allocate_large(std::size_t size, std::size_t alignment);
+
+			// Unmaps a large allocation.
+			void deallocate_large(void* pointer);
+
+			// Gets the header of a large allocation.
+			large_allocation* get_large_allocation(void* pointer);
+
+			// The maximum number of size classes (and thus pools) allocated by the
+			// heap allocator.
 			//
-			// Keep in mind each pool is a power of two. The last pool, in this
-			// pattern, would make 4 gigabyte allocations for one object! 32 max pools
-			// is more than plenty.
-			static const std::size_t maximum_pool_count = 32;
+			// Four size classes per power of two, up to 512 megabytes, is more than
+			// plenty.
+			static const std::size_t maximum_size_class_count = 96;
+
+			// Number of size classes per power of two.
+			static const std::size_t size_classes_per_group = 4;
+
+			// The largest size class spaced linearly (by the default alignment).
+			static const std::size_t linear_size_class_end = 64;
+
+			// Gets the size class of 'size', counting from the smallest possible
+			// size class (i.e., the default alignment) rather than 'pool_start'.
+			static std::size_t get_absolute_size_class(std::size_t size);
+
+			// Gets the size of an absolute size class.
+			static std::size_t get_absolute_size_class_size(std::size_t size_class);
 
 			// The memory arena pool.
 			holo::memory_arena_pool memory_arena_pool;
 
 			// Static buffer used to generate an array of pool allocators.
-			holo::buffer<sizeof(holo::pool_allocator) * maximum_pool_count> pool_allocators_buffer;
+			holo::buffer<sizeof(holo::pool_allocator) * maximum_size_class_count> pool_allocators_buffer;
 
 			// Pointer to an array of pool allocators.
 			//
 			// This is the value of pool_allocator_buffer::get().
 			pool_allocator* pool_allocators;
 
-			// Minimum size of a pool, represented as the log2 (e.g., 32 would be 5).
-			std::size_t minimum_pool_size;
+			// The absolute size class of the smallest pool.
+			std::size_t first_size_class;
+
+			// The number of size classes.
+			std::size_t size_class_count;
+
+			// Block size of each size class.
+			std::size_t size_class_sizes[maximum_size_class_count];
+
+			// Allocator for blocks too large for any size class but no larger than
+			// an arena.
+			holo::buddy_allocator buddy_allocator;
+
+			// List of live large allocations.
+			large_allocation* large_allocations;
+
+			// Number of live large allocations.
+			std::size_t large_allocation_count;
+
+			// Bytes committed for live large allocations.
+			std::size_t large_allocation_size;
+
+			// Bytes reserved for live large allocations.
+			std::size_t large_allocation_reserved_size;
 
-			// Maximum size of a pool, represented as the log2 (e.g., 8192 would be
-			// 13).
-			std::size_t maximum_pool_size;
+			// Allocation statistics for large allocations.
+			holo::allocation_counter large_allocation_counter;
 	};
 }
 
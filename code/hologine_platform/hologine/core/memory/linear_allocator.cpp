@@ -7,29 +7,57 @@
 //
 // For licensing information, review the LICENSE file located at the root
 // directory of the source package.
+#include <algorithm>
+#include <utility>
 #include "core/exception.hpp"
 #include "core/platform.hpp"
 #include "core/math/util.hpp"
 #include "core/memory/linear_allocator.hpp"
 
-holo::linear_allocator::linear_allocator(std::size_t size) :
-	memory_region(size),
+const std::size_t holo::linear_allocator::default_chunk_size;
+
+holo::linear_allocator::linear_allocator(std::size_t size, int flags, std::size_t chunk_size) :
+	linear_allocator(holo::memory_region(holo::memory_region::get_minimum_size(size)), flags, chunk_size)
+{
+	// Nothing.
+}
+
+holo::linear_allocator::linear_allocator(
+	holo::memory_region&& region,
+	int flags,
+	std::size_t chunk_size) :
+	memory_region(std::move(region)),
+	flags(flags),
+	chunk_size(math::round_up(std::max(chunk_size, std::size_t(1)), holo::memory_region::get_page_size())),
+	high_water_mark(memory_region.get_reserved_size()),
 	memory(nullptr),
-	memory_offset(0)
+	memory_offset(0),
+	current_marker(0),
+	counter()
 {
 	// Claim the entire memory region, committing all virtual memory to the
-	// process; on failure, push holo::exception::out_of_memory.
+	// process; on failure, push holo::exception::out_of_memory. When committing
+	// lazily, the region is only reserved.
 	//
 	// Even though an attempt to claim the memory region may push an exception, it
 	// will probably be a platform exception. For the immediate purpose of linear
 	// allocator, it is good enough to consider it an out of memory exception
 	// because no memory is available to the linear allocator.
-	memory = memory_region.claim();
+	if (flags & flag_commit_lazily)
+	{
+		memory = memory_region.grow(0);
+	}
+	else
+	{
+		memory = memory_region.claim();
+	}
 	
 	if (memory == nullptr)
 	{
 		push_exception(exception::out_of_memory);
 	}
+
+	counter.record_memory(memory_region.get_current_size(), memory_region.get_reserved_size());
 }
 
 holo::linear_allocator::~linear_allocator()
@@ -45,12 +73,14 @@ void* holo::linear_allocator::allocate(std::size_t size, std::size_t alignment)
 	void* current_offset_pointer = align_pointer((char*)memory + memory_offset, alignment);
 	std::size_t requested_memory_offset = get_pointer_distance(current_offset_pointer, memory);
 	
-	if (requested_memory_offset + size < get_size())
+	if (requested_memory_offset + size <= get_size() && commit(requested_memory_offset + size))
 	{
 		pointer = (char*)memory + requested_memory_offset;
+
+		counter.record_allocation(size, requested_memory_offset + size - memory_offset);
 		
 		// There's enough memory available, so just bump.
-		memory_offset = requested_memory_offset;
+		memory_offset = requested_memory_offset + size;
 	}
 	else
 	{
@@ -122,6 +152,7 @@ void holo::linear_allocator::pop_marker()
 			std::size_t previous_marker = *((std::size_t*)align_pointer((char*)memory + current_marker, alignof(std::size_t)));
 
 			// Reset the stack to the current marker location.
+			counter.record_deallocation(memory_offset - current_marker, 0);
 			memory_offset = current_marker;
 
 			// Update the current marker.
@@ -132,14 +163,93 @@ void holo::linear_allocator::pop_marker()
 
 void holo::linear_allocator::reset()
 {
+	holo::allocation_statistics statistics;
+	counter.get_statistics(&statistics);
+	counter.record_deallocation(memory_offset, statistics.live_objects);
+
 	// Reset the offset to the beginning of the memory region.
 	memory_offset = 0;
 	current_marker = 0;
+
+	// Give back whatever a particularly heavy round of allocations committed.
+	std::size_t committed_size = memory_region.get_current_size();
+	if ((flags & flag_commit_lazily) && committed_size > high_water_mark)
+	{
+		memory_region.shrink(committed_size - high_water_mark);
+
+		counter.record_memory(memory_region.get_current_size(), memory_region.get_reserved_size());
+	}
+}
+
+void holo::linear_allocator::set_high_water_mark(std::size_t size)
+{
+	// The region commits whole pages at a time, so keeping a partial page makes
+	// no sense.
+	high_water_mark = size == 0 ? 0 : math::round_up(size, holo::memory_region::get_page_size());
 }
 
 std::size_t holo::linear_allocator::get_size() const
 {
+	// A region that failed to reserve memory can't store anything.
+	if (memory == nullptr)
+	{
+		return 0;
+	}
+
+	// When committing lazily, the region is reserved, but not committed.
+	if (flags & flag_commit_lazily)
+	{
+		return memory_region.get_reserved_size();
+	}
+
 	// Although the entire region should have been committed, let's play nice and
 	// only return the 'current' size.
 	return memory_region.get_current_size();
 }
+
+std::size_t holo::linear_allocator::get_committed_size() const
+{
+	return memory_region.get_current_size();
+}
+
+std::size_t holo::linear_allocator::get_offset(const void* pointer) const
+{
+	return memory_region.get_offset(pointer);
+}
+
+void* holo::linear_allocator::get_pointer(std::size_t offset) const
+{
+	return memory_region.get_pointer(offset);
+}
+
+void holo::linear_allocator::set_statistics_enabled(bool enable)
+{
+	counter.set_enabled(enable);
+}
+
+void holo::linear_allocator::get_statistics(holo::allocation_statistics* statistics) const
+{
+	counter.get_statistics(statistics);
+}
+
+bool holo::linear_allocator::commit(std::size_t size)
+{
+	std::size_t committed_size = memory_region.get_current_size();
+	if (size <= committed_size)
+	{
+		return true;
+	}
+
+	// Commit a whole number of chunks, but don't overrun the reservation.
+	std::size_t grow_size = math::round_up(size - committed_size, chunk_size);
+	grow_size = std::min(grow_size, memory_region.get_reserved_size() - committed_size);
+
+	if (memory_region.grow(grow_size) == nullptr)
+	{
+		return false;
+	}
+
+	counter.record_memory(memory_region.get_current_size(), memory_region.get_reserved_size());
+
+	return true;
+}
@@ -10,6 +10,7 @@
 #ifndef HOLOGINE_CORE_MEMORY_LINEAR_ALLOCATOR_HPP_
 #define HOLOGINE_CORE_MEMORY_LINEAR_ALLOCATOR_HPP_
 
+#include "core/memory/allocation_statistics.hpp"
 #include "core/memory/allocator.hpp"
 #include "core/memory/memory_region.hpp"
 
@@ -22,9 +23,26 @@ namespace holo
 	// allocation.
 	//
 	// Generally, a linear allocator is only safe to use with POD types.
+	//
+	// By default, the entire region is committed up front. A linear allocator
+	// can instead commit its region lazily, a chunk at a time, as the pointer
+	// advances; this allows reserving a region large enough for the worst case
+	// while only paying for the memory actually touched.
 	class linear_allocator final : public allocator
 	{
 		public:
+			// Flags that modify the behavior of the linear allocator.
+			enum
+			{
+				// Commits the memory region in chunks as allocations are made,
+				// rather than all at once on construction.
+				flag_commit_lazily = 0x00000001
+			};
+
+			// The default number of bytes committed at a time when committing
+			// lazily.
+			static const std::size_t default_chunk_size = 0x10000u;
+
 			// Constructs the linear allocator, reserving 'size' bytes at once.
 			//
 			// A memory region capable of storing 'size' bytes linearly will be
@@ -32,10 +50,29 @@ namespace holo
 			// method will push holo::exception::out_of_memory, and all further
 			// operations will fail.
 			//
+			// If 'flags' includes flag_commit_lazily, the region is only reserved
+			// on construction, and memory is committed 'chunk_size' bytes at a time
+			// as needed.
+			//
 			// Keep in mind that, like memory regions, more memory may be available
 			// than requested on success. To query the final size of the linear
 			// allocator, see holo::linear_allocator::get_size().
-			explicit linear_allocator(std::size_t size);
+			explicit linear_allocator(
+				std::size_t size,
+				int flags = 0,
+				std::size_t chunk_size = default_chunk_size);
+
+			// Constructs the linear allocator on top of an existing memory region,
+			// taking ownership of it.
+			//
+			// This allows allocating from memory other than anonymous pages, such
+			// as a shared memory region; see holo::linear_allocator::get_offset(
+			// const void*). The region must be empty or already committed, and
+			// writable. 'flags' and 'chunk_size' behave as above.
+			explicit linear_allocator(
+				holo::memory_region&& region,
+				int flags = 0,
+				std::size_t chunk_size = default_chunk_size);
 			
 			// Releases all resources allocated by the holo::linear
 			~linear_allocator();
@@ -51,11 +88,24 @@ namespace holo
 			// holo::linear_allocator::reset().
 			void deallocate(void* pointer) override;
 
+			// Sized deallocation does nothing as well.
+			using holo::allocator::deallocate;
+
 			// Resets the linear allocator.
 			//
-			// All memory previously allocated is now considered free.
+			// All memory previously allocated is now considered free. If the
+			// allocator commits lazily, memory committed past the high-water mark
+			// is decommitted.
 			void reset();
 
+			// Sets the high-water mark of a lazily committed allocator.
+			//
+			// On reset, committed memory past 'size' bytes is returned to the
+			// platform, while memory up to the mark stays committed for the next
+			// round of allocations. By default, the mark is the size of the
+			// allocator, so nothing is decommitted.
+			void set_high_water_mark(std::size_t size);
+
 			// Stores the state of the allocator, allowing only portions of memory
 			// to be deallocated, rather than the entire region.
 			//
@@ -78,13 +128,58 @@ namespace holo
 			// or equal to the requested size. If creation of the memory region
 			// failed, then this value will be 0.
 			std::size_t get_size() const;
+
+			// Gets the number of bytes currently committed.
+			//
+			// Unless the allocator commits lazily, this is the same as
+			// holo::linear_allocator::get_size().
+			std::size_t get_committed_size() const;
+
+			// Gets the offset of 'pointer' from the beginning of the memory region.
+			//
+			// For an allocator on top of a shared memory region, other processes
+			// can resolve the offset against their own mapping of the region.
+			std::size_t get_offset(const void* pointer) const;
+
+			// Gets a pointer to the memory 'offset' bytes from the beginning of the
+			// memory region.
+			void* get_pointer(std::size_t offset) const;
+
+			// Enables or disables gathering allocation statistics.
+			//
+			// Statistics are disabled by default.
+			void set_statistics_enabled(bool enable);
+
+			// Takes a snapshot of the allocation statistics.
+			//
+			// Live bytes are the bytes in use since the last reset, including
+			// alignment padding and markers. Since popping a marker does not know
+			// how many objects it released, live objects are only cleared by
+			// holo::linear_allocator::reset().
+			//
+			// This method can be called from any thread.
+			void get_statistics(holo::allocation_statistics* statistics) const;
 			
 		private:
+			// Commits enough of the region for the first 'size' bytes.
+			//
+			// Returns false if the memory could not be committed.
+			bool commit(std::size_t size);
+
 			// Memory region used to back allocations.
 			//
 			// The entire region will be committed on construction of the linear
-			// allocator.
+			// allocator, unless flag_commit_lazily was provided.
 			holo::memory_region memory_region;
+
+			// Flags provided on construction.
+			int flags;
+
+			// Number of bytes committed at a time, when committing lazily.
+			std::size_t chunk_size;
+
+			// Committed memory past this many bytes is decommitted on reset.
+			std::size_t high_water_mark;
 			
 			// Pointer to the beginning of the memory region.
 			void* memory;
@@ -99,6 +194,9 @@ namespace holo
 			//
 			// If zero, this means that no marker was allocated.
 			std::size_t current_marker;
+
+			// Allocation statistics.
+			holo::allocation_counter counter;
 	};
 }
 
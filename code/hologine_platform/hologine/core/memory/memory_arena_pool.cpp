@@ -9,35 +9,90 @@
 // directory of the source package.
 #include <utility>
 #include <algorithm>
-#include <cstring>
+#include <limits>
+#include <new>
 #include "core/platform.hpp"
+#include "core/math/bits.hpp"
+#include "core/math/util.hpp"
 #include "core/memory/memory_region.hpp"
 #include "core/memory/memory_arena_pool.hpp"
+#include "core/threading/scoped_lock.hpp"
+
+namespace
+{
+	// Mask of the index portion of the free stack head.
+	const std::uint64_t free_arena_index_mask = 0xffffffffu;
+
+	// Amount added to the free stack head to increment the tag.
+	const std::uint64_t free_arena_tag_step = (std::uint64_t)1 << 32;
+}
 
 holo::memory_arena_pool::memory_arena_pool(
 	std::size_t arena_size_hint,
-	std::size_t arena_count_hint) :
+	std::size_t arena_count_hint,
+	int flags) :
 		memory_region(),
 		records(nullptr),
-		next_free_arena(nullptr),
+		free_arena_head(0),
 		arena_pool(nullptr),
-		arena_size(arena_size_hint),
-		arena_reserved(arena_count_hint),
-		arena_count(0)
+		arena_size(0),
+		arena_shift(0),
+		commit_size(0),
+		arena_reserved(std::min<std::size_t>(arena_count_hint, free_arena_index_mask - 1)),
+		arena_count(0),
+		flags(flags),
+		scavenge_tick(0),
+		decommitted_arena_count(0),
+		arenas_in_use(0),
+		peak_arenas_in_use(0),
+		committed_size(0),
+		idle_ticks(default_idle_ticks),
+		free_arena_watermark(std::numeric_limits<std::size_t>::max())
 {
-	std::size_t record_size = std::max(
-		std::max(holo::memory_region::get_page_size(), holo::memory_region::get_granularity()),
-		arena_count_hint * sizeof(arena_record));
-	std::size_t arena_span_size = arena_size_hint * arena_count_hint;
-	memory_region = std::move(holo::memory_region(record_size + arena_span_size));
+	std::size_t page_size = holo::memory_region::get_page_size();
+
+	// Arenas must be a power of two so a pointer can be mapped to its arena with
+	// a shift, rather than a division. An arena smaller than a page would make
+	// no sense, since arenas are committed individually.
+	arena_size = math::next_power_of_two(std::max(arena_size_hint, page_size));
+	arena_shift = math::bit_log2(arena_size);
+
+	// Align the span of arenas on the arena size, so the base of an arena is
+	// simply a masked pointer. When backed by huge pages, the span must also
+	// be aligned on (and committed in) huge pages, otherwise the pages can't
+	// be collapsed.
+	std::size_t span_alignment = arena_size;
+	commit_size = arena_size;
+	if (flags & flag_huge_pages)
+	{
+		span_alignment = std::max(arena_size, holo::memory_region::get_huge_page_size());
+		commit_size = span_alignment;
+	}
+
+	std::size_t record_size = math::round_up(
+		std::max(arena_reserved * sizeof(arena_record), page_size),
+		std::max(page_size, holo::memory_region::get_granularity()));
+	std::size_t arena_span_size = math::round_up(
+		std::max(arena_size * arena_reserved, commit_size),
+		commit_size);
+
+	// The base of the region is only guaranteed to be page-aligned, so reserve
+	// enough padding to align the arena span.
+	std::size_t region_size = record_size + (span_alignment - page_size) + arena_span_size;
+	int region_flags = (flags & flag_huge_pages) ? holo::memory_region::flag_huge_pages : 0;
+	memory_region = std::move(holo::memory_region(region_size, region_flags));
 
 	void* base_pointer = memory_region.grow(record_size);
 	if (base_pointer != nullptr)
 	{
 		records = (arena_record*)base_pointer;
-		std::memset(records, 0, record_size);
+		for (std::size_t i = 0; i < arena_reserved; ++i)
+		{
+			new(&records[i]) arena_record();
+		}
+		committed_size.store(memory_region.get_current_size(), std::memory_order_relaxed);
 
-		arena_pool = (char*)base_pointer + record_size;
+		arena_pool = holo::allocator::align_pointer((char*)base_pointer + record_size, span_alignment);
 	}
 }
 
@@ -48,12 +103,16 @@ holo::memory_arena_pool::~memory_arena_pool()
 
 std::size_t holo::memory_arena_pool::reserve(std::size_t count)
 {
+	holo::scoped_lock lock(growth_mutex);
+
 	std::size_t reserved = 0;
 	while (reserved < count)
 	{
-		if (!allocate_arena())
+		arena_record* record = allocate_arena();
+		if (record == nullptr)
 			break;
 
+		push_free_arena(record);
 		++reserved;
 	}
 
@@ -62,19 +121,39 @@ std::size_t holo::memory_arena_pool::reserve(std::size_t count)
 
 holo::memory_arena_pool::arena_record* holo::memory_arena_pool::take_arena()
 {
-	arena_record* record = nullptr;
-	
-	if (next_free_arena == nullptr && !allocate_arena())
+	arena_record* record = pop_free_arena();
+
+	if (record == nullptr)
+	{
+		holo::scoped_lock lock(growth_mutex);
+
+		// Another thread may have returned an arena while we were waiting for
+		// the lock; prefer it over committing more memory.
+		record = pop_free_arena();
+		if (record == nullptr)
+		{
+			record = allocate_arena();
+			if (record == nullptr)
+			{
+				return nullptr;
+			}
+		}
+	}
+
+	if (record->decommitted && !recommit_arena(record))
 	{
-		// We couldn't allocate a new region for some reason.
+		// Leave the arena on the free stack for a later attempt.
+		push_free_arena(record);
+
 		return nullptr;
 	}
-	else
+
+	std::size_t in_use = arenas_in_use.fetch_add(1, std::memory_order_relaxed) + 1;
+	std::size_t peak = peak_arenas_in_use.load(std::memory_order_relaxed);
+	while (in_use > peak && !peak_arenas_in_use.compare_exchange_weak(
+		peak, in_use, std::memory_order_relaxed))
 	{
-		record = next_free_arena;
-		
-		// Update the head of the free list.
-		next_free_arena = record->next;
+		// Nothing.
 	}
 
 	return record;
@@ -85,24 +164,27 @@ void holo::memory_arena_pool::give_arena(arena_record* record)
 	record->allocator = nullptr;
 	record->free_node_count = 0;
 	record->free_node_list = nullptr;
+	record->remote_free_list.store(nullptr, std::memory_order_relaxed);
+	record->next = nullptr;
 	record->previous = nullptr;
+	record->free_tick = scavenge_tick.load(std::memory_order_relaxed);
 
-	if (next_free_arena)
-	{
-		record->next = next_free_arena;
-	}
+	arenas_in_use.fetch_sub(1, std::memory_order_relaxed);
 
-	next_free_arena = record;
+	push_free_arena(record);
 }
 
 holo::memory_arena_pool::arena_record* holo::memory_arena_pool::get_arena(void* pointer)
 {
-	void* begin = arena_pool;
-	void* end = (char*)arena_pool + arena_count * arena_size;
+	// A pointer below the arena span wraps around to a massive offset, so the
+	// single comparison against the arena count handles both bounds.
+	holo::unsigned_pointer offset =
+		(holo::unsigned_pointer)pointer - (holo::unsigned_pointer)arena_pool;
+	std::size_t index = offset >> arena_shift;
 
-	if (pointer >= begin && pointer < end)
+	if (index < arena_count.load(std::memory_order_acquire))
 	{
-		return &records[((holo::unsigned_pointer)pointer - (holo::unsigned_pointer)begin) / arena_size];
+		return &records[index];
 	}
 
 	return nullptr;
@@ -113,9 +195,16 @@ std::size_t holo::memory_arena_pool::get_arena_size() const
 	return arena_size;
 }
 
+std::size_t holo::memory_arena_pool::get_arena_index(const arena_record* record) const
+{
+	holo_assert(record >= records && record < records + arena_reserved);
+
+	return record - records;
+}
+
 std::size_t holo::memory_arena_pool::get_arena_count() const
 {
-	return arena_count;
+	return arena_count.load(std::memory_order_acquire);
 }
 
 std::size_t holo::memory_arena_pool::get_reserved_arena_count() const
@@ -123,24 +212,212 @@ std::size_t holo::memory_arena_pool::get_reserved_arena_count() const
 	return arena_reserved;
 }
 
-bool holo::memory_arena_pool::allocate_arena()
+int holo::memory_arena_pool::get_flags() const
+{
+	return flags;
+}
+
+void holo::memory_arena_pool::set_scavenge_policy(
+	std::size_t idle_ticks,
+	std::size_t free_arena_watermark)
+{
+	holo::scoped_lock lock(growth_mutex);
+
+	this->idle_ticks = idle_ticks;
+	this->free_arena_watermark = free_arena_watermark;
+}
+
+std::size_t holo::memory_arena_pool::scavenge()
+{
+	holo::scoped_lock lock(growth_mutex);
+
+	std::size_t tick = scavenge_tick.fetch_add(1, std::memory_order_relaxed) + 1;
+
+	// An arena can only be decommitted on its own if it doesn't share a commit
+	// step with another arena.
+	if (commit_size != arena_size || records == nullptr)
+	{
+		return 0;
+	}
+
+	// Detach the entire free stack. Concurrent calls to take_arena() will find
+	// it empty and wait on the growth mutex, rather than commit a new arena.
+	std::uint64_t head = free_arena_head.load(std::memory_order_acquire);
+	while (!free_arena_head.compare_exchange_weak(
+		head, (head & ~free_arena_index_mask) + free_arena_tag_step,
+		std::memory_order_acquire, std::memory_order_acquire))
+	{
+		// Nothing.
+	}
+
+	std::size_t first = (std::size_t)(head & free_arena_index_mask);
+	if (first == 0)
+	{
+		return 0;
+	}
+
+	// The stack is ordered from most to least recently freed, so the arenas
+	// kept by the watermark are the ones most likely to be reused soon.
+	std::size_t committed_count = 0;
+	std::size_t decommitted_count = 0;
+	std::size_t last = first;
+	for (std::size_t index = first; index != 0;)
+	{
+		arena_record* record = &records[index - 1];
+
+		if (!record->decommitted)
+		{
+			bool is_idle = tick - record->free_tick >= idle_ticks;
+			if (is_idle || committed_count >= free_arena_watermark)
+			{
+				memory_region.decommit(
+					holo::allocator::get_pointer_distance(record->base, records),
+					arena_size);
+				record->decommitted = true;
+				committed_size.fetch_sub(arena_size, std::memory_order_relaxed);
+
+				++decommitted_count;
+			}
+			else
+			{
+				++committed_count;
+			}
+		}
+
+		last = index;
+		index = record->next_free_arena.load(std::memory_order_relaxed);
+	}
+
+	decommitted_arena_count.fetch_add(decommitted_count, std::memory_order_relaxed);
+
+	// Splice the detached stack back on top of any arenas given back in the
+	// meantime.
+	head = free_arena_head.load(std::memory_order_relaxed);
+	std::uint64_t new_head;
+	do
+	{
+		records[last - 1].next_free_arena.store(
+			(std::size_t)(head & free_arena_index_mask),
+			std::memory_order_relaxed);
+
+		new_head = ((head & ~free_arena_index_mask) + free_arena_tag_step) | first;
+	} while (!free_arena_head.compare_exchange_weak(
+		head, new_head,
+		std::memory_order_release, std::memory_order_relaxed));
+
+	return decommitted_count;
+}
+
+std::size_t holo::memory_arena_pool::get_decommitted_arena_count() const
+{
+	return decommitted_arena_count.load(std::memory_order_relaxed);
+}
+
+void holo::memory_arena_pool::get_statistics(statistics* statistics) const
+{
+	statistics->arena_size = arena_size;
+	statistics->reserved_arenas = arena_reserved;
+	statistics->allocated_arenas = arena_count.load(std::memory_order_acquire);
+	statistics->decommitted_arenas = decommitted_arena_count.load(std::memory_order_relaxed);
+	statistics->arenas_in_use = arenas_in_use.load(std::memory_order_relaxed);
+	statistics->peak_arenas_in_use = peak_arenas_in_use.load(std::memory_order_relaxed);
+	statistics->reserved_bytes = memory_region.get_reserved_size();
+	statistics->committed_bytes = committed_size.load(std::memory_order_relaxed);
+}
+
+holo::memory_arena_pool::arena_record* holo::memory_arena_pool::allocate_arena()
 {
-	if (arena_count < arena_reserved)
+	// Only the thread holding the growth mutex modifies the count.
+	std::size_t index = arena_count.load(std::memory_order_relaxed);
+
+	if (index < arena_reserved && records != nullptr)
 	{
-		void* base_pointer = memory_region.grow(arena_size);
+		// Commit the region up to the end of the new arena, rounded up to the
+		// commit step. Every step is a multiple of the page size, so the
+		// committed size of the region is exact.
+		std::size_t arena_span_end = math::round_up((index + 1) * arena_size, commit_size);
+		std::size_t committed_end =
+			holo::allocator::get_pointer_distance(arena_pool, records) + arena_span_end;
+		std::size_t current_size = memory_region.get_current_size();
 
-		if (base_pointer)
+		if (committed_end > current_size)
 		{
-			records[arena_count].base = (char*)arena_pool + arena_count * arena_size;
+			if (memory_region.grow(committed_end - current_size) == nullptr)
+			{
+				return nullptr;
+			}
 
-			records[arena_count].next = next_free_arena;
-			next_free_arena = &records[arena_count];
+			committed_size.fetch_add(committed_end - current_size, std::memory_order_relaxed);
+		}
+
+		arena_record* record = &records[index];
+		record->base = (char*)arena_pool + index * arena_size;
 
-			++arena_count;
+		arena_count.store(index + 1, std::memory_order_release);
 
-			return true;
+		return record;
+	}
+
+	return nullptr;
+}
+
+void holo::memory_arena_pool::push_free_arena(arena_record* record)
+{
+	std::uint64_t index = (std::uint64_t)(record - records) + 1;
+	std::uint64_t head = free_arena_head.load(std::memory_order_relaxed);
+	std::uint64_t new_head;
+
+	do
+	{
+		record->next_free_arena.store(
+			(std::size_t)(head & free_arena_index_mask),
+			std::memory_order_relaxed);
+
+		new_head = ((head & ~free_arena_index_mask) + free_arena_tag_step) | index;
+	} while (!free_arena_head.compare_exchange_weak(
+		head, new_head,
+		std::memory_order_release, std::memory_order_relaxed));
+}
+
+holo::memory_arena_pool::arena_record* holo::memory_arena_pool::pop_free_arena()
+{
+	std::uint64_t head = free_arena_head.load(std::memory_order_acquire);
+	std::uint64_t new_head;
+	arena_record* record;
+
+	do
+	{
+		std::size_t index = (std::size_t)(head & free_arena_index_mask);
+		if (index == 0)
+		{
+			return nullptr;
 		}
+
+		// If the record was taken by another thread in the meantime, this value
+		// may be stale; the tag guarantees the exchange below fails if so.
+		record = &records[index - 1];
+		std::uint64_t next = record->next_free_arena.load(std::memory_order_relaxed);
+
+		new_head = ((head & ~free_arena_index_mask) + free_arena_tag_step) | next;
+	} while (!free_arena_head.compare_exchange_weak(
+		head, new_head,
+		std::memory_order_acquire, std::memory_order_acquire));
+
+	return record;
+}
+
+bool holo::memory_arena_pool::recommit_arena(arena_record* record)
+{
+	if (!memory_region.recommit(
+		holo::allocator::get_pointer_distance(record->base, records),
+		arena_size))
+	{
+		return false;
 	}
 
-	return false;
+	record->decommitted = false;
+	committed_size.fetch_add(arena_size, std::memory_order_relaxed);
+	decommitted_arena_count.fetch_sub(1, std::memory_order_relaxed);
+
+	return true;
 }
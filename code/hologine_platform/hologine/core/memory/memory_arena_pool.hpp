@@ -10,8 +10,11 @@
 #ifndef HOLOGINE_CORE_MEMORY_MEMORY_ARENA_HPP_
 #define HOLOGINE_CORE_MEMORY_MEMORY_ARENA_HPP_
 
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include "core/memory/memory_region.hpp"
+#include "core/threading/mutex.hpp"
 
 namespace holo
 {
@@ -19,12 +22,34 @@ namespace holo
 
 	// Reserves a large portion of virtual memory and divides it up for
 	// holo::allocator instances.
+	//
+	// Arenas are a power of two in size and the span of arenas is aligned on
+	// the arena size. Thus the arena a pointer belongs to can be found with a
+	// subtraction and a shift (see holo::memory_arena_pool::get_arena(void*)),
+	// and the base of an arena by masking the pointer.
+	//
+	// Taking and giving arenas is lock-free, so a single pool can feed
+	// allocators living on different threads. Only growing the pool (i.e.,
+	// committing a new arena) is serialized.
 	class memory_arena_pool final
 	{
 		memory_arena_pool(const memory_arena_pool&) = delete;
 		memory_arena_pool& operator =(const memory_arena_pool&) = delete;
 		
 		public:
+			// Flags that modify the behavior of the arena pool.
+			enum
+			{
+				// Back the arenas with huge pages.
+				//
+				// The span of arenas will be aligned to a huge page boundary and
+				// committed in huge page sized steps, so that each step can be backed
+				// by a single huge page. This greatly reduces TLB misses when many
+				// arenas are in use, at the cost of committing up to a huge page
+				// ahead of the arenas actually in use.
+				flag_huge_pages = 0x00000001
+			};
+
 			// Represents a free node.
 			struct allocator_free_node
 			{
@@ -54,6 +79,13 @@ namespace holo
 				// Pointer to the first free node.
 				allocator_free_node* free_node_list;
 
+				// Singly linked list of objects freed by threads other than the one
+				// owning the allocator, waiting to be reclaimed by the owner.
+				//
+				// Any thread may push onto the list, but only the owner may take
+				// from it.
+				std::atomic<void*> remote_free_list;
+
 				// Pointer to the next arena.
 				arena_record* next;
 
@@ -61,10 +93,65 @@ namespace holo
 				//
 				// Implementation note: this is unused by the arena pool.
 				arena_record* previous;
+
+				// Index of the next arena on the free stack, plus one, or zero if
+				// this is the last free arena.
+				//
+				// Implementation note: this is private to the arena pool. It is kept
+				// apart from 'next' because a thread popping the free stack may read
+				// it after another thread has taken the arena.
+				std::atomic<std::size_t> next_free_arena;
+
+				// The scavenge tick when the arena was last given back to the pool.
+				//
+				// Implementation note: this is private to the arena pool.
+				std::size_t free_tick;
+
+				// True if the arena's pages have been decommitted by the scavenger.
+				//
+				// Implementation note: this is private to the arena pool.
+				bool decommitted;
+			};
+
+			// A snapshot of the usage of the arena pool.
+			struct statistics
+			{
+				// Size of an individual arena, in bytes.
+				std::size_t arena_size;
+
+				// Number of arenas the pool can hold.
+				std::size_t reserved_arenas;
+
+				// Number of arenas allocated so far, including decommitted ones.
+				std::size_t allocated_arenas;
+
+				// Number of arenas decommitted by the scavenger.
+				std::size_t decommitted_arenas;
+
+				// Number of arenas currently taken.
+				std::size_t arenas_in_use;
+
+				// The largest value 'arenas_in_use' has reached.
+				std::size_t peak_arenas_in_use;
+
+				// Bytes of address space reserved by the pool.
+				std::size_t reserved_bytes;
+
+				// Bytes of memory committed by the pool, including the arena records.
+				std::size_t committed_bytes;
 			};
 
 			// Reserves 'arena_count_hint' arenas of 'arena_size_hint' size.
-			memory_arena_pool(std::size_t arena_size_hint, std::size_t arena_count_hint);
+			//
+			// The arena size is rounded up to the next power of two, and to at
+			// least the page size. See holo::memory_arena_pool::get_arena_size().
+			//
+			// 'flags' modifies the behavior of the arena pool; see the enumeration
+			// above.
+			memory_arena_pool(
+				std::size_t arena_size_hint,
+				std::size_t arena_count_hint,
+				int flags = 0);
 
 			// Releases the arenas.
 			~memory_arena_pool();
@@ -78,15 +165,36 @@ namespace holo
 			std::size_t reserve(std::size_t count);
 			
 			// Returns an arena, creating one if necessary.
+			//
+			// If the arena was decommitted by the scavenger, it is committed again
+			// before being returned.
+			//
+			// This method is thread safe. It only blocks if the free stack is empty
+			// and a new arena must be committed.
 			arena_record* take_arena();
 			
 			// Releases an arena previously allocated by the pool.
+			//
+			// This method is thread safe and lock-free.
 			void give_arena(arena_record* record);
 
 			// Gets the arena a pointer resides in.
+			//
+			// Returns NULL if the pointer does not belong to an allocated arena.
+			//
+			// This method is thread safe.
 			arena_record* get_arena(void* pointer);
 
+			// Gets the index of an arena in the pool.
+			//
+			// Arenas are numbered in address order from zero, and the index is
+			// always less than holo::memory_arena_pool::get_reserved_arena_count().
+			std::size_t get_arena_index(const arena_record* record) const;
+
 			// Gets the size of an arena.
+			//
+			// This value is a power of two, and may be larger than the hint provided
+			// in the constructor.
 			std::size_t get_arena_size() const;
 
 			// Gets the number of arenas currently allocated.
@@ -96,10 +204,63 @@ namespace holo
 			//
 			// This is equivalent to the count hint provided in the constructor.
 			std::size_t get_reserved_arena_count() const;
+
+			// Gets the flags provided when the arena pool was constructed.
+			int get_flags() const;
+
+			// Sets the policy used by holo::memory_arena_pool::scavenge().
+			//
+			// A free arena is decommitted once it has been free for 'idle_ticks'
+			// calls to holo::memory_arena_pool::scavenge(). Regardless of how long
+			// they have been idle, only the 'free_arena_watermark' most recently
+			// freed arenas are kept committed.
+			//
+			// By default, arenas are decommitted after being idle for
+			// holo::memory_arena_pool::default_idle_ticks ticks, and there is no
+			// watermark.
+			void set_scavenge_policy(std::size_t idle_ticks, std::size_t free_arena_watermark);
+
+			// Advances the scavenge tick and decommits free arenas according to the
+			// scavenge policy.
+			//
+			// This method is meant to be called regularly, such as from a
+			// maintenance tick or a low-priority thread. It is thread safe, though
+			// takes the same lock as growing the pool.
+			//
+			// Arenas smaller than the commit step (e.g., when backed by huge pages
+			// larger than an arena) share pages with their neighbors and are never
+			// decommitted.
+			//
+			// Returns the number of arenas decommitted.
+			std::size_t scavenge();
+
+			// Gets the number of arenas currently decommitted by the scavenger.
+			std::size_t get_decommitted_arena_count() const;
+
+			// Takes a snapshot of the usage of the arena pool.
+			//
+			// This method is thread safe.
+			void get_statistics(statistics* statistics) const;
+
+			// The default number of ticks a free arena must be idle before being
+			// decommitted.
+			static const std::size_t default_idle_ticks = 60;
 		
 		private:
-			// Allocates a new arena.
-			bool allocate_arena();
+			// Commits a new arena and returns its record.
+			//
+			// The record is not placed on the free stack. The growth mutex must be
+			// held.
+			arena_record* allocate_arena();
+
+			// Pushes an arena on the free stack.
+			void push_free_arena(arena_record* record);
+
+			// Pops an arena from the free stack, returning NULL if it is empty.
+			arena_record* pop_free_arena();
+
+			// Commits the pages of an arena decommitted by the scavenger.
+			bool recommit_arena(arena_record* record);
 
 			// The backing memory region.
 			holo::memory_region memory_region;
@@ -107,20 +268,67 @@ namespace holo
 			// Array of arena records.
 			arena_record* records;
 
-			// Next free arena.
-			arena_record* next_free_arena;
+			// Head of the free stack.
+			//
+			// The lower half is the index of the top arena plus one (zero if the
+			// stack is empty); the upper half is a tag incremented on every update,
+			// which prevents a stale pop from succeeding (the ABA problem).
+			std::atomic<std::uint64_t> free_arena_head;
+
+			// Serializes committing new arenas.
+			holo::mutex growth_mutex;
 
 			// Pointer to the arena pool.
 			void* arena_pool;
 
 			// Size of an individual arena.
 			std::size_t arena_size;
+
+			// The log2 of the arena size; used to find the arena a pointer belongs
+			// to.
+			std::size_t arena_shift;
+
+			// The step, in bytes, the arena span is committed in.
+			//
+			// This is the arena size, unless huge pages are requested, in which
+			// case it is the larger of the arena size or the huge page size.
+			std::size_t commit_size;
 			
 			// Total number of arenas reserved.
 			std::size_t arena_reserved;
 
-			// Last allocated arena.
-			std::size_t arena_count;
+			// Number of arenas committed.
+			//
+			// This is published after the arena's record is initialized, so any
+			// thread that observes the count can safely read the records below it.
+			std::atomic<std::size_t> arena_count;
+
+			// Flags that modify the behavior of the arena pool.
+			int flags;
+
+			// The current scavenge tick.
+			std::atomic<std::size_t> scavenge_tick;
+
+			// Number of arenas decommitted by the scavenger.
+			std::atomic<std::size_t> decommitted_arena_count;
+
+			// Number of arenas currently taken.
+			std::atomic<std::size_t> arenas_in_use;
+
+			// The most arenas that have been taken at once.
+			std::atomic<std::size_t> peak_arenas_in_use;
+
+			// Bytes of the memory region currently committed.
+			//
+			// The region itself may only be queried under the growth mutex, so
+			// this is tracked separately for holo::memory_arena_pool::get_statistics().
+			std::atomic<std::size_t> committed_size;
+
+			// Ticks a free arena must be idle before it is decommitted.
+			std::size_t idle_ticks;
+
+			// Number of free arenas kept committed regardless of idle time.
+			std::size_t free_arena_watermark;
 	};
 }
 
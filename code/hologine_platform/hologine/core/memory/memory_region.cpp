@@ -10,44 +10,80 @@
 #include <algorithm>
 #include <utility>
 #include "core/exception.hpp"
+#include "core/io/binary_reader.hpp"
+#include "core/io/binary_writer.hpp"
+#include "core/io/endianness.hpp"
+#include "core/io/stream_interface.hpp"
 #include "core/math/util.hpp"
 #include "core/memory/memory_region.hpp"
 
 holo::memory_region::memory_region(holo::memory_region&& other) :
+	memory_region_base(std::move(other)),
 	max_size(other.max_size),
 	current_size(other.current_size),
-	memory(other.memory)
+	memory(other.memory),
+	flags(other.flags)
 {
 	other.max_size = 0;
 	other.current_size = 0;
 	other.memory = nullptr;
+	other.flags = 0;
 }
 
 holo::memory_region& holo::memory_region::operator =(holo::memory_region&& other)
 {
+	memory_region_base::operator =(std::move(other));
+
 	max_size = other.max_size;
 	current_size = other.current_size;
 	memory = other.memory;
+	flags = other.flags;
 	
 	other.max_size = 0;
 	other.current_size = 0;
 	other.memory = nullptr;
+	other.flags = 0;
 
 	return *this;
 }
 
 holo::memory_region::memory_region() :
-	max_size(0), current_size(0), memory(nullptr)
+	max_size(0), current_size(0), memory(nullptr), flags(0)
 {
 	// Nothing.
 }
 
-holo::memory_region::memory_region(std::size_t max_size) :
-	max_size(max_size), current_size(0), memory(nullptr)
+holo::memory_region::memory_region(std::size_t max_size, int flags) :
+	max_size(max_size), current_size(0), memory(nullptr), flags(flags)
 {
 	// Nothing.
 }
 
+holo::memory_region::memory_region(const char* path, int flags) :
+	max_size(0), current_size(0), memory(nullptr), flags(flags)
+{
+	std::size_t file_size;
+	bool success;
+
+	if (flags & flag_shared_memory)
+	{
+		success = open_shared_memory(path, false, (flags & flag_shared_writable) != 0, &file_size);
+	}
+	else
+	{
+		success = open_file(
+			path,
+			(flags & flag_copy_on_write) != 0,
+			(flags & flag_populate_pages) != 0,
+			&file_size);
+	}
+
+	if (success)
+	{
+		max_size = file_size;
+	}
+}
+
 holo::memory_region::~memory_region()
 {
 	// Easy-peasy.
@@ -86,7 +122,16 @@ void* holo::memory_region::grow(std::size_t size)
 			return nullptr;
 		}
 
-		memory = reserve_pages(get_reserved_size() / get_page_size());
+		if (flags & flag_mirrored)
+		{
+			holo_assert(!(flags & flag_track_dirty_pages) && !is_file_open());
+
+			memory = reserve_mirrored_pages(get_reserved_size() / get_page_size());
+		}
+		else
+		{
+			memory = reserve_pages(get_reserved_size() / get_page_size());
+		}
 		
 		// Failed to reserve pages; return NULL and hope the caller can figure
 		// out the rest.
@@ -94,6 +139,24 @@ void* holo::memory_region::grow(std::size_t size)
 		{
 			return nullptr;
 		}
+
+		// The hint only has to be given once, since pages are committed from the
+		// reserved range.
+		if (flags & flag_huge_pages)
+		{
+			advise_huge_pages(memory, 0, get_reserved_size() / get_page_size());
+		}
+
+		if (flags & flag_track_dirty_pages)
+		{
+			if (!begin_tracking_pages(memory, get_reserved_size() / get_page_size()))
+			{
+				release_pages(memory, 0, get_reserved_size() / get_page_size());
+				memory = nullptr;
+
+				return nullptr;
+			}
+		}
 	}
 	
 	std::size_t new_size = size + current_size;
@@ -120,6 +183,12 @@ void* holo::memory_region::grow(std::size_t size)
 			// The memory region could not grow for any variety of reasons.
 			return nullptr;
 		}
+
+		// The new pages differ from whatever the last snapshot held.
+		if (flags & flag_track_dirty_pages)
+		{
+			mark_pages_dirty(memory, current_page_count, new_page_count - current_page_count);
+		}
 	}
 	
 	// Adjust the current size with the new data to track how much the memory
@@ -133,6 +202,30 @@ void* holo::memory_region::grow(std::size_t size)
 	return memory;
 }
 
+void holo::memory_region::shrink(std::size_t size)
+{
+	holo_assert(size <= current_size);
+
+	std::size_t new_size = current_size - size;
+
+	std::size_t current_page_count =
+		current_size == 0 ? 0 : math::multiple_of(current_size, get_page_size());
+	std::size_t new_page_count =
+		new_size == 0 ? 0 : math::multiple_of(new_size, get_page_size());
+
+	if (new_page_count < current_page_count)
+	{
+		decommit_pages(memory, new_page_count, current_page_count - new_page_count);
+
+		if (flags & flag_track_dirty_pages)
+		{
+			mark_pages_untracked(memory, new_page_count, current_page_count - new_page_count);
+		}
+	}
+
+	current_size = new_size;
+}
+
 void holo::memory_region::reset(bool release)
 {
 	// This is a no-op if memory hasn't yet been reserved.
@@ -144,6 +237,11 @@ void holo::memory_region::reset(bool release)
 			std::size_t current_page_count = math::multiple_of(current_size, get_page_size());
 			
 			decommit_pages(memory, 0, current_page_count);
+
+			if (flags & flag_track_dirty_pages)
+			{
+				mark_pages_untracked(memory, 0, current_page_count);
+			}
 			
 			// Reset the current size.
 			current_size = 0;
@@ -153,12 +251,273 @@ void holo::memory_region::reset(bool release)
 		// 'release' is true); otherwise, memory is just deallocated (see above).
 		if (release)
 		{
+			if (flags & flag_track_dirty_pages)
+			{
+				end_tracking_pages(memory);
+			}
+
 			release_pages(memory, 0, get_reserved_size() / get_page_size());
 			memory = nullptr;
 		}
 	}
 }
 
+void holo::memory_region::decommit(std::size_t offset, std::size_t size)
+{
+	holo_assert(memory != nullptr);
+	holo_assert(offset % get_page_size() == 0);
+	holo_assert(size % get_page_size() == 0);
+
+	if (size > 0)
+	{
+		decommit_pages(memory, offset / get_page_size(), size / get_page_size());
+
+		if (flags & flag_track_dirty_pages)
+		{
+			mark_pages_untracked(memory, offset / get_page_size(), size / get_page_size());
+		}
+	}
+}
+
+bool holo::memory_region::recommit(std::size_t offset, std::size_t size)
+{
+	holo_assert(memory != nullptr);
+	holo_assert(offset % get_page_size() == 0);
+	holo_assert(size % get_page_size() == 0);
+
+	if (size == 0)
+	{
+		return true;
+	}
+
+	if (!commit_pages(memory, offset / get_page_size(), size / get_page_size()))
+	{
+		return false;
+	}
+
+	if (flags & flag_track_dirty_pages)
+	{
+		mark_pages_dirty(memory, offset / get_page_size(), size / get_page_size());
+	}
+
+	return true;
+}
+
+void holo::memory_region::prefetch(std::size_t offset, std::size_t size)
+{
+	holo_assert(memory != nullptr);
+	holo_assert(offset + size <= get_current_size());
+
+	if (size == 0)
+	{
+		return;
+	}
+
+	std::size_t first_page = offset / get_page_size();
+	std::size_t end_page = math::multiple_of(offset + size, get_page_size());
+
+	advise_will_need(memory, first_page, end_page - first_page);
+}
+
+bool holo::memory_region::is_file_backed() const
+{
+	return is_file_open();
+}
+
+std::size_t holo::memory_region::get_file_size() const
+{
+	return is_file_open() ? max_size : 0;
+}
+
+bool holo::memory_region::is_shared_memory() const
+{
+	return is_file_open() && (flags & flag_shared_memory);
+}
+
+std::size_t holo::memory_region::get_offset(const void* pointer) const
+{
+	holo_assert(memory != nullptr);
+	holo_assert(pointer >= memory && pointer < (char*)memory + get_reserved_size());
+
+	return holo::allocator::get_pointer_distance((void*)pointer, memory);
+}
+
+void* holo::memory_region::get_pointer(std::size_t offset) const
+{
+	holo_assert(memory != nullptr);
+	holo_assert(offset < get_reserved_size());
+
+	return (char*)memory + offset;
+}
+
+bool holo::memory_region::is_page_dirty(std::size_t offset) const
+{
+	holo_assert(flags & flag_track_dirty_pages);
+	holo_assert(offset < get_current_size());
+
+	return memory_region_base::is_page_dirty(memory, offset / get_page_size());
+}
+
+std::size_t holo::memory_region::get_dirty_size() const
+{
+	holo_assert(flags & flag_track_dirty_pages);
+
+	std::size_t page_count = get_committed_page_count();
+	std::size_t dirty_page_count = 0;
+
+	for (std::size_t i = 0; i < page_count; ++i)
+	{
+		if (memory_region_base::is_page_dirty(memory, i))
+		{
+			++dirty_page_count;
+		}
+	}
+
+	return dirty_page_count * get_page_size();
+}
+
+bool holo::memory_region::clear_dirty_pages()
+{
+	holo_assert(flags & flag_track_dirty_pages);
+
+	std::size_t page_count = get_committed_page_count();
+	if (page_count == 0)
+	{
+		return true;
+	}
+
+	return memory_region_base::clear_dirty_pages(memory, 0, page_count);
+}
+
+bool holo::memory_region::write_snapshot(holo::stream_interface* stream)
+{
+	holo_assert(flags & flag_track_dirty_pages);
+
+	holo::binary_writer writer(stream, holo::endianness::little);
+	if (!writer.write_ulong(current_size))
+	{
+		push_exception(exception::invalid_operation);
+
+		return false;
+	}
+
+	// Write each run of dirty pages as its offset and size, followed by the
+	// pages themselves.
+	std::size_t page_count = get_committed_page_count();
+	std::size_t i = 0;
+
+	while (i < page_count)
+	{
+		if (!memory_region_base::is_page_dirty(memory, i))
+		{
+			++i;
+			continue;
+		}
+
+		std::size_t run_end = i + 1;
+		while (run_end < page_count && memory_region_base::is_page_dirty(memory, run_end))
+		{
+			++run_end;
+		}
+
+		std::size_t offset = i * get_page_size();
+		std::size_t size = (run_end - i) * get_page_size();
+
+		if (!writer.write_ulong(offset) ||
+			!writer.write_ulong(size) ||
+			stream->write((std::uint8_t*)memory + offset, size) != size)
+		{
+			push_exception(exception::invalid_operation);
+
+			return false;
+		}
+
+		i = run_end;
+	}
+
+	// An empty run ends the snapshot.
+	if (!writer.write_ulong(0) || !writer.write_ulong(0))
+	{
+		push_exception(exception::invalid_operation);
+
+		return false;
+	}
+
+	// Only now is it safe to forget what was written.
+	return clear_dirty_pages();
+}
+
+bool holo::memory_region::read_snapshot(holo::stream_interface* stream)
+{
+	holo::binary_reader reader(stream, holo::endianness::little);
+
+	std::uint64_t size;
+	if (!reader.read_ulong(size) || size > max_size)
+	{
+		push_exception(exception::invalid_operation);
+
+		return false;
+	}
+
+	if (size > current_size)
+	{
+		if (grow(size - current_size) == nullptr)
+		{
+			return false;
+		}
+	}
+	else if (size < current_size)
+	{
+		shrink(current_size - size);
+	}
+
+	std::size_t committed_size = get_committed_page_count() * get_page_size();
+	while (true)
+	{
+		std::uint64_t offset;
+		std::uint64_t run_size;
+		if (!reader.read_ulong(offset) || !reader.read_ulong(run_size))
+		{
+			push_exception(exception::invalid_operation);
+
+			return false;
+		}
+
+		if (run_size == 0)
+		{
+			break;
+		}
+
+		if (offset > committed_size || run_size > committed_size - offset)
+		{
+			push_exception(exception::invalid_operation);
+
+			return false;
+		}
+
+		// The stream may have the kernel write to the pages, which fails on
+		// clean pages rather than marking them dirty, so dirty them first.
+		if (flags & flag_track_dirty_pages)
+		{
+			std::size_t page_size = get_page_size();
+			for (std::size_t page = offset - offset % page_size; page < offset + run_size; page += page_size)
+			{
+				volatile std::uint8_t* byte = (std::uint8_t*)memory + page;
+				*byte = *byte;
+			}
+		}
+
+		if (stream->read((std::uint8_t*)memory + offset, run_size) != run_size)
+		{
+			push_exception(exception::invalid_operation);
+
+			return false;
+		}
+	}
+
+	return true;
+}
+
 std::size_t holo::memory_region::get_reserved_size() const
 {
 	// If 'max_size' is 0, this is an empty memory region. Simply return 0 in such
@@ -184,7 +543,38 @@ std::size_t holo::memory_region::get_current_size() const
 	return math::round_up(current_size, get_page_size());
 }
 
+int holo::memory_region::get_flags() const
+{
+	return flags;
+}
+
 std::size_t holo::memory_region::get_minimum_size(std::size_t hint)
 {
 	return math::round_up(hint, std::max(get_page_size(), get_granularity()));
 }
+
+holo::memory_region holo::memory_region::create_shared_memory(
+	const char* name, std::size_t size, int flags)
+{
+	holo::memory_region region;
+	region.flags = flags | flag_shared_memory | flag_shared_writable;
+
+	// The object is sized to whole pages, so every committed page is backed.
+	std::size_t object_size = get_minimum_size(size);
+	if (region.open_shared_memory(name, true, true, &object_size))
+	{
+		region.max_size = object_size;
+	}
+
+	return region;
+}
+
+bool holo::memory_region::remove_shared_memory(const char* name)
+{
+	return memory_region_base::remove_shared_memory(name);
+}
+
+std::size_t holo::memory_region::get_committed_page_count() const
+{
+	return current_size == 0 ? 0 : math::multiple_of(current_size, get_page_size());
+}
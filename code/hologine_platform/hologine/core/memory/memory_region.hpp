@@ -16,6 +16,8 @@
 
 namespace holo
 {
+	class stream_interface;
+
 	// Reserves and commits virtual memory directly from the underlying platform.
 	//
 	// Not to be confused with holo::allocator. These two objects refer to
@@ -30,14 +32,104 @@ namespace holo
 	// a linear manner, starting from the base of the virtual memory region and
 	// growing towards the end of it.
 	//
-	// Individual pages cannot be deallocated. In order to decommit pages, the
-	// region must be reset. This effectively frees all committed pages.
+	// Individual pages cannot be deallocated. In order to release pages, the
+	// region must be reset. This effectively frees all committed pages. Pages
+	// can, however, be temporarily decommitted with
+	// holo::memory_region::decommit(std::size_t, std::size_t) and brought back
+	// with holo::memory_region::recommit(std::size_t, std::size_t).
+	//
+	// A region can also be backed by a file rather than anonymous memory.
+	// Committing pages then maps the corresponding part of the file in place,
+	// so data can be used without reading it into a copy first.
+	//
+	// A file-backed region can also be backed by a named shared memory object
+	// instead. One process creates the object and writes to it, while others
+	// map the same pages, typically read-only, without copying anything. Since
+	// each process maps the object at a different address, data structures in
+	// shared memory should refer to each other by offset rather than by
+	// pointer; see holo::memory_region::get_offset(const void*).
+	//
+	// A region can optionally track which committed pages were written to. An
+	// incremental snapshot then only has to copy the pages written since the
+	// previous snapshot; see holo::memory_region::write_snapshot().
+	//
+	// Lastly, a region can be mirrored, so that its pages can also be accessed
+	// right past its end. This is useful for ring buffers; see
+	// holo::memory_region::flag_mirrored.
 	class memory_region final : public memory_region_base
 	{
 		memory_region(const holo::memory_region&) = delete;
 		holo::memory_region& operator =(const holo::memory_region&) = delete;
 		
 		public:
+			// Flags that modify the behavior of the memory region.
+			enum
+			{
+				// Hints that committed pages should be backed by huge (or large) pages
+				// where the platform supports it.
+				//
+				// Huge pages reduce TLB pressure for large, frequently accessed
+				// regions. Only spans aligned to, and as large as,
+				// holo::memory_region::get_huge_page_size() can be backed by a huge
+				// page, so callers should align their data within the region
+				// accordingly.
+				flag_huge_pages = 0x00000001,
+
+				// Tracks which committed pages are written to.
+				//
+				// Clean pages are write protected, and the first write to each one
+				// after a snapshot costs a page fault. Newly committed pages start out
+				// dirty.
+				//
+				// Only writes by the process itself fault. The kernel refuses to
+				// write to a clean page instead, so system calls such as read(2) or
+				// recv(2) fail with EFAULT when given a clean page as a buffer; write
+				// to the page first.
+				//
+				// Platforms that can't track writes fail to reserve the region with
+				// holo::exception::unsupported.
+				flag_track_dirty_pages = 0x00000002,
+
+				// Makes the pages of a file-backed region writable.
+				//
+				// Writes are private to the process: pages are copied when first
+				// written to, and the file is never modified. Without this flag,
+				// the pages of a file-backed region are read-only.
+				flag_copy_on_write = 0x00000004,
+
+				// Reads in the pages of a file-backed region as they are committed,
+				// rather than on first access.
+				flag_populate_pages = 0x00000008,
+
+				// Maps the pages of the region a second time, immediately after the
+				// region.
+				//
+				// The byte at 'offset' can then also be reached at 'offset' plus the
+				// reserved size, so any span of up to the reserved size starting
+				// within the region is contiguous in memory, even if it wraps
+				// around the end. Mirrored pages are shared between both views, and
+				// are zero-filled once decommitted.
+				//
+				// A mirrored region can't be backed by a file, nor track dirty
+				// pages.
+				flag_mirrored = 0x00000010,
+
+				// Treats the path of a file-backed region as the name of an existing
+				// shared memory object, rather than a file.
+				//
+				// Committed pages are shared with every other process that maps the
+				// object. Unless flag_shared_writable is provided, the pages are
+				// read-only. Decommitting pages only unmaps them; the contents stay
+				// in the object.
+				flag_shared_memory = 0x00000020,
+
+				// Makes the pages of a shared memory region writable.
+				//
+				// Writes are visible to every process mapping the object. A region
+				// that creates the object is always writable.
+				flag_shared_writable = 0x00000040
+			};
+
 			// Move constructor.
 			//
 			// After a move, 'other' will be an empty memory region.
@@ -62,8 +154,25 @@ namespace holo
 			// due to differences in the size of a page, the actual region reserved
 			// may be larger or smaller. To query the final size of the memory
 			// region, see holo::memory_region::get_reserved_size().
-			memory_region(std::size_t max_size);
-			
+			//
+			// 'flags' modifies the behavior of the region; see the enumeration
+			// above.
+			memory_region(std::size_t max_size, int flags = 0);
+
+			// Constructs a memory region backed by the file at 'path'.
+			//
+			// The region is as large as the file; as usual, pages are only mapped
+			// as the region grows, and holo::memory_region::claim() maps the
+			// entire file. Pages past the end of the file in the last page read
+			// as zero.
+			//
+			// 'flags' modifies the behavior of the region; see the enumeration
+			// above.
+			//
+			// If the file could not be opened, an exception is pushed and the
+			// region is empty.
+			memory_region(const char* path, int flags = 0);
+
 			// Decommits and releases the virtual memory region represented by this
 			// object.
 			//
@@ -110,6 +219,14 @@ namespace holo
 			//
 			// If this method fails, an appropriate error message will be pushed.
 			void* grow(std::size_t size);
+
+			// Shrinks the memory region by 'size' bytes, decommitting the pages that
+			// no longer hold any of the region.
+			//
+			// This is the opposite of holo::memory_region::grow(std::size_t); the
+			// region remains reserved and can grow again later. 'size' must not be
+			// larger than the current size.
+			void shrink(std::size_t size);
 			
 			// Resets the memory region.
 			//
@@ -117,7 +234,110 @@ namespace holo
 			// virtual memory region reserved will be released if 'release' is true;
 			// otherwise, the region will remain reserved (but uncomitted).
 			void reset(bool release);
+
+			// Decommits the pages spanning 'size' bytes from 'offset', returning
+			// their physical memory to the platform.
+			//
+			// The pages remain reserved and still count towards the current size of
+			// the region. They must be recommitted with
+			// holo::memory_region::recommit(std::size_t, std::size_t) before they
+			// are accessed again; the contents are lost.
+			//
+			// Both 'offset' and 'size' must be multiples of the page size, and the
+			// range must lie within the committed portion of the region.
+			//
+			// This method does not modify the state of the region object, so it may
+			// be called concurrently on disjoint ranges.
+			void decommit(std::size_t offset, std::size_t size);
+
+			// Recommits pages previously decommitted by
+			// holo::memory_region::decommit(std::size_t, std::size_t).
+			//
+			// The requirements on 'offset' and 'size' are the same. Recommitted
+			// pages are zero-filled.
+			//
+			// Returns true on success. On failure, an appropriate exception is
+			// pushed and the pages remain decommitted.
+			bool recommit(std::size_t offset, std::size_t size);
 			
+			// Hints that the pages spanning 'size' bytes from 'offset' will be
+			// accessed soon.
+			//
+			// For a file-backed region, the pages are read in ahead of time. The
+			// range must lie within the committed portion of the region.
+			void prefetch(std::size_t offset, std::size_t size);
+
+			// Gets if the region is backed by a file.
+			bool is_file_backed() const;
+
+			// Gets the size of the file backing the region, in bytes, or zero if
+			// the region is not backed by a file.
+			std::size_t get_file_size() const;
+
+			// Gets if the region is backed by a shared memory object.
+			bool is_shared_memory() const;
+
+			// Gets the offset of 'pointer' from the beginning of the region.
+			//
+			// Unlike the pointer, the offset is meaningful to every process that
+			// maps the same shared memory object or file. The region must be
+			// reserved, and 'pointer' must lie within it.
+			std::size_t get_offset(const void* pointer) const;
+
+			// Gets a pointer to the byte 'offset' bytes from the beginning of the
+			// region.
+			//
+			// This is the opposite of holo::memory_region::get_offset(const void*).
+			// The region must be reserved, and 'offset' must lie within it.
+			void* get_pointer(std::size_t offset) const;
+
+			// Gets if the page containing 'offset' was written to since the last
+			// snapshot.
+			//
+			// The region must track dirty pages and 'offset' must lie within the
+			// committed portion of the region.
+			bool is_page_dirty(std::size_t offset) const;
+
+			// Gets the number of bytes in dirty pages.
+			//
+			// This is the amount of data the next snapshot will copy.
+			std::size_t get_dirty_size() const;
+
+			// Marks every page clean without taking a snapshot.
+			//
+			// Writes made while the pages are being cleared may be forgotten, so
+			// the region should not be written to in the meantime.
+			//
+			// Returns false on failure, in which case some pages may stay dirty.
+			bool clear_dirty_pages();
+
+			// Writes the dirty pages of the region to 'stream', then marks them
+			// clean.
+			//
+			// A snapshot records the current size of the region, followed by runs
+			// of dirty pages, so its cost depends on how much was written rather
+			// than on the size of the region. The first snapshot of a region holds
+			// every committed page. Applying each snapshot in turn with
+			// holo::memory_region::read_snapshot(holo::stream_interface*)
+			// reproduces the contents of the region.
+			//
+			// The region must track dirty pages, and must not be written to while
+			// the snapshot is taken.
+			//
+			// Returns true on success. If the stream could not be written, an
+			// exception is pushed and the pages are left dirty.
+			bool write_snapshot(holo::stream_interface* stream);
+
+			// Applies a snapshot written by
+			// holo::memory_region::write_snapshot(holo::stream_interface*).
+			//
+			// The region is grown or shrunk to the size recorded in the snapshot,
+			// and the pages in the snapshot are overwritten.
+			//
+			// Returns true on success. On failure, an exception is pushed and the
+			// region may be partially updated.
+			bool read_snapshot(holo::stream_interface* stream);
+
 			// Gets the maximum size of the memory region, in bytes.
 			//
 			// This value may be different than the value passed in the constructor
@@ -146,14 +366,46 @@ namespace holo
 			// holo::memory_region::get_reserved_size() for more information.
 			std::size_t get_current_size() const;
 
+			// Gets the flags provided when the region was constructed.
+			int get_flags() const;
+
 			// Utilty to round up a a size hint to the minimum memory region as per
 			// platform requirements.
 			//
 			// This method follows the rules of
 			// holo::memory_region::get_reserved_size().
 			static std::size_t get_minimum_size(std::size_t hint);
+
+			// Creates a memory region backed by a new shared memory object named
+			// 'name', large enough to store 'size' bytes.
+			//
+			// The region is writable, and other processes can map it by
+			// constructing a region with the same name and flag_shared_memory.
+			// Shared memory names should start with a slash and contain no others,
+			// like "/telemetry". The name outlives the region; it must be removed
+			// with holo::memory_region::remove_shared_memory(const char*).
+			//
+			// 'flags' modifies the behavior of the region; flag_shared_memory and
+			// flag_shared_writable are implied.
+			//
+			// If the object could not be created, e.g. because the name is taken,
+			// an exception is pushed and the region is empty.
+			static memory_region create_shared_memory(const char* name, std::size_t size, int flags = 0);
+
+			// Removes the name of a shared memory object.
+			//
+			// Regions that already map the object keep working, and the object is
+			// freed once the last of them is released. A new object can then be
+			// created with the same name.
+			//
+			// Returns true on success. If there is no such object, an exception is
+			// pushed and this method returns false.
+			static bool remove_shared_memory(const char* name);
 		
 		private:
+			// Gets the number of committed pages.
+			std::size_t get_committed_page_count() const;
+
 			// The largest this region can grow, in bytes.
 			//
 			// The actual value may be larger than requested; refer to
@@ -170,6 +422,9 @@ namespace holo
 			// Pointer to the beginning of the virtual memory region; will be NULL
 			// if the memory has yet to be reserved.
 			void* memory;
+
+			// Flags that modify the behavior of the region.
+			int flags;
 	};
 }
 
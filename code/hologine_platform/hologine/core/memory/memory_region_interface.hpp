@@ -24,9 +24,49 @@ namespace holo
 	// std::size_t get_granularity() should return the granularity of page
 	// allocations (in other words, the boundary of each call to the underlying
 	// virtual memory allocation method).
+	//
+	// std::size_t get_huge_page_size() should return the size of a huge (or
+	// large) page, or the most common size if the platform supports several.
+	//
+	// bool remove_shared_memory(const char* name) should remove the name of a
+	// shared memory object, so it can no longer be opened. Regions that already
+	// map the object are unaffected.
 	class memory_region_interface
 	{
 		protected:
+			// Opens the file at 'path' to back the region.
+			//
+			// If 'writable' is true, committed pages are writable, but writes are
+			// private to the process and never reach the file. Otherwise, pages
+			// are read-only. If 'populate' is true, committing pages should read
+			// them in right away rather than on first touch.
+			//
+			// Once a file is open, reserving and committing pages maps the file
+			// instead of anonymous memory; page 'index' maps the file at offset
+			// 'index' times the page size.
+			//
+			// Returns true and stores the size of the file in 'size' on success.
+			virtual bool open_file(const char* path, bool writable, bool populate, std::size_t* size) = 0;
+
+			// Opens the shared memory object named 'name' to back the region.
+			//
+			// If 'create' is true, a new object of 'size' bytes is created, and
+			// fails if the name is taken; otherwise, an existing object is opened
+			// and its size is stored in 'size'. Unlike a file, committed pages are
+			// shared: if 'writable' is true, writes are visible to every process
+			// that maps the object. Otherwise, pages are read-only.
+			//
+			// A shared memory object is reserved and committed like a file; see
+			// open_file(const char*, bool, bool, std::size_t*).
+			//
+			// Returns true on success.
+			virtual bool open_shared_memory(const char* name, bool create, bool writable, std::size_t* size) = 0;
+
+			// Gets if a file backs the region.
+			//
+			// This includes shared memory objects.
+			virtual bool is_file_open() const = 0;
+
 			// Reserves 'max_pages' of virtual memory.
 			//
 			// These pages should not yet be committed.
@@ -35,6 +75,17 @@ namespace holo
 			// success, NULL on failure.
 			virtual void* reserve_pages(std::size_t max_pages) = 0;
 			
+			// Reserves 'max_pages' of memory followed immediately by a second view
+			// of the same pages, so the region spans twice as many pages.
+			//
+			// Writes through either view are visible through the other. The pages
+			// are committed as a whole; committing pages of a mirrored region does
+			// nothing, and releasing them releases both views.
+			//
+			// Returns a pointer to the beginning of the first view on success,
+			// NULL on failure.
+			virtual void* reserve_mirrored_pages(std::size_t max_pages) = 0;
+
 			// Releases the previously reserved pages in the provided range.
 			virtual void release_pages(void* base, std::size_t index, std::size_t count) = 0;
 			
@@ -43,6 +94,43 @@ namespace holo
 			
 			// Decommits a range of pages.
 			virtual void decommit_pages(void* base, std::size_t index, std::size_t count) = 0;
+
+			// Hints that a range of reserved pages should be backed by huge pages
+			// once committed.
+			//
+			// This is only a hint. Platforms that cannot honor it should do
+			// nothing.
+			virtual void advise_huge_pages(void* base, std::size_t index, std::size_t count) = 0;
+
+			// Hints that a range of committed pages will be accessed soon, so they
+			// should be read in ahead of time.
+			virtual void advise_will_need(void* base, std::size_t index, std::size_t count) = 0;
+
+			// Starts tracking writes to the 'max_pages' pages reserved at 'base'.
+			//
+			// Pages start out untracked. Returns true on success.
+			virtual bool begin_tracking_pages(void* base, std::size_t max_pages) = 0;
+
+			// Stops tracking writes to the pages reserved at 'base'.
+			//
+			// Pages write protected by tracking are made writable again.
+			virtual void end_tracking_pages(void* base) = 0;
+
+			// Marks a range of committed, writable pages as dirty.
+			virtual void mark_pages_dirty(void* base, std::size_t index, std::size_t count) = 0;
+
+			// Marks a range of pages as untracked, for example because they were
+			// decommitted.
+			virtual void mark_pages_untracked(void* base, std::size_t index, std::size_t count) = 0;
+
+			// Marks the dirty pages in a range as clean.
+			//
+			// The next write to a clean page should mark it dirty again. Returns
+			// true on success.
+			virtual bool clear_dirty_pages(void* base, std::size_t index, std::size_t count) = 0;
+
+			// Gets if a tracked page was written since it was last marked clean.
+			virtual bool is_page_dirty(void* base, std::size_t index) const = 0;
 	};
 }
 
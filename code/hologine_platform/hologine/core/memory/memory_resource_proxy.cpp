@@ -0,0 +1,53 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include "core/memory/memory_resource_proxy.hpp"
+
+#if __cplusplus >= 201703L
+
+#include <algorithm>
+#include <new>
+
+holo::memory_resource_proxy::memory_resource_proxy(holo::allocator* allocator) :
+	allocator(allocator)
+{
+	// Nothing.
+}
+
+holo::allocator* holo::memory_resource_proxy::get_allocator() const
+{
+	return allocator;
+}
+
+void* holo::memory_resource_proxy::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+	alignment = std::max(alignment, holo::allocator::default_alignment);
+
+	void* pointer = allocator->allocate(bytes, alignment);
+	if (pointer == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+
+	return pointer;
+}
+
+void holo::memory_resource_proxy::do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment)
+{
+	allocator->deallocate(pointer, bytes, std::max(alignment, holo::allocator::default_alignment));
+}
+
+bool holo::memory_resource_proxy::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+	const memory_resource_proxy* proxy = dynamic_cast<const memory_resource_proxy*>(&other);
+
+	return proxy != nullptr && proxy->allocator == allocator;
+}
+
+#endif
@@ -0,0 +1,61 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#ifndef HOLOGINE_CORE_MEMORY_MEMORY_RESOURCE_PROXY_HPP_
+#define HOLOGINE_CORE_MEMORY_MEMORY_RESOURCE_PROXY_HPP_
+
+// Polymorphic memory resources were introduced with C++17. Older builds
+// should use holo::standard_allocator_proxy instead.
+#if __cplusplus >= 201703L
+
+#include <cstddef>
+#include <memory_resource>
+#include "core/memory/allocator.hpp"
+
+namespace holo
+{
+	// Wraps a holo::allocator as a std::pmr::memory_resource.
+	//
+	// Containers in the std::pmr namespace can then allocate from any
+	// holo::allocator. Sizes and alignments are passed through, so the sized
+	// deallocation path of the allocator is used.
+	//
+	// Like holo::standard_allocator_proxy, the allocator must outlive the proxy
+	// and is not destroyed by it.
+	class memory_resource_proxy final : public std::pmr::memory_resource
+	{
+		public:
+			// Constructs a memory resource allocating from 'allocator'.
+			explicit memory_resource_proxy(holo::allocator* allocator);
+
+			// Gets the underlying allocator.
+			holo::allocator* get_allocator() const;
+
+		private:
+			// Implementation.
+			//
+			// Throws std::bad_alloc if the allocator fails, as required of a
+			// memory resource.
+			void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+
+			// Implementation.
+			void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override;
+
+			// Implementation.
+			//
+			// Two proxies are equal if they wrap the same allocator.
+			bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+			holo::allocator* allocator;
+	};
+}
+
+#endif
+
+#endif
@@ -0,0 +1,282 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include "core/exception.hpp"
+#include "core/container/intrusive_list.hpp"
+#include "core/math/util.hpp"
+#include "core/memory/object_cache.hpp"
+
+holo::object_cache::object_cache(
+	holo::memory_arena_pool* arena_pool,
+	std::size_t object_size,
+	construct_callback construct,
+	destruct_callback destruct,
+	void* userdata,
+	std::size_t alignment) :
+		arena_pool(arena_pool),
+		object_size(object_size),
+		free_slot_offset(0),
+		slot_size(0),
+		first_slot_offset(0),
+		object_count(0),
+		construct(construct),
+		destruct(destruct),
+		userdata(userdata),
+		available_arenas(nullptr),
+		full_arenas(nullptr),
+		arena_count(0),
+		cached_count(0),
+		construct_count(0),
+		destruct_count(0),
+		counter()
+{
+	holo_assert(object_size > 0);
+	holo_assert(alignment >= alignof(free_slot));
+
+	// The link lives just past the object, so the object itself is never
+	// touched while it sits in the cache.
+	free_slot_offset = math::round_up(object_size, alignof(free_slot));
+	slot_size = math::round_up(free_slot_offset + sizeof(free_slot), alignment);
+
+	first_slot_offset = math::round_up(sizeof(arena_header), alignment);
+
+	std::size_t arena_size = arena_pool->get_arena_size();
+	holo_assert(first_slot_offset + slot_size <= arena_size);
+
+	object_count = (arena_size - first_slot_offset) / slot_size;
+}
+
+holo::object_cache::~object_cache()
+{
+	holo_assert(full_arenas == nullptr);
+
+	while (available_arenas != nullptr)
+	{
+		arena_record* arena = available_arenas;
+		available_arenas = arena->next;
+
+		holo_assert(get_live_count(arena) == 0);
+		release_arena(arena);
+	}
+}
+
+void* holo::object_cache::allocate()
+{
+	arena_record* arena = available_arenas;
+	if (arena == nullptr)
+	{
+		arena = request_arena();
+
+		if (arena == nullptr)
+		{
+			return nullptr;
+		}
+	}
+
+	arena_header* header = get_header(arena);
+	void* object;
+
+	if (header->free_slots != nullptr)
+	{
+		// Reuse an object in its constructed state.
+		free_slot* slot = header->free_slots;
+		header->free_slots = slot->next;
+		--header->free_count;
+		--cached_count;
+
+		object = get_object(slot);
+	}
+	else
+	{
+		// Otherwise construct the next untouched slot.
+		holo_assert(header->constructed_count < object_count);
+
+		object = (char*)arena->base + first_slot_offset + header->constructed_count * slot_size;
+		++header->constructed_count;
+
+		if (construct != nullptr)
+		{
+			construct(object, userdata);
+		}
+		++construct_count;
+	}
+
+	if (header->free_slots == nullptr && header->constructed_count == object_count)
+	{
+		move_arena(arena, &available_arenas, &full_arenas);
+	}
+
+	counter.record_allocation(object_size, slot_size);
+
+	return object;
+}
+
+void holo::object_cache::deallocate(void* object)
+{
+	arena_record* arena = arena_pool->get_arena(object);
+	holo_assert(arena != nullptr);
+
+	arena_header* header = get_header(arena);
+	bool was_full = header->free_slots == nullptr && header->constructed_count == object_count;
+
+	free_slot* slot = get_free_slot(object);
+	slot->next = header->free_slots;
+	header->free_slots = slot;
+	++header->free_count;
+	++cached_count;
+
+	if (was_full)
+	{
+		move_arena(arena, &full_arenas, &available_arenas);
+	}
+
+	counter.record_deallocation(slot_size);
+}
+
+std::size_t holo::object_cache::reap()
+{
+	std::size_t reaped_count = 0;
+
+	arena_record* arena = available_arenas;
+	while (arena != nullptr)
+	{
+		arena_record* next = arena->next;
+
+		if (get_live_count(arena) == 0)
+		{
+			if (available_arenas == arena)
+			{
+				available_arenas = next;
+			}
+			intrusive_list::unlink(arena);
+
+			release_arena(arena);
+			++reaped_count;
+		}
+
+		arena = next;
+	}
+
+	return reaped_count;
+}
+
+std::size_t holo::object_cache::get_object_size() const
+{
+	return object_size;
+}
+
+std::size_t holo::object_cache::get_object_count() const
+{
+	return object_count;
+}
+
+void holo::object_cache::set_statistics_enabled(bool enable)
+{
+	counter.set_enabled(enable);
+}
+
+void holo::object_cache::get_statistics(statistics* statistics) const
+{
+	counter.get_statistics(&statistics->allocations);
+	statistics->arena_count = arena_count;
+	statistics->cached_objects = cached_count;
+	statistics->construct_count = construct_count;
+	statistics->destruct_count = destruct_count;
+}
+
+holo::object_cache::arena_header* holo::object_cache::get_header(arena_record* arena) const
+{
+	return (arena_header*)arena->base;
+}
+
+holo::object_cache::free_slot* holo::object_cache::get_free_slot(void* object) const
+{
+	return (free_slot*)((char*)object + free_slot_offset);
+}
+
+void* holo::object_cache::get_object(free_slot* slot) const
+{
+	return (char*)slot - free_slot_offset;
+}
+
+std::size_t holo::object_cache::get_live_count(arena_record* arena) const
+{
+	arena_header* header = get_header(arena);
+
+	return header->constructed_count - header->free_count;
+}
+
+holo::object_cache::arena_record* holo::object_cache::request_arena()
+{
+	arena_record* arena = arena_pool->take_arena();
+	if (arena == nullptr)
+	{
+		return nullptr;
+	}
+
+	arena_header* header = get_header(arena);
+	header->free_slots = nullptr;
+	header->free_count = 0;
+	header->constructed_count = 0;
+
+	arena->previous = nullptr;
+	arena->next = available_arenas;
+	if (available_arenas != nullptr)
+	{
+		available_arenas->previous = arena;
+	}
+	available_arenas = arena;
+
+	++arena_count;
+	counter.record_memory(
+		arena_count * arena_pool->get_arena_size(),
+		arena_count * arena_pool->get_arena_size());
+
+	return arena;
+}
+
+void holo::object_cache::release_arena(arena_record* arena)
+{
+	arena_header* header = get_header(arena);
+
+	// Every constructed slot is in the free list by now.
+	if (destruct != nullptr)
+	{
+		for (free_slot* slot = header->free_slots; slot != nullptr; slot = slot->next)
+		{
+			destruct(get_object(slot), userdata);
+		}
+	}
+
+	destruct_count += header->free_count;
+	cached_count -= header->free_count;
+
+	arena_pool->give_arena(arena);
+
+	--arena_count;
+	counter.record_memory(
+		arena_count * arena_pool->get_arena_size(),
+		arena_count * arena_pool->get_arena_size());
+}
+
+void holo::object_cache::move_arena(arena_record* arena, arena_record** from, arena_record** to)
+{
+	if (*from == arena)
+	{
+		*from = arena->next;
+	}
+	intrusive_list::unlink(arena);
+
+	arena->next = *to;
+	if (*to != nullptr)
+	{
+		(*to)->previous = arena;
+	}
+	*to = arena;
+}
@@ -0,0 +1,276 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#ifndef HOLOGINE_CORE_MEMORY_OBJECT_CACHE_HPP_
+#define HOLOGINE_CORE_MEMORY_OBJECT_CACHE_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include "core/memory/allocation_statistics.hpp"
+#include "core/memory/allocator.hpp"
+#include "core/memory/memory_arena_pool.hpp"
+
+namespace holo
+{
+	// Caches objects of a single type in their constructed state.
+	//
+	// An object cache is a pool of objects taken from a
+	// holo::memory_arena_pool, like a holo::pool_allocator, except that freed
+	// objects are not destroyed. The constructor hook runs the first time a
+	// slot is handed out and the destructor hook only runs when the slot's
+	// arena is given back to the arena pool. Objects that are expensive to set
+	// up (for example, ones that embed a holo::mutex or own prebuilt buffers)
+	// thus only pay for it once.
+	//
+	// In turn, an object must be returned to the cache in its constructed state;
+	// that is, in a state the constructor hook could have left it in.
+	//
+	// Arenas that no longer hold any live objects are kept, along with their
+	// constructed objects, until holo::object_cache::reap() is called or the
+	// cache is destroyed.
+	//
+	// An object cache is not thread safe.
+	class object_cache
+	{
+		object_cache(const object_cache&) = delete;
+		object_cache& operator =(const object_cache&) = delete;
+
+		public:
+			// Puts an object into its constructed state.
+			typedef void (* construct_callback)(void* object, void* userdata);
+
+			// Tears down an object in its constructed state.
+			typedef void (* destruct_callback)(void* object, void* userdata);
+
+			// A snapshot of the usage of an object cache.
+			struct statistics
+			{
+				// Allocation statistics of the objects handed out by the cache.
+				//
+				// These are only gathered when enabled with
+				// holo::object_cache::set_statistics_enabled(bool), although the
+				// committed and reserved bytes are always tracked.
+				holo::allocation_statistics allocations;
+
+				// Number of arenas held by the cache.
+				std::size_t arena_count;
+
+				// Number of free objects held in their constructed state.
+				std::size_t cached_objects;
+
+				// Number of times the constructor hook ran.
+				std::uint64_t construct_count;
+
+				// Number of times the destructor hook ran.
+				std::uint64_t destruct_count;
+			};
+
+			// Constructs an object cache for objects 'object_size' bytes large and
+			// aligned to 'alignment', backed by arenas from 'arena_pool'.
+			//
+			// 'construct' and 'destruct' are invoked with 'userdata' to build and
+			// tear down the constructed state of an object. Either may be NULL.
+			object_cache(
+				holo::memory_arena_pool* arena_pool,
+				std::size_t object_size,
+				construct_callback construct,
+				destruct_callback destruct,
+				void* userdata = nullptr,
+				std::size_t alignment = holo::allocator::default_alignment);
+
+			// Destroys every cached object and returns all arenas to the pool.
+			//
+			// Every object must have been returned to the cache.
+			~object_cache();
+
+			// Takes an object in its constructed state from the cache.
+			//
+			// A previously freed object is preferred to constructing a new one.
+			//
+			// Returns NULL on failure, which happens if no more arenas can be taken
+			// from the arena pool.
+			void* allocate();
+
+			// Returns an object in its constructed state to the cache.
+			void deallocate(void* object);
+
+			// Destroys the objects in arenas holding no live objects and gives those
+			// arenas back to the arena pool.
+			//
+			// Returns the number of arenas given back.
+			std::size_t reap();
+
+			// Gets the size of an object.
+			std::size_t get_object_size() const;
+
+			// Gets the number of objects that fit in an arena.
+			std::size_t get_object_count() const;
+
+			// Enables or disables gathering allocation statistics.
+			//
+			// Statistics are disabled by default.
+			void set_statistics_enabled(bool enable);
+
+			// Takes a snapshot of the statistics of the cache.
+			void get_statistics(statistics* statistics) const;
+
+		private:
+			typedef holo::memory_arena_pool::arena_record arena_record;
+
+			// A free object; the link is stored past the end of the object, so the
+			// constructed state is left alone.
+			struct free_slot
+			{
+				free_slot* next;
+			};
+
+			// Bookkeeping stored at the start of every arena.
+			struct arena_header
+			{
+				// Free objects in their constructed state.
+				free_slot* free_slots;
+
+				// Number of objects in 'free_slots'.
+				std::size_t free_count;
+
+				// Number of slots, from the first, that have been constructed.
+				std::size_t constructed_count;
+			};
+
+			// Gets the header of an arena.
+			arena_header* get_header(arena_record* arena) const;
+
+			// Gets the link of an object.
+			free_slot* get_free_slot(void* object) const;
+
+			// Gets the object owning a link.
+			void* get_object(free_slot* slot) const;
+
+			// Gets the number of live objects in an arena.
+			std::size_t get_live_count(arena_record* arena) const;
+
+			// Takes a new arena from the arena pool and adds it to the available
+			// arenas.
+			arena_record* request_arena();
+
+			// Destroys the constructed objects in an arena and gives it back to the
+			// arena pool.
+			void release_arena(arena_record* arena);
+
+			// Moves an arena from one list to another.
+			static void move_arena(arena_record* arena, arena_record** from, arena_record** to);
+
+			// The arena pool.
+			holo::memory_arena_pool* arena_pool;
+
+			// Size of an object.
+			std::size_t object_size;
+
+			// Offset of the link from the start of a slot.
+			std::size_t free_slot_offset;
+
+			// Distance between consecutive slots.
+			std::size_t slot_size;
+
+			// Offset of the first slot from the base of an arena.
+			std::size_t first_slot_offset;
+
+			// Number of slots per arena.
+			std::size_t object_count;
+
+			// Hooks and their userdata.
+			construct_callback construct;
+			destruct_callback destruct;
+			void* userdata;
+
+			// Arenas with a free or unconstructed slot.
+			arena_record* available_arenas;
+
+			// Arenas with every slot in use.
+			arena_record* full_arenas;
+
+			// Number of arenas held.
+			std::size_t arena_count;
+
+			// Number of free objects held in their constructed state.
+			std::size_t cached_count;
+
+			// Number of times each hook ran.
+			std::uint64_t construct_count;
+			std::uint64_t destruct_count;
+
+			// Allocation statistics.
+			holo::allocation_counter counter;
+	};
+
+	// An object cache of 'Type'.
+	//
+	// The constructed state of an object is the one left by its default
+	// constructor; the destructor tears it down.
+	template <class Type>
+	class typed_object_cache final : public object_cache
+	{
+		public:
+			// Constructs an object cache backed by arenas from 'arena_pool'.
+			explicit typed_object_cache(holo::memory_arena_pool* arena_pool);
+
+			// Takes an object from the cache.
+			Type* allocate();
+
+			// Returns an object to the cache.
+			void deallocate(Type* object);
+
+		private:
+			// Default-constructs an object.
+			static void construct_object(void* object, void* userdata);
+
+			// Destroys an object.
+			static void destruct_object(void* object, void* userdata);
+	};
+
+	template <class Type>
+	typed_object_cache<Type>::typed_object_cache(holo::memory_arena_pool* arena_pool) :
+		object_cache(
+			arena_pool,
+			sizeof(Type),
+			&construct_object,
+			&destruct_object,
+			nullptr,
+			std::max(alignof(Type), holo::allocator::default_alignment))
+	{
+		// Nothing.
+	}
+
+	template <class Type>
+	Type* typed_object_cache<Type>::allocate()
+	{
+		return (Type*)object_cache::allocate();
+	}
+
+	template <class Type>
+	void typed_object_cache<Type>::deallocate(Type* object)
+	{
+		object_cache::deallocate(object);
+	}
+
+	template <class Type>
+	void typed_object_cache<Type>::construct_object(void* object, void*)
+	{
+		new(object) Type();
+	}
+
+	template <class Type>
+	void typed_object_cache<Type>::destruct_object(void* object, void*)
+	{
+		((Type*)object)->~Type();
+	}
+}
+
+#endif
@@ -10,23 +10,42 @@
 #include <algorithm>
 #include "core/exception.hpp"
 #include "core/container/intrusive_list.hpp"
+#include "core/math/bits.hpp"
 #include "core/math/util.hpp"
 #include "core/memory/pool_allocator.hpp"
 #include "core/memory/memory_arena_pool.hpp"
 
+const std::size_t holo::pool_allocator::minimum_object_size;
+const std::size_t holo::pool_allocator::bits_per_word;
+
 holo::pool_allocator::pool_allocator
 	(holo::memory_arena_pool* memory_arena_pool, std::size_t object_size) :
 		arena_list_head(nullptr),
 		arena_list_tail(nullptr),
 		memory_arena_pool(memory_arena_pool),
-		// Increase the object size to fit a free_node. This is necessary because
-		// when an object is returned to the pool, its memory is re-used to store a
-		// a portion of a free_pool_node, and thus must be at least as large as the
-		// portion of the free_node stored.
-		object_size(std::max(object_size, sizeof(free_node))),
-		object_count(memory_arena_pool->get_arena_size() / object_size)
+		object_size(std::max(object_size, minimum_object_size)),
+		object_count(0),
+		bitmap_offset(0),
+		bitmap_word_count(0),
+		arena_count(0),
+		counter(),
+		remote_object_count(0)
 {
 	holo_assert(memory_arena_pool != nullptr);
+
+	// Each object costs its size plus one bit in the bitmap. Start from that
+	// estimate, then back off until the word-granular bitmap fits too.
+	std::size_t arena_size = memory_arena_pool->get_arena_size();
+	object_count = (arena_size * 8) / (this->object_size * 8 + 1);
+	while (object_count > 0 &&
+		object_count * this->object_size + get_bitmap_size(object_count) > arena_size)
+	{
+		--object_count;
+	}
+	holo_assert(object_count > 0);
+
+	bitmap_word_count = math::multiple_of(object_count, bits_per_word);
+	bitmap_offset = arena_size - get_bitmap_size(object_count);
 }
 
 holo::pool_allocator::~pool_allocator()
@@ -57,63 +76,282 @@ void* holo::pool_allocator::allocate(std::size_t size, std::size_t)
 		return nullptr;
 	}
 
-	free_node* node = get_first_free_node(arena_list_head);
-	if (node == nullptr)
+	collect_pending_remote_objects();
+
+	arena_record* arena = get_first_free_arena(arena_list_head);
+	if (arena == nullptr)
 	{
 		// There are no more empty arenas. Request one from the pool.
-		arena_record* new_arena = request_empty_arena();
+		arena = request_empty_arena();
 
-		if (new_arena == nullptr)
+		if (arena == nullptr)
 		{
 			// Well, there's no more memory.
 			return nullptr;
 		}
+	}
+
+	counter.record_allocation(size, object_size);
+
+	// Memory allocation is good to go! Return.
+	void* object;
+	take_free_objects(arena, 1, &object);
+
+	return object;
+}
+
+void holo::pool_allocator::deallocate(void* pointer)
+{
+	arena_record* arena = memory_arena_pool->get_arena(pointer);
+
+	holo_assert(arena != nullptr);
+	holo_assert(arena->allocator == this);
+
+	counter.record_deallocation(object_size);
+
+	release_object(arena, pointer);
+}
+
+void holo::pool_allocator::deallocate(void* pointer, std::size_t size, std::size_t)
+{
+	(void)size;
+	holo_assert(size <= object_size);
+
+	deallocate(pointer);
+}
 
-		node = get_first_free_node(new_arena);
+std::size_t holo::pool_allocator::get_usable_size(void* pointer)
+{
+	arena_record* arena = memory_arena_pool->get_arena(pointer);
+
+	holo_assert(arena != nullptr);
+	holo_assert(arena->allocator == this);
+
+	void* object = get_object(arena, pointer);
+	return object_size - get_pointer_distance(pointer, object);
+}
+
+std::size_t holo::pool_allocator::allocate_batch(
+	std::size_t size,
+	std::size_t count,
+	void** pointers,
+	std::size_t)
+{
+	if (size > object_size)
+	{
+		push_exception(holo::exception::invalid_argument);
+
+		return 0;
 	}
-	holo_assert(node != nullptr);
 
-	// holo::pool_allocator::get_first_free_node(arena_record*) should somehow
-	// return the record it chose as well...
-	arena_record* arena = memory_arena_pool->get_arena(node);
-	holo_assert(arena);
+	collect_pending_remote_objects();
 
-	free_node* next;
-	if (node->size > 1)
+	std::size_t allocated = 0;
+	arena_record* arena = arena_list_head;
+
+	while (allocated < count)
 	{
-		// This is a lazy node from when the arena was first requested. Create a
-		// 'next' free node by splitting the span of unallocated memory.
-		next = (free_node*)((char*)node + object_size);
-		next->size = node->size - 1;
-		next->next = node;
+		// Arenas before 'arena' have already been exhausted, so only search
+		// those that follow.
+		arena = get_first_free_arena(arena);
+		if (arena == nullptr)
+		{
+			arena = request_empty_arena();
+
+			if (arena == nullptr)
+			{
+				break;
+			}
+		}
+
+		allocated += take_free_objects(arena, count - allocated, pointers + allocated);
 	}
-	else
+
+	counter.record_allocation(size * allocated, object_size * allocated, allocated);
+
+	return allocated;
+}
+
+void holo::pool_allocator::deallocate_batch(void** pointers, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; ++i)
 	{
-		next = node->next;
+		arena_record* arena = memory_arena_pool->get_arena(pointers[i]);
+
+		holo_assert(arena != nullptr);
+		holo_assert(arena->allocator == this);
+
+		release_object(arena, pointers[i]);
 	}
-	next->previous = node->previous;
 
-	// Update the previous node and the arena free list.
-	free_node* previous = node->previous;
-	if (arena->free_node_count == 0)
+	counter.record_deallocation(object_size * count, count);
+}
+
+void holo::pool_allocator::deallocate_remote(void* pointer)
+{
+	arena_record* arena = memory_arena_pool->get_arena(pointer);
+
+	holo_assert(arena != nullptr);
+	holo_assert(arena->allocator == this);
+
+	// The object can't be given back to its arena until it is reclaimed, so the
+	// arena (and thus its record) stays put while the object is pushed.
+	void** object = (void**)get_object(arena, pointer);
+	void* head = arena->remote_free_list.load(std::memory_order_relaxed);
+	do
+	{
+		*object = head;
+	} while (!arena->remote_free_list.compare_exchange_weak(
+		head, object, std::memory_order_release, std::memory_order_relaxed));
+
+	// Count the object only after pushing it; the owner then finds it when it
+	// sees the count.
+	remote_object_count.fetch_add(1, std::memory_order_release);
+}
+
+std::size_t holo::pool_allocator::collect_remote_objects()
+{
+	std::size_t collected = 0;
+
+	arena_record* arena = arena_list_head;
+	while (arena != nullptr)
 	{
-		// The arena is exhausted, thus the free list should be empty.
-		arena->free_node_list = nullptr;
+		// Releasing the last object may give the arena back to the pool.
+		arena_record* next = arena->next;
+
+		if (arena->remote_free_list.load(std::memory_order_relaxed) != nullptr)
+		{
+			// Only the owner takes from the list, and it takes the entire list, so
+			// a plain exchange is not susceptible to ABA.
+			void* object = arena->remote_free_list.exchange(nullptr, std::memory_order_acquire);
+
+			while (object != nullptr)
+			{
+				void* next_object = *(void**)object;
+				release_object(arena, object);
+
+				object = next_object;
+				++collected;
+			}
+		}
+
+		arena = next;
 	}
-	else
+
+	// A pusher may not have counted its object yet, so the count can briefly
+	// wrap around; that only costs a spurious collection.
+	if (collected > 0)
 	{
-		previous->next = next;
-		arena->free_node_list = next;
+		remote_object_count.fetch_sub(collected, std::memory_order_relaxed);
+		counter.record_deallocation(object_size * collected, collected);
 	}
 
-	// Memory allocation is good to go! Return.
-	return node;
+	return collected;
 }
 
-void holo::pool_allocator::deallocate(void* pointer)
+std::size_t holo::pool_allocator::get_object_size() const
 {
-	arena_record* arena = memory_arena_pool->get_arena(pointer);
+	return object_size;
+}
+
+std::size_t holo::pool_allocator::get_object_count() const
+{
+	return object_count;
+}
+
+holo::pool_allocator::object_iterator holo::pool_allocator::begin()
+{
+	// Remotely freed objects are still marked live until they are reclaimed.
+	collect_pending_remote_objects();
+
+	return object_iterator(this, arena_list_head, 0);
+}
+
+holo::pool_allocator::object_iterator holo::pool_allocator::end()
+{
+	return object_iterator();
+}
+
+void holo::pool_allocator::set_statistics_enabled(bool enable)
+{
+	counter.set_enabled(enable);
+}
+
+void holo::pool_allocator::get_statistics(holo::allocation_statistics* statistics) const
+{
+	counter.get_statistics(statistics);
+}
+
+holo::pool_allocator::arena_bitmap* holo::pool_allocator::get_bitmap(arena_record* arena) const
+{
+	return (arena_bitmap*)((char*)arena->base + bitmap_offset);
+}
+
+std::size_t holo::pool_allocator::get_bitmap_size(std::size_t count)
+{
+	std::size_t word_count = math::multiple_of(count, bits_per_word);
+
+	return sizeof(arena_bitmap) + (word_count - 1) * sizeof(std::uint64_t);
+}
+
+holo::pool_allocator::arena_record* holo::pool_allocator::get_first_free_arena(arena_record* arena)
+{
+	arena_record* current_arena = arena;
+
+	while (current_arena != nullptr)
+	{
+		if (current_arena->free_node_count > 0)
+		{
+			return current_arena;
+		}
+
+		current_arena = current_arena->next;
+	}
+
+	return nullptr;
+}
+
+std::size_t holo::pool_allocator::take_free_objects(
+	arena_record* arena,
+	std::size_t count,
+	void** objects)
+{
+	arena_bitmap* bitmap = get_bitmap(arena);
+	std::size_t word_index = bitmap->first_free_word;
+	std::size_t taken = 0;
+
+	while (taken < count && arena->free_node_count > 0)
+	{
+		holo_assert(word_index < bitmap_word_count);
+
+		std::uint64_t word = bitmap->words[word_index];
+		while (word != 0 && taken < count)
+		{
+			std::size_t index = word_index * bits_per_word + math::bit_scan_forward(word);
+			objects[taken] = (char*)arena->base + index * object_size;
+
+			// Clear the lowest set bit.
+			word &= word - 1;
+
+			--arena->free_node_count;
+			++taken;
+		}
+
+		bitmap->words[word_index] = word;
+
+		if (word == 0)
+		{
+			++word_index;
+		}
+	}
 
+	bitmap->first_free_word = word_index;
+
+	return taken;
+}
+
+void holo::pool_allocator::release_object(arena_record* arena, void* pointer)
+{
 	// Although not normally a sane option, we allow 'pointer' to be different
 	// from the value returned by
 	// holo::pool_allocator::allocate(std::size_t, std::size_t) for one reason:
@@ -124,19 +362,24 @@ void holo::pool_allocator::deallocate(void* pointer)
 	// allocation method), then the generic heap allocator would have to use extra
 	// data to keep track of allocations... By finding the pointer, we eliminate
 	// the bookkeeping!
-	pointer = (void*)(((unsigned_pointer)pointer - (unsigned_pointer)arena->base) % object_size);
+	pointer = get_object(arena, pointer);
 
-	holo_assert(arena != nullptr);
-	holo_assert(arena->allocator == this);
+	std::size_t index = get_pointer_distance(pointer, arena->base) / object_size;
+	std::size_t word_index = index / bits_per_word;
+	std::uint64_t bit = std::uint64_t(1) << (index % bits_per_word);
+
+	arena_bitmap* bitmap = get_bitmap(arena);
+	holo_assert(index < object_count);
+	holo_assert((bitmap->words[word_index] & bit) == 0);
+
+	bitmap->words[word_index] |= bit;
+	bitmap->first_free_word = std::min(bitmap->first_free_word, word_index);
 
 	++arena->free_node_count;
 
 	// Return the arena immediately if possible.
 	if (arena->free_node_count == object_count)
 	{
-		// Remove the arena from the list first.
-		intrusive_list::remove(arena);
-
 		// Update the head and tail pointers, if necessary.
 		if (arena_list_head == arena)
 		{
@@ -145,63 +388,34 @@ void holo::pool_allocator::deallocate(void* pointer)
 
 		if (arena_list_tail == arena)
 		{
-			arena_list_tail = arena->next;
+			arena_list_tail = arena->previous;
 		}
 
-		memory_arena_pool->give_arena(arena);
-	}
-	else
-	{
-		// Otherwise, update the arena's free node list.
-		free_node* node = (free_node*)pointer;
+		// Then remove the arena from the list.
+		intrusive_list::remove(arena);
 
-		// Size would have been overwritten by any data stored in the object (so we
-		// must assume).
-		node->size = 1;
+		memory_arena_pool->give_arena(arena);
 
-		if (arena->free_node_list != nullptr)
-		{
-			node->next = arena->free_node_list;
-			node->previous = arena->free_node_list->previous;
-		}
-		else
-		{
-			// This is the first deallocated node in the arena now. Since the free
-			// node list is a circular buffer, 'node' should point to itself.
-			node->next = node;
-			node->previous = node;
-		}
+		--arena_count;
+		counter.record_memory(
+			arena_count * memory_arena_pool->get_arena_size(),
+			arena_count * memory_arena_pool->get_arena_size());
 	}
 }
 
-std::size_t holo::pool_allocator::get_object_size() const
+void* holo::pool_allocator::get_object(arena_record* arena, void* pointer) const
 {
-	return object_size;
-}
+	std::size_t offset = get_pointer_distance(pointer, arena->base);
 
-std::size_t holo::pool_allocator::get_object_count() const
-{
-	return object_count;
+	return (char*)arena->base + (offset - offset % object_size);
 }
 
-holo::pool_allocator::free_node* holo::pool_allocator::get_first_free_node(arena_record* arena)
+void holo::pool_allocator::collect_pending_remote_objects()
 {
-	arena_record* current_arena = arena;
-
-	while (current_arena != nullptr)
+	if (remote_object_count.load(std::memory_order_acquire) != 0)
 	{
-		if (current_arena->free_node_list != nullptr)
-		{
-			// Update the arena's free node count.
-			--current_arena->free_node_count;
-
-			return current_arena->free_node_list;
-		}
-
-		current_arena = current_arena->next;
+		collect_remote_objects();
 	}
-
-	return nullptr;
 }
 
 holo::pool_allocator::arena_record* holo::pool_allocator::request_empty_arena()
@@ -212,23 +426,135 @@ holo::pool_allocator::arena_record* holo::pool_allocator::request_empty_arena()
 	{
 		arena->allocator = this;
 		arena->free_node_count = object_count;
-		arena->free_node_list = (free_node*)arena->base;
 
-		arena->free_node_list->size = object_count;
-		arena->free_node_list->next = arena->free_node_list;
-		arena->free_node_list->previous = arena->free_node_list;
+		// Every object starts free. Bits past the last object are left clear, so
+		// they are never handed out.
+		arena_bitmap* bitmap = get_bitmap(arena);
+		bitmap->first_free_word = 0;
+		for (std::size_t i = 0; i < bitmap_word_count; ++i)
+		{
+			bitmap->words[i] = ~std::uint64_t(0);
+		}
+
+		std::size_t tail_count = object_count % bits_per_word;
+		if (tail_count != 0)
+		{
+			bitmap->words[bitmap_word_count - 1] = (std::uint64_t(1) << tail_count) - 1;
+		}
 
-		if (arena_list_tail == nullptr)
+		// Keep the list in address order. Allocations then fill the lowest
+		// arenas first, and live objects are iterated in address order.
+		arena_record* position = arena_list_head;
+		while (position != nullptr && position->base < arena->base)
 		{
-			// No arenas have been reserved by the pool.
-			arena_list_head = arena;
+			position = position->next;
+		}
+
+		if (position == nullptr)
+		{
+			// The arena goes last.
+			arena->next = nullptr;
+			arena->previous = arena_list_tail;
+
+			if (arena_list_tail == nullptr)
+			{
+				// No arenas have been reserved by the pool.
+				arena_list_head = arena;
+			}
+			else
+			{
+				arena_list_tail->next = arena;
+			}
+
 			arena_list_tail = arena;
 		}
 		else
 		{
-			intrusive_list::insert_after(arena, arena_list_tail);	
+			intrusive_list::insert_before(arena, position);
+
+			if (position == arena_list_head)
+			{
+				arena_list_head = arena;
+			}
 		}
+
+		++arena_count;
+		counter.record_memory(
+			arena_count * memory_arena_pool->get_arena_size(),
+			arena_count * memory_arena_pool->get_arena_size());
 	}
 
 	return arena;
 }
+
+holo::pool_allocator::object_iterator::object_iterator() :
+	pool(nullptr),
+	arena(nullptr),
+	index(0)
+{
+	// Nothing.
+}
+
+holo::pool_allocator::object_iterator::object_iterator(
+	const holo::pool_allocator* pool,
+	holo::memory_arena_pool::arena_record* arena,
+	std::size_t index) :
+		pool(pool),
+		arena(arena),
+		index(0)
+{
+	seek(index);
+}
+
+void holo::pool_allocator::object_iterator::increment()
+{
+	seek(index + 1);
+}
+
+bool holo::pool_allocator::object_iterator::equal(const object_iterator& other) const
+{
+	return arena == other.arena && index == other.index;
+}
+
+void* holo::pool_allocator::object_iterator::dereference() const
+{
+	return (char*)arena->base + index * pool->object_size;
+}
+
+void holo::pool_allocator::object_iterator::seek(std::size_t index)
+{
+	while (arena != nullptr)
+	{
+		arena_bitmap* bitmap = pool->get_bitmap(arena);
+
+		while (index < pool->object_count)
+		{
+			std::size_t word_index = index / bits_per_word;
+
+			// Live objects are the clear bits, ignoring those before 'index'.
+			std::uint64_t live = ~bitmap->words[word_index];
+			live &= ~std::uint64_t(0) << (index % bits_per_word);
+
+			if (live != 0)
+			{
+				index = word_index * bits_per_word + math::bit_scan_forward(live);
+
+				// Clear bits past the last object don't count.
+				if (index < pool->object_count)
+				{
+					this->index = index;
+					return;
+				}
+
+				break;
+			}
+
+			index = (word_index + 1) * bits_per_word;
+		}
+
+		arena = arena->next;
+		index = 0;
+	}
+
+	this->index = 0;
+}
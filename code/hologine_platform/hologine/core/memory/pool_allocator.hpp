@@ -10,16 +10,71 @@
 #ifndef HOLOGINE_CORE_MEMORY_POOL_ALLOCATOR_HPP_
 #define HOLOGINE_CORE_MEMORY_POOL_ALLOCATOR_HPP_
 
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <boost/iterator/iterator_facade.hpp>
+#include "core/memory/allocation_statistics.hpp"
 #include "core/memory/allocator.hpp"
 #include "core/memory/memory_arena_pool.hpp"
 
 namespace holo
 {
 	// Allocates blocks of memory with uniform sizes.
+	//
+	// Objects are packed from the base of each arena, and an occupancy bitmap
+	// is kept at the end of the arena. Allocation takes the lowest free object,
+	// found by scanning the bitmap a word at a time, and deallocation sets its
+	// bit again. The bitmap also allows iterating over the live objects in
+	// address order.
 	class pool_allocator final : public allocator
 	{
 		public:
+			// Iterates over the live objects of a pool, in address order.
+			class object_iterator :
+				public boost::iterator_facade<
+					object_iterator,
+					void*,
+					boost::forward_traversal_tag,
+					void*>
+			{
+				friend class boost::iterator_core_access;
+
+				public:
+					// Creates an end iterator.
+					object_iterator();
+
+					// Creates an iterator at the first live object at or after 'index'
+					// in 'arena', or in any following arena.
+					object_iterator(
+						const holo::pool_allocator* pool,
+						holo::memory_arena_pool::arena_record* arena,
+						std::size_t index);
+
+				private:
+					// Implementation.
+					void increment();
+
+					// Implementation.
+					bool equal(const object_iterator& other) const;
+
+					// Implementation.
+					void* dereference() const;
+
+					// Moves to the first live object at or after 'index'.
+					void seek(std::size_t index);
+
+					const holo::pool_allocator* pool;
+					holo::memory_arena_pool::arena_record* arena;
+					std::size_t index;
+			};
+
+			// The smallest object a pool can store.
+			//
+			// A freed object is linked into a list while it waits to be reclaimed
+			// from another thread, so it must fit a pointer.
+			static const std::size_t minimum_object_size = sizeof(void*);
+
 			// Constructs a pool allocator with the provided
 			// holo::memory_arena_pool with objects no larger than
 			// 'object_size' bytes. This value must be a multiple of the default
@@ -58,6 +113,48 @@ namespace holo
 			// holo::pool_allocator::allocate(size_t, size_t).
 			void deallocate(void* pointer);
 
+			// Deallocates a block from a previous call to
+			// holo::pool_allocator::allocate(size_t, size_t).
+			//
+			// Every block in the pool is the same size, so 'size' and 'alignment'
+			// are only checked.
+			void deallocate(void* pointer, std::size_t size, std::size_t alignment = default_alignment) override;
+
+			// Gets the number of bytes usable starting at 'pointer'.
+			//
+			// This is the remainder of the object past the pointer.
+			std::size_t get_usable_size(void* pointer) override;
+
+			// Allocates several blocks from the pool.
+			//
+			// Each arena is searched for free blocks only once, and free blocks are
+			// taken a bitmap word at a time. The same requirements as
+			// holo::pool_allocator::allocate(size_t, size_t) apply.
+			std::size_t allocate_batch(
+				std::size_t size,
+				std::size_t count,
+				void** pointers,
+				std::size_t alignment = default_alignment) override;
+
+			// Deallocates several blocks previously allocated from the pool.
+			void deallocate_batch(void** pointers, std::size_t count) override;
+
+			// Deallocates a block from a thread other than the one using the pool.
+			//
+			// The block is pushed onto a lock-free list kept by its arena, and is
+			// reclaimed in bulk by the owning thread on its next allocation. This
+			// is the only method of a pool allocator that may be called from
+			// another thread.
+			void deallocate_remote(void* pointer);
+
+			// Reclaims every block deallocated by other threads.
+			//
+			// This happens automatically on allocation, but can be called
+			// explicitly to give back arenas emptied by remote frees sooner.
+			//
+			// Returns the number of blocks reclaimed.
+			std::size_t collect_remote_objects();
+
 			// Gets the size of an object.
 			//
 			// This value may be larger than the one provided in the constructor
@@ -67,28 +164,84 @@ namespace holo
 			// Gets the maxmimum number of objects that can be stored in one arena.
 			std::size_t get_object_count() const;
 
+			// Gets an iterator to the live object with the lowest address.
+			//
+			// Objects deallocated by other threads are reclaimed first. Allocating
+			// or deallocating objects invalidates the iterator.
+			object_iterator begin();
+
+			// Gets the end iterator for live objects.
+			object_iterator end();
+
+			// Enables or disables gathering allocation statistics.
+			//
+			// Statistics are disabled by default.
+			void set_statistics_enabled(bool enable);
+
+			// Takes a snapshot of the allocation statistics.
+			//
+			// Committed and reserved bytes count the arenas held by the pool. This
+			// method can be called from any thread.
+			void get_statistics(holo::allocation_statistics* statistics) const;
+
 		private:
 			typedef holo::memory_arena_pool::arena_record arena_record;
-			typedef holo::memory_arena_pool::allocator_free_node free_node;
+
+			// Occupancy of the objects in an arena, stored at its end.
+			class arena_bitmap
+			{
+				public:
+					// The lowest word that may have a free object. Words before it are
+					// all zero.
+					std::size_t first_free_word;
+
+					// One bit per object, set if the object is free.
+					std::uint64_t words[1];
+			};
+
+			// Number of objects tracked by a word of the bitmap.
+			static const std::size_t bits_per_word = 64;
+
+			// Gets the bitmap of an arena.
+			arena_bitmap* get_bitmap(arena_record* arena) const;
+
+			// Gets the size of a bitmap tracking 'count' objects.
+			static std::size_t get_bitmap_size(std::size_t count);
 
 			// Gets the first memory arena available to back a requseted allocation,
 			// starting the search at the provided arena.
 			//
 			// This method's speed depends on how many full memory arenas there
 			// are and is thus O(n). However, if the provided region is known to
-			// have a free pool node, it will be O(1).
+			// have a free object, it will be O(1).
+			//
+			// If a free object could not be found, this returns NULL. Otherwise,
+			// returns the first memory arena with a free object.
+			arena_record* get_first_free_arena(arena_record* record);
+
+			// Takes up to 'count' free objects from the arena, lowest address
+			// first, storing them in 'objects'.
 			//
-			// When the node is retrieved, it should be marked as allocated (that is,
-			// the arena's capacity should be decreased).
+			// Returns the number of objects taken, which is less than 'count' only
+			// if the arena was exhausted.
+			std::size_t take_free_objects(arena_record* arena, std::size_t count, void** objects);
+
+			// Marks an object in the arena as free.
 			//
-			// If a free node could not be found, this returns NULL. Otherwise,
-			// returns the first free pool node of the first memory region available.
-			free_node* get_first_free_node(arena_record* record);
+			// If this leaves the arena empty, the arena is given back to the arena
+			// pool.
+			void release_object(arena_record* arena, void* pointer);
+
+			// Gets the base of the object containing 'pointer'.
+			void* get_object(arena_record* arena, void* pointer) const;
+
+			// Reclaims remotely freed blocks, if there are any.
+			void collect_pending_remote_objects();
 
 			// Requests a new arena from the free list.
 			//
-			// On success, the new arena will be the new tail of the memory region
-			// list.
+			// On success, the new arena is inserted in the arena list, which is
+			// kept in address order.
 			//
 			// Returns a pointer to the arena record on success, NULL on failure.
 			// Failure can occur if the system memory is exhausted.
@@ -109,8 +262,24 @@ namespace holo
 			// The maximum size of an object stored in this pool.
 			std::size_t object_size;
 
-			// The maximum number of objects stored in the pool.
+			// The maximum number of objects stored in an arena.
 			std::size_t object_count;
+
+			// Offset of the bitmap from the base of an arena.
+			std::size_t bitmap_offset;
+
+			// Number of words in the bitmap.
+			std::size_t bitmap_word_count;
+
+			// The number of arenas held by the pool.
+			std::size_t arena_count;
+
+			// Allocation statistics.
+			holo::allocation_counter counter;
+
+			// Number of blocks freed by other threads that have yet to be
+			// reclaimed.
+			std::atomic<std::size_t> remote_object_count;
 	};
 }
 
@@ -10,8 +10,9 @@
 #ifndef HOLOGINE_CORE_MEMORY_STANDARD_ALLOCATOR_PROXY_HPP_
 #define HOLOGINE_CORE_MEMORY_STANDARD_ALLOCATOR_PROXY_HPP_
 
+#include <algorithm>
+#include <cstddef>
 #include <exception>
-#include <memory>
 #include <type_traits>
 #include "core/memory/allocator.hpp"
 
@@ -23,6 +24,11 @@ namespace holo
 	// holo::standard_allocator_proxy retrofits the holo::allocator interface
 	// into the strange std::allocator mechanics.
 	//
+	// Since holo::allocator is polymorphic, the type of a container only
+	// depends on the element type, not on the allocator backing it; a
+	// std::vector<int, holo::standard_allocator_proxy<int>> can live in a
+	// holo::heap_allocator or a holo::linear_allocator alike.
+	//
 	// The provided allocator is expected to have a lifetime greater than the
 	// holo::standard_allocator_proxy. Similarly, the
 	// holo::standard_allocator_proxy object will not destroy the underlying
@@ -33,10 +39,17 @@ namespace holo
 		public:
 			// Implementation of type aliases.
 			typedef Type value_type;
+			typedef Type* pointer;
+			typedef const Type* const_pointer;
+			typedef Type& reference;
+			typedef const Type& const_reference;
+			typedef std::size_t size_type;
+			typedef std::ptrdiff_t difference_type;
 
 			// Properties of the allocator.
 			typedef std::true_type propagate_on_container_copy_assignment;
 			typedef std::true_type propagate_on_container_move_assignment;
+			typedef std::true_type propagate_on_container_swap;
 
 			// Rebind mechanism.
 			template <class Other>
@@ -57,26 +70,34 @@ namespace holo
 
 			// Invokes holo::allocator::allocate(size_t, size_t).
 			//
-			// Default alignment will be used.
+			// The allocation is aligned to the alignment of 'Type', or the default
+			// alignment, whichever is stricter.
 			Type* allocate(std::size_t count);
 
-			// Invokes holo::allocate::deallocate(void*).
-			void deallocate(Type* type, std::size_t count);
+			// Invokes holo::allocator::deallocate(void*, std::size_t, std::size_t)
+			// with the size and alignment of the allocation.
+			void deallocate(Type* pointer, std::size_t count);
+
+			// Gets the underlying allocator.
+			holo::allocator* get_allocator() const;
 
 		private:
+			// Gets the alignment of allocations.
+			static std::size_t get_alignment();
+
 			holo::allocator* allocator;
 	};
 
 	template <class Type>
 	standard_allocator_proxy<Type>::standard_allocator_proxy(holo::allocator* allocator) :
-		allocator(other.allocator)
+		allocator(allocator)
 	{
 		// Nothing.
 	}
 
 	template <class Type>
 	standard_allocator_proxy<Type>::
-		standard_allocator_proxy(const holo::standard_allocator_proxy<Other>& other) :
+		standard_allocator_proxy(const holo::standard_allocator_proxy<Type>& other) :
 			allocator(other.allocator)
 	{
 		// Nothing.
@@ -86,15 +107,15 @@ namespace holo
 	template <class Other>
 	standard_allocator_proxy<Type>::
 		standard_allocator_proxy(const holo::standard_allocator_proxy<Other>& other) :
-			allocator(other.allocator)
+			allocator(other.get_allocator())
 	{
 		// Nothing.
 	}
 
 	template <class Type>
-	Type* standard_allocator_proxy<Type>::allocate(size_t count)
+	Type* standard_allocator_proxy<Type>::allocate(std::size_t count)
 	{
-		void* pointer = allocator->allocate(count* sizeof(Type));
+		void* pointer = allocator->allocate(count * sizeof(Type), get_alignment());
 
 		if (pointer == nullptr)
 		{
@@ -107,22 +128,37 @@ namespace holo
 	}
 
 	template <class Type>
-	standard_allocator_proxy<Type>::deallocate(Type* pointer, size_t count)
+	void standard_allocator_proxy<Type>::deallocate(Type* pointer, std::size_t count)
 	{
-		allocator->deallocate(pointer);
+		allocator->deallocate(pointer, count * sizeof(Type), get_alignment());
+	}
+
+	template <class Type>
+	holo::allocator* standard_allocator_proxy<Type>::get_allocator() const
+	{
+		return allocator;
+	}
+
+	template <class Type>
+	std::size_t standard_allocator_proxy<Type>::get_alignment()
+	{
+		return std::max<std::size_t>(alignof(Type), holo::allocator::default_alignment);
 	}
 
 	// Comparison operators.
+	//
+	// Proxies are equal if memory allocated by one can be deallocated by the
+	// other; that is, if they wrap the same allocator.
 	template <class Type, class Other>
 	bool operator ==(
 		const holo::standard_allocator_proxy<Type>& a, 
 		const holo::standard_allocator_proxy<Other>& b)
 	{
-		return a.allocator == b.allocator;
+		return a.get_allocator() == b.get_allocator();
 	}
 
 	template <class Type, class Other>
-	bool operator ==(
+	bool operator !=(
 		const holo::standard_allocator_proxy<Type>& a, 
 		const holo::standard_allocator_proxy<Other>& b)
 	{
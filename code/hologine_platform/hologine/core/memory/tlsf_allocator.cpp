@@ -0,0 +1,444 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include <algorithm>
+#include "core/exception.hpp"
+#include "core/math/bits.hpp"
+#include "core/math/util.hpp"
+#include "core/memory/tlsf_allocator.hpp"
+
+const std::size_t holo::tlsf_allocator::default_chunk_size;
+const std::size_t holo::tlsf_allocator::minimum_block_size;
+const std::size_t holo::tlsf_allocator::block_free;
+const std::size_t holo::tlsf_allocator::block_previous_free;
+const std::size_t holo::tlsf_allocator::block_header_size;
+const std::size_t holo::tlsf_allocator::second_level_shift;
+const std::size_t holo::tlsf_allocator::second_level_count;
+const std::size_t holo::tlsf_allocator::first_level_shift;
+const std::size_t holo::tlsf_allocator::first_level_count;
+
+holo::tlsf_allocator::tlsf_allocator(std::size_t size, int flags, std::size_t chunk_size) :
+	memory_region(holo::memory_region::get_minimum_size(size)),
+	flags(flags),
+	chunk_size(math::round_up(std::max(chunk_size, std::size_t(1)), holo::memory_region::get_page_size())),
+	memory(nullptr),
+	last_block(nullptr),
+	first_level_bitmap(0),
+	free_size(0),
+	free_block_count(0),
+	counter()
+{
+	for (std::size_t i = 0; i < first_level_count; ++i)
+	{
+		second_level_bitmaps[i] = 0;
+
+		for (std::size_t j = 0; j < second_level_count; ++j)
+		{
+			free_lists[i][j] = nullptr;
+		}
+	}
+
+	if (flags & flag_commit_lazily)
+	{
+		memory = memory_region.grow(
+			std::min(this->chunk_size, memory_region.get_reserved_size()));
+	}
+	else
+	{
+		memory = memory_region.claim();
+	}
+
+	if (memory == nullptr)
+	{
+		push_exception(exception::out_of_memory);
+
+		return;
+	}
+
+	// Start with an empty last block at the base, then turn everything after
+	// it into a free block, as if the region had just grown.
+	last_block = (block_header*)memory;
+	last_block->previous_physical = nullptr;
+	last_block->size = 0;
+	add_committed_memory();
+
+	counter.record_memory(memory_region.get_current_size(), memory_region.get_reserved_size());
+}
+
+holo::tlsf_allocator::~tlsf_allocator()
+{
+	// Nothing.
+}
+
+void* holo::tlsf_allocator::allocate(std::size_t size, std::size_t alignment)
+{
+	if (memory == nullptr || size > get_size() || alignment > get_size())
+	{
+		push_exception(exception::out_of_memory);
+
+		return nullptr;
+	}
+
+	std::size_t block_size = math::round_up(std::max(size, minimum_block_size), minimum_block_size);
+
+	// Blocks are aligned on the default alignment. Any stricter alignment may
+	// need to cut a free block off the front of the block found, so leave room
+	// for one.
+	std::size_t search_size = block_size;
+	if (alignment > default_alignment)
+	{
+		search_size += alignment + block_header_size + minimum_block_size;
+	}
+
+	block_header* block = take_free_block(search_size);
+	if (block == nullptr && grow(search_size))
+	{
+		block = take_free_block(search_size);
+	}
+
+	if (block == nullptr)
+	{
+		push_exception(exception::out_of_memory);
+
+		return nullptr;
+	}
+
+	if (alignment > default_alignment)
+	{
+		char* block_memory = (char*)get_block_memory(block);
+		std::size_t gap = get_pointer_distance(align_pointer(block_memory, alignment), block_memory);
+
+		// The gap becomes a free block, so it must fit one.
+		if (gap > 0 && gap < block_header_size + minimum_block_size)
+		{
+			void* pointer = align_pointer(block_memory + block_header_size + minimum_block_size, alignment);
+			gap = get_pointer_distance(pointer, block_memory);
+		}
+
+		if (gap > 0)
+		{
+			block = split_leading_block(block, gap);
+		}
+	}
+
+	split_block(block, block_size);
+
+	block->size &= ~block_free;
+	get_next_physical(block)->size &= ~block_previous_free;
+
+	counter.record_allocation(size, get_block_size(block));
+
+	return get_block_memory(block);
+}
+
+void holo::tlsf_allocator::deallocate(void* pointer)
+{
+	block_header* block = get_block(pointer);
+	holo_assert(!(block->size & block_free));
+
+	counter.record_deallocation(get_block_size(block));
+
+	block->size |= block_free;
+	block = merge_block(block);
+
+	get_next_physical(block)->size |= block_previous_free;
+	insert_free_block(block);
+}
+
+std::size_t holo::tlsf_allocator::get_usable_size(void* pointer)
+{
+	return get_block_size(get_block(pointer));
+}
+
+std::size_t holo::tlsf_allocator::get_size() const
+{
+	if (memory == nullptr)
+	{
+		return 0;
+	}
+
+	return memory_region.get_reserved_size();
+}
+
+std::size_t holo::tlsf_allocator::get_committed_size() const
+{
+	return memory_region.get_current_size();
+}
+
+std::size_t holo::tlsf_allocator::get_free_size() const
+{
+	return free_size;
+}
+
+std::size_t holo::tlsf_allocator::get_free_block_count() const
+{
+	return free_block_count;
+}
+
+void holo::tlsf_allocator::set_statistics_enabled(bool enable)
+{
+	counter.set_enabled(enable);
+}
+
+void holo::tlsf_allocator::get_statistics(holo::allocation_statistics* statistics) const
+{
+	counter.get_statistics(statistics);
+}
+
+std::size_t holo::tlsf_allocator::get_block_size(const block_header* block)
+{
+	return block->size & ~(block_free | block_previous_free);
+}
+
+holo::tlsf_allocator::block_header* holo::tlsf_allocator::get_next_physical(block_header* block)
+{
+	return (block_header*)((char*)get_block_memory(block) + get_block_size(block));
+}
+
+void* holo::tlsf_allocator::get_block_memory(block_header* block)
+{
+	return (char*)block + block_header_size;
+}
+
+holo::tlsf_allocator::block_header* holo::tlsf_allocator::get_block(void* pointer)
+{
+	return (block_header*)((char*)pointer - block_header_size);
+}
+
+std::size_t holo::tlsf_allocator::get_search_size(std::size_t size)
+{
+	// Round up to the next list, so any block in the list found fits.
+	if (size >= ((std::size_t)1 << first_level_shift))
+	{
+		std::size_t shift = math::bit_log2((std::uint64_t)size) - second_level_shift;
+		size += ((std::size_t)1 << shift) - 1;
+	}
+
+	return size;
+}
+
+void holo::tlsf_allocator::get_list(
+	std::size_t size,
+	std::size_t* first_level,
+	std::size_t* second_level)
+{
+	if (size < ((std::size_t)1 << first_level_shift))
+	{
+		// Small blocks are spaced linearly in the first list.
+		*first_level = 0;
+		*second_level = size / minimum_block_size;
+	}
+	else
+	{
+		// The top bit picks the first level, and the next bits below it the
+		// second level.
+		std::size_t top_bit = math::bit_log2((std::uint64_t)size);
+		*first_level = top_bit - (first_level_shift - 1);
+		*second_level = (size >> (top_bit - second_level_shift)) ^ second_level_count;
+	}
+}
+
+void holo::tlsf_allocator::insert_free_block(block_header* block)
+{
+	std::size_t first_level, second_level;
+	get_list(get_block_size(block), &first_level, &second_level);
+	holo_assert(first_level < first_level_count);
+
+	block_header* head = free_lists[first_level][second_level];
+	block->next_free = head;
+	block->previous_free = nullptr;
+	if (head != nullptr)
+	{
+		head->previous_free = block;
+	}
+	free_lists[first_level][second_level] = block;
+
+	first_level_bitmap |= (std::uint64_t)1 << first_level;
+	second_level_bitmaps[first_level] |= (std::uint32_t)1 << second_level;
+
+	free_size += get_block_size(block);
+	++free_block_count;
+}
+
+void holo::tlsf_allocator::remove_free_block(block_header* block)
+{
+	std::size_t first_level, second_level;
+	get_list(get_block_size(block), &first_level, &second_level);
+
+	if (block->previous_free != nullptr)
+	{
+		block->previous_free->next_free = block->next_free;
+	}
+	else
+	{
+		free_lists[first_level][second_level] = block->next_free;
+	}
+
+	if (block->next_free != nullptr)
+	{
+		block->next_free->previous_free = block->previous_free;
+	}
+
+	// Keep the bitmaps in sync with the lists.
+	if (free_lists[first_level][second_level] == nullptr)
+	{
+		second_level_bitmaps[first_level] &= ~((std::uint32_t)1 << second_level);
+
+		if (second_level_bitmaps[first_level] == 0)
+		{
+			first_level_bitmap &= ~((std::uint64_t)1 << first_level);
+		}
+	}
+
+	free_size -= get_block_size(block);
+	--free_block_count;
+}
+
+holo::tlsf_allocator::block_header* holo::tlsf_allocator::take_free_block(std::size_t size)
+{
+	std::size_t first_level, second_level;
+	get_list(get_search_size(size), &first_level, &second_level);
+
+	if (first_level >= first_level_count)
+	{
+		return nullptr;
+	}
+
+	// Look for a list in the same first level first, then for the smallest
+	// non-empty first level above it.
+	std::uint32_t second_level_map = second_level_bitmaps[first_level] & (~0u << second_level);
+	if (second_level_map == 0)
+	{
+		std::uint64_t first_level_map = first_level_bitmap & (~(std::uint64_t)0 << (first_level + 1));
+		if (first_level_map == 0)
+		{
+			return nullptr;
+		}
+
+		first_level = (std::size_t)math::bit_scan_forward(first_level_map);
+		second_level_map = second_level_bitmaps[first_level];
+	}
+
+	second_level = math::bit_scan_forward(second_level_map);
+
+	block_header* block = free_lists[first_level][second_level];
+	remove_free_block(block);
+
+	return block;
+}
+
+void holo::tlsf_allocator::split_block(block_header* block, std::size_t size)
+{
+	std::size_t block_size = get_block_size(block);
+	if (block_size < size + block_header_size + minimum_block_size)
+	{
+		return;
+	}
+
+	block_header* remainder = (block_header*)((char*)get_block_memory(block) + size);
+	remainder->previous_physical = block;
+	remainder->size = (block_size - size - block_header_size) | block_free;
+
+	block->size = size | (block->size & (block_free | block_previous_free));
+
+	block_header* next = get_next_physical(remainder);
+	next->previous_physical = remainder;
+	next->size |= block_previous_free;
+
+	// The block after the remainder can't be free; free blocks never border
+	// each other.
+	insert_free_block(remainder);
+}
+
+holo::tlsf_allocator::block_header* holo::tlsf_allocator::split_leading_block(
+	block_header* block,
+	std::size_t size)
+{
+	holo_assert(size >= block_header_size + minimum_block_size);
+
+	block_header* remainder = (block_header*)((char*)get_block_memory(block) + size - block_header_size);
+	remainder->previous_physical = block;
+	remainder->size = (get_block_size(block) - size) | block_free | block_previous_free;
+
+	block->size = (size - block_header_size) | (block->size & block_previous_free) | block_free;
+	get_next_physical(remainder)->previous_physical = remainder;
+
+	insert_free_block(block);
+
+	return remainder;
+}
+
+holo::tlsf_allocator::block_header* holo::tlsf_allocator::merge_block(block_header* block)
+{
+	if (block->size & block_previous_free)
+	{
+		block_header* previous = block->previous_physical;
+		remove_free_block(previous);
+
+		previous->size += get_block_size(block) + block_header_size;
+		block = previous;
+
+		get_next_physical(block)->previous_physical = block;
+	}
+
+	block_header* next = get_next_physical(block);
+	if (next->size & block_free)
+	{
+		remove_free_block(next);
+
+		block->size += get_block_size(next) + block_header_size;
+
+		get_next_physical(block)->previous_physical = block;
+	}
+
+	return block;
+}
+
+bool holo::tlsf_allocator::grow(std::size_t size)
+{
+	if (!(flags & flag_commit_lazily))
+	{
+		return false;
+	}
+
+	// The new block takes over the header of the last block, and needs a new
+	// last block after it.
+	std::size_t committed_size = memory_region.get_current_size();
+	std::size_t grow_size = math::round_up(get_search_size(size) + block_header_size, chunk_size);
+	grow_size = std::min(grow_size, memory_region.get_reserved_size() - committed_size);
+
+	if (grow_size == 0 || memory_region.grow(grow_size) == nullptr)
+	{
+		return false;
+	}
+
+	add_committed_memory();
+
+	counter.record_memory(memory_region.get_current_size(), memory_region.get_reserved_size());
+
+	return true;
+}
+
+void holo::tlsf_allocator::add_committed_memory()
+{
+	char* end = (char*)memory + memory_region.get_current_size();
+
+	// The last block becomes a free block spanning the new memory.
+	block_header* block = last_block;
+	block->size =
+		get_pointer_distance(end - block_header_size, get_block_memory(block)) |
+		block_free |
+		(block->size & block_previous_free);
+
+	last_block = (block_header*)(end - block_header_size);
+	last_block->previous_physical = block;
+	last_block->size = block_previous_free;
+
+	insert_free_block(merge_block(block));
+}
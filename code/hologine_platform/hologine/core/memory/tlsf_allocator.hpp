@@ -0,0 +1,269 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#ifndef HOLOGINE_CORE_MEMORY_TLSF_ALLOCATOR_HPP_
+#define HOLOGINE_CORE_MEMORY_TLSF_ALLOCATOR_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include "core/memory/allocation_statistics.hpp"
+#include "core/memory/allocator.hpp"
+#include "core/memory/memory_region.hpp"
+
+namespace holo
+{
+	// Allocates blocks of any size in constant time, using a two-level
+	// segregated fit (TLSF).
+	//
+	// Free blocks are kept in lists segregated by size. The first level divides
+	// sizes by powers of two, and the second level divides each power of two
+	// into 32 evenly spaced ranges. A bitmap per level tracks which lists are
+	// non-empty, so finding a free block large enough for a request is a pair
+	// of bit scans, regardless of how many blocks there are. Freed blocks are
+	// merged with their free neighbors immediately.
+	//
+	// Thus both allocation and deallocation take a bounded number of steps,
+	// which makes a TLSF allocator suitable for code with real-time
+	// constraints. The only exception is committing more of the memory region
+	// when committing lazily; allocators that can't afford that should commit
+	// the region up front (the default).
+	//
+	// Every block is preceded by a small header, and blocks are at least
+	// holo::tlsf_allocator::minimum_block_size bytes.
+	//
+	// A TLSF allocator is not thread safe.
+	class tlsf_allocator final : public allocator
+	{
+		public:
+			// Flags that modify the behavior of the TLSF allocator.
+			enum
+			{
+				// Commits the memory region in chunks as allocations are made,
+				// rather than all at once on construction.
+				flag_commit_lazily = 0x00000001
+			};
+
+			// The default number of bytes committed at a time when committing
+			// lazily.
+			static const std::size_t default_chunk_size = 0x10000u;
+
+			// The smallest block, in bytes.
+			//
+			// Smaller requests are rounded up to this size.
+			static const std::size_t minimum_block_size = 0x10u;
+
+			// Constructs a TLSF allocator, reserving 'size' bytes at once.
+			//
+			// If the memory region could not be created, this pushes
+			// holo::exception::out_of_memory, and all further allocations will
+			// fail.
+			//
+			// If 'flags' includes flag_commit_lazily, the region is only reserved
+			// on construction, and memory is committed 'chunk_size' bytes at a
+			// time as needed.
+			explicit tlsf_allocator(
+				std::size_t size,
+				int flags = 0,
+				std::size_t chunk_size = default_chunk_size);
+
+			// Releases the memory region.
+			//
+			// Any memory allocated by this instance is no longer valid.
+			~tlsf_allocator();
+
+			using holo::allocator::deallocate;
+
+			// Allocates a block of memory 'size' bytes large, aligned on
+			// 'alignment' bytes.
+			//
+			// Returns NULL on failure and pushes holo::exception::out_of_memory.
+			// Failure occurs if no free block is large enough and the region
+			// can't be grown.
+			void* allocate(std::size_t size, std::size_t alignment = default_alignment) override;
+
+			// Deallocates a block, merging it with its free neighbors.
+			void deallocate(void* pointer) override;
+
+			// Gets the number of bytes usable starting at 'pointer'.
+			//
+			// This is the size of the block, which may be larger than requested.
+			std::size_t get_usable_size(void* pointer) override;
+
+			// Gets the size of the underlying memory region.
+			std::size_t get_size() const;
+
+			// Gets the number of bytes currently committed.
+			//
+			// Unless the allocator commits lazily, this is the same as
+			// holo::tlsf_allocator::get_size().
+			std::size_t get_committed_size() const;
+
+			// Gets the number of bytes held by free blocks, excluding their
+			// headers.
+			std::size_t get_free_size() const;
+
+			// Gets the number of free blocks.
+			//
+			// Since free blocks are merged immediately, this is a measure of
+			// external fragmentation.
+			std::size_t get_free_block_count() const;
+
+			// Enables or disables gathering allocation statistics.
+			//
+			// Statistics are disabled by default.
+			void set_statistics_enabled(bool enable);
+
+			// Takes a snapshot of the allocation statistics.
+			//
+			// The allocated size of a block excludes its header.
+			void get_statistics(holo::allocation_statistics* statistics) const;
+
+		private:
+			// Precedes every block.
+			struct block_header
+			{
+				// The block immediately before this one in memory, or NULL if this is
+				// the first block.
+				block_header* previous_physical;
+
+				// Size of the block, not including the header, along with
+				// 'block_free' and 'block_previous_free' in the lowest bits.
+				std::size_t size;
+
+				// The next free block in the same list.
+				//
+				// This and the following field are only valid if the block is free;
+				// otherwise, they are part of the allocation.
+				block_header* next_free;
+
+				// The previous free block in the same list.
+				block_header* previous_free;
+			};
+
+			// Set in block_header::size if the block is free.
+			static const std::size_t block_free = 0x1u;
+
+			// Set in block_header::size if the previous block is free.
+			static const std::size_t block_previous_free = 0x2u;
+
+			// Size of the part of block_header that is not overlapped by the
+			// allocation.
+			static const std::size_t block_header_size = sizeof(block_header*) + sizeof(std::size_t);
+
+			// The log2 of the number of second level lists per first level.
+			static const std::size_t second_level_shift = 5;
+
+			// The number of second level lists per first level.
+			static const std::size_t second_level_count = (std::size_t)1 << second_level_shift;
+
+			// The log2 of the smallest size past the first level.
+			//
+			// Blocks smaller than this are spaced linearly by the minimum block
+			// size in the first level.
+			static const std::size_t first_level_shift = second_level_shift + 4;
+
+			// The number of first levels.
+			//
+			// This supports blocks up to 256 terabytes.
+			static const std::size_t first_level_count = 48 - first_level_shift + 1;
+
+			// Gets the size of a block.
+			static std::size_t get_block_size(const block_header* block);
+
+			// Gets the block after 'block' in memory.
+			static block_header* get_next_physical(block_header* block);
+
+			// Gets the memory handed out for a block.
+			static void* get_block_memory(block_header* block);
+
+			// Gets the block from a pointer previously handed out.
+			static block_header* get_block(void* pointer);
+
+			// Rounds 'size' up so that any block in the list of the result is at
+			// least 'size' bytes.
+			static std::size_t get_search_size(std::size_t size);
+
+			// Finds the first and second level indices of the list holding blocks
+			// of 'size' bytes.
+			static void get_list(std::size_t size, std::size_t* first_level, std::size_t* second_level);
+
+			// Inserts a free block into its list.
+			void insert_free_block(block_header* block);
+
+			// Removes a free block from its list.
+			void remove_free_block(block_header* block);
+
+			// Takes a free block of at least 'size' bytes out of its list.
+			//
+			// Returns NULL if there is no such block.
+			block_header* take_free_block(std::size_t size);
+
+			// Splits the end of 'block' off into a new free block, leaving 'block'
+			// with 'size' bytes, if the remainder is large enough.
+			void split_block(block_header* block, std::size_t size);
+
+			// Splits off the first 'size' bytes of a free block (including the
+			// header of the remaining block) into a new free block, and returns
+			// the remaining block.
+			block_header* split_leading_block(block_header* block, std::size_t size);
+
+			// Merges a free block with its free neighbors, and returns the merged
+			// block.
+			//
+			// The block must not be in any list; its neighbors are taken out of
+			// theirs.
+			block_header* merge_block(block_header* block);
+
+			// Commits enough of the region for a free block of 'size' bytes at the
+			// end.
+			//
+			// Returns false if the region could not be grown.
+			bool grow(std::size_t size);
+
+			// Turns the memory committed past the last block into a free block.
+			void add_committed_memory();
+
+			// Memory region used to back allocations.
+			holo::memory_region memory_region;
+
+			// Flags provided on construction.
+			int flags;
+
+			// Number of bytes committed at a time, when committing lazily.
+			std::size_t chunk_size;
+
+			// Pointer to the beginning of the memory region.
+			void* memory;
+
+			// The zero-sized, allocated block at the end of the committed memory.
+			//
+			// It keeps the last real block from merging past the committed memory.
+			block_header* last_block;
+
+			// Bitmap of the first levels with a free block.
+			std::uint64_t first_level_bitmap;
+
+			// Bitmaps of the second level lists with a free block, per first level.
+			std::uint32_t second_level_bitmaps[first_level_count];
+
+			// The free lists.
+			block_header* free_lists[first_level_count][second_level_count];
+
+			// Bytes held by free blocks.
+			std::size_t free_size;
+
+			// Number of free blocks.
+			std::size_t free_block_count;
+
+			// Allocation statistics.
+			holo::allocation_counter counter;
+	};
+}
+
+#endif
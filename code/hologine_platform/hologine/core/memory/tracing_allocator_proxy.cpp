@@ -0,0 +1,128 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include "core/exception.hpp"
+#include "core/memory/tracing_allocator_proxy.hpp"
+#include "core/threading/scoped_lock.hpp"
+
+holo::tracing_allocator_proxy::tracing_allocator_proxy(
+	holo::allocator* allocator,
+	holo::stream_interface* stream) :
+		allocator(allocator),
+		writer(stream),
+		thread_count(0),
+		start(std::chrono::steady_clock::now())
+{
+	holo_assert(allocator != nullptr);
+}
+
+holo::tracing_allocator_proxy::~tracing_allocator_proxy()
+{
+	// Nothing.
+}
+
+void* holo::tracing_allocator_proxy::allocate(std::size_t size, std::size_t alignment)
+{
+	holo::scoped_lock lock(mutex);
+
+	void* pointer = allocator->allocate(size, alignment);
+	record(allocation_event::kind_allocate, pointer, size, alignment);
+
+	return pointer;
+}
+
+void holo::tracing_allocator_proxy::deallocate(void* pointer)
+{
+	holo::scoped_lock lock(mutex);
+
+	allocator->deallocate(pointer);
+	record(allocation_event::kind_deallocate, pointer, 0, 0);
+}
+
+void holo::tracing_allocator_proxy::deallocate(void* pointer, std::size_t size, std::size_t alignment)
+{
+	holo::scoped_lock lock(mutex);
+
+	allocator->deallocate(pointer, size, alignment);
+	record(allocation_event::kind_sized_deallocate, pointer, size, alignment);
+}
+
+std::size_t holo::tracing_allocator_proxy::get_usable_size(void* pointer)
+{
+	holo::scoped_lock lock(mutex);
+
+	return allocator->get_usable_size(pointer);
+}
+
+std::size_t holo::tracing_allocator_proxy::allocate_batch(
+	std::size_t size,
+	std::size_t count,
+	void** pointers,
+	std::size_t alignment)
+{
+	holo::scoped_lock lock(mutex);
+
+	std::size_t allocated = allocator->allocate_batch(size, count, pointers, alignment);
+	for (std::size_t i = 0; i < allocated; ++i)
+	{
+		record(allocation_event::kind_allocate, pointers[i], size, alignment);
+	}
+
+	return allocated;
+}
+
+void holo::tracing_allocator_proxy::deallocate_batch(void** pointers, std::size_t count)
+{
+	holo::scoped_lock lock(mutex);
+
+	allocator->deallocate_batch(pointers, count);
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		record(allocation_event::kind_deallocate, pointers[i], 0, 0);
+	}
+}
+
+bool holo::tracing_allocator_proxy::flush()
+{
+	holo::scoped_lock lock(mutex);
+
+	return writer.flush();
+}
+
+std::uint64_t holo::tracing_allocator_proxy::get_event_count()
+{
+	holo::scoped_lock lock(mutex);
+
+	return writer.get_event_count();
+}
+
+void holo::tracing_allocator_proxy::record(
+	int kind,
+	void* pointer,
+	std::size_t size,
+	std::size_t alignment)
+{
+	std::size_t index = (std::size_t)(void*)thread_index;
+	if (index == 0)
+	{
+		index = ++thread_count;
+		thread_index = (void*)index;
+	}
+
+	holo::allocation_event event;
+	event.kind = kind;
+	event.thread = (std::uint32_t)(index - 1);
+	event.timestamp = (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - start).count();
+	event.address = (std::uint64_t)(std::uintptr_t)pointer;
+	event.size = size;
+	event.alignment = alignment;
+
+	writer.write(event);
+}
@@ -0,0 +1,109 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#ifndef HOLOGINE_CORE_MEMORY_TRACING_ALLOCATOR_PROXY_HPP_
+#define HOLOGINE_CORE_MEMORY_TRACING_ALLOCATOR_PROXY_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include "core/memory/allocation_trace.hpp"
+#include "core/memory/allocator.hpp"
+#include "core/threading/mutex.hpp"
+#include "core/threading/thread_local_variable.hpp"
+
+namespace holo
+{
+	class stream_interface;
+
+	// Records every call to an allocator in an allocation trace.
+	//
+	// Each allocation and deallocation is forwarded to the underlying
+	// allocator, then recorded with its size, alignment, calling thread and
+	// time; see holo::allocation_trace_writer for the encoding. Batch calls are
+	// recorded as individual events. The trace can later be replayed against
+	// any other allocator with holo::allocation_trace_reader.
+	//
+	// Calls are serialized by a mutex, so that the order of events in the
+	// trace is the order in which the underlying allocator saw them. Thus the
+	// proxy is thread safe even if the underlying allocator is not, but it
+	// should only be used when a trace is wanted.
+	class tracing_allocator_proxy final : public allocator
+	{
+		public:
+			// Constructs a tracing proxy to 'allocator', writing the trace to
+			// 'stream'.
+			//
+			// Both must outlive the proxy.
+			tracing_allocator_proxy(holo::allocator* allocator, holo::stream_interface* stream);
+
+			// Flushes the trace.
+			~tracing_allocator_proxy();
+
+			// Implementation.
+			void* allocate(std::size_t size, std::size_t alignment = default_alignment) override;
+
+			// Implementation.
+			void deallocate(void* pointer) override;
+
+			// Implementation.
+			void deallocate(void* pointer, std::size_t size, std::size_t alignment = default_alignment) override;
+
+			// Implementation.
+			//
+			// Queries are not recorded.
+			std::size_t get_usable_size(void* pointer) override;
+
+			// Implementation.
+			std::size_t allocate_batch(
+				std::size_t size,
+				std::size_t count,
+				void** pointers,
+				std::size_t alignment = default_alignment) override;
+
+			// Implementation.
+			void deallocate_batch(void** pointers, std::size_t count) override;
+
+			// Writes any buffered events to the stream.
+			//
+			// Returns false if the stream could not be written; the trace is then
+			// truncated, and calls are no longer recorded.
+			bool flush();
+
+			// Gets the number of events recorded.
+			std::uint64_t get_event_count();
+
+		private:
+			// Records an event made by the calling thread.
+			//
+			// The mutex must be held.
+			void record(int kind, void* pointer, std::size_t size, std::size_t alignment);
+
+			// Underlying allocator.
+			holo::allocator* allocator;
+
+			// Encodes the trace.
+			holo::allocation_trace_writer writer;
+
+			// Serializes calls and recording.
+			holo::mutex mutex;
+
+			// Index of the calling thread in the trace, plus one, or NULL if the
+			// thread has yet to make a call.
+			holo::thread_local_variable<void> thread_index;
+
+			// Number of threads that have made a call.
+			std::uint32_t thread_count;
+
+			// When the trace started.
+			std::chrono::steady_clock::time_point start;
+	};
+}
+
+#endif
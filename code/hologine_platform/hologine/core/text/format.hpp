@@ -10,7 +10,9 @@
 #ifndef HOLOGINE_CORE_TEXT_FORMAT_HPP_
 #define HOLOGINE_CORE_TEXT_FORMAT_HPP_
 
+#include <cstddef>
 #include <cstdio>
+#include <type_traits>
 #include "core/text/string_builder.hpp"
 
 namespace holo
@@ -188,8 +190,18 @@ namespace holo
 					}
 				};
 
+				// std::size_t is usually an alias of one of the types above, in which
+				// case specializing it again would be a redefinition. Only specialize
+				// it when it's a distinct type.
+				struct size_alias {};
+				typedef typename std::conditional<
+					std::is_same<std::size_t, unsigned int>::value ||
+						std::is_same<std::size_t, long unsigned int>::value,
+					size_alias,
+					std::size_t>::type distinct_size;
+
 				template <class Unused>
-				struct length_specifier<std::size_t, Unused>
+				struct length_specifier<distinct_size, Unused>
 				{
 					static const char* spec()
 					{
@@ -19,13 +19,13 @@ holo::thread::thread(holo::thread_callback callback, void* userdata)
 	else
 	{
 		init_argument(callback, userdata);
-		create_thread(&argument);
+		set_argument_flag(create_thread(&argument) ? flag_thread_created : flag_thread_invalid, true);
 	}
 }
 
 holo::thread::~thread()
 {
-	if (!get_argument_flag(flag_thread_exited))
+	if (get_argument_flag(flag_thread_started) && !get_argument_flag(flag_thread_exited))
 	{
 		join();
 	}
@@ -41,7 +41,14 @@ void holo::thread::start()
 	}
 	else
 	{
-		run_thread();
+		// The flags are read by the new thread, so they must be settled before
+		// it starts.
+		set_argument_flag(flag_thread_started, true);
+
+		if (!run_thread())
+		{
+			set_argument_flag(flag_thread_started, false);
+		}
 	}
 }
 
@@ -61,7 +68,17 @@ void holo::thread::start(holo::thread_callback callback, void* userdata)
 	{
 		argument.callback = callback;
 		argument.userdata = userdata;
-		create_thread(&argument);
+
+		// Unlike holo::thread::start(), this begins executing immediately.
+		if (create_thread(&argument))
+		{
+			set_argument_flag(flag_thread_created, true);
+			start();
+		}
+		else
+		{
+			invalidate();
+		}
 	}
 }
 
@@ -69,7 +86,7 @@ holo::thread_return_status holo::thread::join()
 {
 	// This method can only be called if the holo::thread_base object is valid and
 	// the underlying thread has been created.
-	if (!is_valid() || !get_argument_flag(flag_thread_started))
+	if (!is_valid() || !get_argument_flag(flag_thread_started) || get_argument_flag(flag_thread_exited))
 	{
 		push_exception(exception::invalid_operation);
 	}
@@ -77,6 +94,8 @@ holo::thread_return_status holo::thread::join()
 	{
 		if (join_thread())
 		{
+			set_argument_flag(flag_thread_exited, true);
+
 			return argument.return_status;
 		}
 	}
@@ -0,0 +1,813 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include <atomic>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include "core/exception.hpp"
+#include "core/platform_linux.hpp"
+#include "core/memory/memory_region_base.hpp"
+
+namespace
+{
+	// The tracking state of a page.
+	enum
+	{
+		// Writes to the page are not tracked.
+		page_untracked = 0,
+
+		// The page is write protected; the next write marks it dirty.
+		page_clean = 1,
+
+		// The page was written since it was last marked clean.
+		page_dirty = 2,
+
+		// The page is dirty and being write protected; it becomes clean unless
+		// written to in the meantime.
+		page_cleaning = 3
+	};
+
+	// A range of pages whose writes are tracked.
+	struct tracked_region
+	{
+		// Base of the range, or NULL if the record is unused.
+		//
+		// This is published last, so the fault handler sees a complete record.
+		std::atomic<char*> base;
+
+		// Size of the range, in bytes.
+		std::size_t size;
+
+		// The state of each page.
+		std::atomic<std::uint8_t>* page_states;
+	};
+
+	// The maximum number of memory regions that can be tracked at once.
+	const std::size_t max_tracked_region_count = 64;
+
+	// The tracked regions; the fault handler only reads these.
+	tracked_region tracked_regions[max_tracked_region_count];
+
+	// Serializes changes to the set of tracked regions.
+	pthread_mutex_t tracked_regions_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+	// The SIGSEGV action installed before the fault handler, if any.
+	struct sigaction previous_fault_action;
+
+	// Whether the fault handler has been installed.
+	bool is_fault_handler_installed = false;
+}
+
+// Finds the record tracking the range based at 'base', or NULL if there is no
+// such record.
+static tracked_region* find_tracked_region(void* base)
+{
+	for (std::size_t i = 0; i < max_tracked_region_count; ++i)
+	{
+		if (tracked_regions[i].base.load(std::memory_order_acquire) == base)
+		{
+			return &tracked_regions[i];
+		}
+	}
+
+	return nullptr;
+}
+
+// Marks a write protected page dirty and lets the faulting write through.
+//
+// Faults anywhere else are passed on to the previous handler, or, if there was
+// none, the default action is restored so the write faults again and takes
+// the process down as usual.
+static void handle_write_fault(int signal_number, siginfo_t* info, void* context)
+{
+	char* address = (char*)info->si_addr;
+	std::size_t page_size = holo::memory_region_base::get_page_size();
+
+	for (std::size_t i = 0; i < max_tracked_region_count; ++i)
+	{
+		tracked_region& region = tracked_regions[i];
+		char* base = region.base.load(std::memory_order_acquire);
+
+		if (base == nullptr || address < base || address >= base + region.size)
+		{
+			continue;
+		}
+
+		std::size_t index = (address - base) / page_size;
+		std::atomic<std::uint8_t>& state = region.page_states[index];
+
+		// A dirty page can still fault if another thread beat this one to it.
+		if (state.load(std::memory_order_acquire) != page_untracked)
+		{
+			state.store(page_dirty, std::memory_order_release);
+
+			if (mprotect(base + index * page_size, page_size, PROT_READ | PROT_WRITE) == 0)
+			{
+				return;
+			}
+		}
+
+		break;
+	}
+
+	if (previous_fault_action.sa_flags & SA_SIGINFO)
+	{
+		previous_fault_action.sa_sigaction(signal_number, info, context);
+	}
+	else if (previous_fault_action.sa_handler != SIG_DFL && previous_fault_action.sa_handler != SIG_IGN)
+	{
+		previous_fault_action.sa_handler(signal_number);
+	}
+	else
+	{
+		struct sigaction default_action;
+		std::memset(&default_action, 0, sizeof(default_action));
+		default_action.sa_handler = SIG_DFL;
+		sigemptyset(&default_action.sa_mask);
+
+		sigaction(signal_number, &default_action, nullptr);
+	}
+}
+
+// Reads the transparent huge page size from sysfs, falling back to the common
+// 2mb size if it is unavailable.
+static std::size_t query_huge_page_size()
+{
+	unsigned long long huge_page_size = 0;
+
+	std::FILE* file = std::fopen("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", "r");
+	if (file != nullptr)
+	{
+		if (std::fscanf(file, "%llu", &huge_page_size) != 1)
+		{
+			huge_page_size = 0;
+		}
+
+		std::fclose(file);
+	}
+
+	if (huge_page_size == 0)
+	{
+		huge_page_size = 0x200000u;
+	}
+
+	return (std::size_t)huge_page_size;
+}
+
+holo::memory_region_base::memory_region_base() :
+	file_descriptor(-1),
+	is_file_writable(false),
+	is_file_populated(false),
+	is_file_shared(false),
+	mirror_size(0)
+{
+	// Nothing.
+}
+
+holo::memory_region_base::memory_region_base(memory_region_base&& other) :
+	file_descriptor(other.file_descriptor),
+	is_file_writable(other.is_file_writable),
+	is_file_populated(other.is_file_populated),
+	is_file_shared(other.is_file_shared),
+	mirror_size(other.mirror_size)
+{
+	other.file_descriptor = -1;
+	other.mirror_size = 0;
+}
+
+holo::memory_region_base& holo::memory_region_base::operator =(memory_region_base&& other)
+{
+	if (file_descriptor != -1)
+	{
+		close(file_descriptor);
+	}
+
+	file_descriptor = other.file_descriptor;
+	is_file_writable = other.is_file_writable;
+	is_file_populated = other.is_file_populated;
+	is_file_shared = other.is_file_shared;
+	mirror_size = other.mirror_size;
+
+	other.file_descriptor = -1;
+	other.mirror_size = 0;
+
+	return *this;
+}
+
+holo::memory_region_base::~memory_region_base()
+{
+	// The mappings keep their own reference to the file, but by now they've
+	// been released anyway.
+	if (file_descriptor != -1)
+	{
+		close(file_descriptor);
+	}
+}
+
+bool holo::memory_region_base::open_file(
+	const char* path,
+	bool writable,
+	bool populate,
+	std::size_t* size)
+{
+	holo_assert(file_descriptor == -1);
+
+	// Writes to a writable mapping are private, so the file itself is only
+	// ever read.
+	int descriptor = open(path, O_RDONLY | O_CLOEXEC);
+	if (descriptor == -1)
+	{
+		push_exception(exception::platform, errno);
+
+		return false;
+	}
+
+	struct stat status;
+	if (fstat(descriptor, &status) != 0)
+	{
+		push_exception(exception::platform, errno);
+		close(descriptor);
+
+		return false;
+	}
+
+	file_descriptor = descriptor;
+	is_file_writable = writable;
+	is_file_populated = populate;
+	is_file_shared = false;
+	*size = (std::size_t)status.st_size;
+
+	return true;
+}
+
+bool holo::memory_region_base::open_shared_memory(
+	const char* name,
+	bool create,
+	bool writable,
+	std::size_t* size)
+{
+	holo_assert(file_descriptor == -1);
+
+	int open_flags = (writable ? O_RDWR : O_RDONLY) | O_CLOEXEC;
+	if (create)
+	{
+		open_flags |= O_CREAT | O_EXCL;
+	}
+
+	int descriptor = shm_open(name, open_flags, 0600);
+	if (descriptor == -1)
+	{
+		push_exception(exception::platform, errno);
+
+		return false;
+	}
+
+	if (create)
+	{
+		// The object starts out empty; extending it allocates nothing until the
+		// pages are touched.
+		if (ftruncate(descriptor, (off_t)*size) != 0)
+		{
+			push_exception(exception::platform, errno);
+			close(descriptor);
+			shm_unlink(name);
+
+			return false;
+		}
+	}
+	else
+	{
+		struct stat status;
+		if (fstat(descriptor, &status) != 0)
+		{
+			push_exception(exception::platform, errno);
+			close(descriptor);
+
+			return false;
+		}
+
+		*size = (std::size_t)status.st_size;
+	}
+
+	file_descriptor = descriptor;
+	is_file_writable = writable;
+	is_file_populated = false;
+	is_file_shared = true;
+
+	return true;
+}
+
+bool holo::memory_region_base::is_file_open() const
+{
+	return file_descriptor != -1 && mirror_size == 0;
+}
+
+void* holo::memory_region_base::reserve_pages(std::size_t max_pages)
+{
+	if (file_descriptor != -1)
+	{
+		// Map the file inaccessibly; this reserves the range, and committing
+		// pages then only has to replace parts of the mapping.
+		void* memory = mmap(
+			nullptr,
+			max_pages * get_page_size(),
+			PROT_NONE,
+			MAP_PRIVATE | MAP_NORESERVE,
+			file_descriptor, 0);
+
+		if (memory == MAP_FAILED)
+		{
+			push_exception(exception::platform, errno);
+
+			return nullptr;
+		}
+
+		return memory;
+	}
+
+	// PROT_NONE keeps the range from being touched until it is committed, while
+	// MAP_NORESERVE prevents the kernel from charging the entire reservation
+	// against the commit limit up front.
+	void* memory = mmap(
+		nullptr,
+		max_pages * get_page_size(),
+		PROT_NONE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+		-1, 0);
+	
+	if (memory == MAP_FAILED)
+	{
+		push_exception(exception::platform, errno);
+		
+		return nullptr;
+	}
+	
+	return memory;
+}
+
+void* holo::memory_region_base::reserve_mirrored_pages(std::size_t max_pages)
+{
+	holo_assert(file_descriptor == -1);
+
+	std::size_t size = max_pages * get_page_size();
+
+	// The memfd has no name in the file system, and its pages are only
+	// allocated as they are touched.
+	int descriptor = memfd_create("hologine_mirror", MFD_CLOEXEC);
+	if (descriptor == -1)
+	{
+		push_exception(exception::platform, errno);
+
+		return nullptr;
+	}
+
+	if (ftruncate(descriptor, (off_t)size) != 0)
+	{
+		push_exception(exception::platform, errno);
+		close(descriptor);
+
+		return nullptr;
+	}
+
+	// Reserve both views at once so they are guaranteed to be adjacent, then
+	// map the memfd over each half.
+	char* memory = (char*)mmap(
+		nullptr,
+		size * 2,
+		PROT_NONE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+		-1, 0);
+
+	if (memory == MAP_FAILED)
+	{
+		push_exception(exception::platform, errno);
+		close(descriptor);
+
+		return nullptr;
+	}
+
+	for (std::size_t i = 0; i < 2; ++i)
+	{
+		void* view = mmap(
+			memory + i * size,
+			size,
+			PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_FIXED,
+			descriptor, 0);
+
+		if (view == MAP_FAILED)
+		{
+			push_exception(exception::platform, errno);
+			munmap(memory, size * 2);
+			close(descriptor);
+
+			return nullptr;
+		}
+	}
+
+	file_descriptor = descriptor;
+	mirror_size = size;
+
+	return memory;
+}
+
+void holo::memory_region_base::release_pages(void* base, std::size_t index, std::size_t count)
+{
+	if (mirror_size != 0)
+	{
+		// Both views go at once, along with the memfd.
+		holo_assert(index == 0 && count * get_page_size() == mirror_size);
+
+		if (munmap(base, mirror_size * 2) != 0)
+		{
+			push_exception(exception::platform, errno);
+		}
+
+		close(file_descriptor);
+		file_descriptor = -1;
+		mirror_size = 0;
+
+		return;
+	}
+
+	if (munmap((char*)base + index * get_page_size(), count * get_page_size()) != 0)
+	{
+		push_exception(exception::platform, errno);
+	}
+}
+
+bool holo::memory_region_base::commit_pages(void* base, std::size_t index, std::size_t count)
+{
+	// Both views of a mirrored region stay mapped; the memfd allocates pages
+	// on first touch.
+	if (mirror_size != 0)
+	{
+		return true;
+	}
+
+	if (file_descriptor != -1)
+	{
+		// A read-only mapping is shared, so the pages are the page cache's own.
+		// A writable one is private, so writes are copied on demand, unless the
+		// whole point is to share them.
+		if (is_file_writable && is_file_shared)
+		{
+			return map_file_pages(base, index, count, PROT_READ | PROT_WRITE, MAP_SHARED);
+		}
+
+		if (is_file_writable)
+		{
+			return map_file_pages(
+				base, index, count,
+				PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | (is_file_populated ? MAP_POPULATE : 0));
+		}
+
+		return map_file_pages(
+			base, index, count,
+			PROT_READ,
+			MAP_SHARED | (is_file_populated ? MAP_POPULATE : 0));
+	}
+
+	// The pages are backed lazily by the kernel on first touch; making them
+	// accessible is all that's necessary.
+	if (mprotect(
+		(char*)base + index * get_page_size(),
+		count * get_page_size(),
+		PROT_READ | PROT_WRITE) != 0)
+	{
+		push_exception(exception::platform, errno);
+		
+		return false;
+	}
+	
+	return true;
+}
+
+void holo::memory_region_base::decommit_pages(void* base, std::size_t index, std::size_t count)
+{
+	if (mirror_size != 0)
+	{
+		// Punching a hole in the memfd frees the pages of both views, which
+		// then read as zero.
+		if (fallocate(
+			file_descriptor,
+			FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+			(off_t)(index * get_page_size()),
+			(off_t)(count * get_page_size())) != 0)
+		{
+			push_exception(exception::platform, errno);
+		}
+
+		return;
+	}
+
+	if (file_descriptor != -1)
+	{
+		// Replacing the mapping drops private copies of the pages, so they read
+		// from the file again once recommitted. Shared pages only lose this
+		// view; their contents live on in the object.
+		map_file_pages(base, index, count, PROT_NONE, MAP_PRIVATE | MAP_NORESERVE);
+
+		return;
+	}
+
+	void* pages = (char*)base + index * get_page_size();
+	std::size_t size = count * get_page_size();
+
+	// MADV_DONTNEED is used rather than MADV_FREE. The latter only frees pages
+	// once the system is under memory pressure, which would leave the resident
+	// set at its peak; it also does not guarantee recommitted pages are zeroed,
+	// unlike MEM_DECOMMIT on Windows.
+	if (madvise(pages, size, MADV_DONTNEED) != 0)
+	{
+		push_exception(exception::platform, errno);
+	}
+
+	// Like a decommitted page on Windows, touching the page should fault.
+	if (mprotect(pages, size, PROT_NONE) != 0)
+	{
+		push_exception(exception::platform, errno);
+	}
+}
+
+void holo::memory_region_base::advise_huge_pages(void* base, std::size_t index, std::size_t count)
+{
+	// Transparent huge pages are used rather than hugetlbfs. A MAP_HUGETLB
+	// mapping draws from a pool the administrator must reserve in advance, and
+	// lazily committing from it can fail with SIGBUS rather than an error.
+	//
+	// The advice is recorded on the mapping itself, so it is safe to give while
+	// the range is still PROT_NONE; pages will be collapsed into huge pages as
+	// aligned spans are committed and touched.
+	if (madvise((char*)base + index * get_page_size(), count * get_page_size(), MADV_HUGEPAGE) != 0)
+	{
+		// EINVAL is returned if the kernel was built without transparent huge
+		// page support. That's not an error; the hint just can't be honored.
+		if (errno != EINVAL)
+		{
+			push_exception(exception::platform, errno);
+		}
+	}
+}
+
+void holo::memory_region_base::advise_will_need(void* base, std::size_t index, std::size_t count)
+{
+	// For a file this starts reading the pages in the background; anonymous
+	// pages are brought back from swap.
+	if (madvise((char*)base + index * get_page_size(), count * get_page_size(), MADV_WILLNEED) != 0)
+	{
+		push_exception(exception::platform, errno);
+	}
+}
+
+std::size_t holo::memory_region_base::get_page_size()
+{
+	// Unlike Windows, the page size varies between architectures (e.g., 16kb
+	// or 64kb pages on some ARM64 kernels), so query it once and cache it.
+	static const std::size_t page_size = (std::size_t)sysconf(_SC_PAGESIZE);
+
+	return page_size;
+}
+
+std::size_t holo::memory_region_base::get_granularity()
+{
+	// mmap places mappings on page boundaries; there is no coarser allocation
+	// granularity like the 64kb boundary of VirtualAlloc.
+	return get_page_size();
+}
+
+std::size_t holo::memory_region_base::get_huge_page_size()
+{
+	// Transparent huge pages are PMD-sized, which is 2mb on x86_64 (and ARM64
+	// with 4kb base pages). The kernel exposes the actual value, but reading
+	// sysfs for every query is pointless; cache it.
+	static const std::size_t huge_page_size = query_huge_page_size();
+
+	return huge_page_size;
+}
+
+bool holo::memory_region_base::remove_shared_memory(const char* name)
+{
+	if (shm_unlink(name) != 0)
+	{
+		push_exception(exception::platform, errno);
+
+		return false;
+	}
+
+	return true;
+}
+
+bool holo::memory_region_base::map_file_pages(
+	void* base,
+	std::size_t index,
+	std::size_t count,
+	int protection,
+	int flags)
+{
+	void* pages = mmap(
+		(char*)base + index * get_page_size(),
+		count * get_page_size(),
+		protection,
+		flags | MAP_FIXED,
+		file_descriptor,
+		(off_t)(index * get_page_size()));
+
+	if (pages == MAP_FAILED)
+	{
+		push_exception(exception::platform, errno);
+
+		return false;
+	}
+
+	return true;
+}
+
+bool holo::memory_region_base::begin_tracking_pages(void* base, std::size_t max_pages)
+{
+	// The fault handler queries the page size, so make sure it's cached first.
+	std::size_t page_size = get_page_size();
+
+	pthread_mutex_lock(&tracked_regions_mutex);
+
+	if (!is_fault_handler_installed)
+	{
+		struct sigaction action;
+		std::memset(&action, 0, sizeof(action));
+		action.sa_sigaction = &handle_write_fault;
+		action.sa_flags = SA_SIGINFO;
+		sigemptyset(&action.sa_mask);
+
+		if (sigaction(SIGSEGV, &action, &previous_fault_action) != 0)
+		{
+			push_exception(exception::platform, errno);
+			pthread_mutex_unlock(&tracked_regions_mutex);
+
+			return false;
+		}
+
+		is_fault_handler_installed = true;
+	}
+
+	tracked_region* region = find_tracked_region(nullptr);
+	if (region == nullptr)
+	{
+		push_exception(exception::invalid_operation);
+		pthread_mutex_unlock(&tracked_regions_mutex);
+
+		return false;
+	}
+
+	// A byte per page; fresh anonymous memory is zeroed, which leaves every
+	// page untracked.
+	void* page_states = mmap(
+		nullptr,
+		max_pages,
+		PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS,
+		-1, 0);
+
+	if (page_states == MAP_FAILED)
+	{
+		push_exception(exception::platform, errno);
+		pthread_mutex_unlock(&tracked_regions_mutex);
+
+		return false;
+	}
+
+	region->size = max_pages * page_size;
+	region->page_states = (std::atomic<std::uint8_t>*)page_states;
+	region->base.store((char*)base, std::memory_order_release);
+
+	pthread_mutex_unlock(&tracked_regions_mutex);
+
+	return true;
+}
+
+void holo::memory_region_base::end_tracking_pages(void* base)
+{
+	pthread_mutex_lock(&tracked_regions_mutex);
+
+	tracked_region* region = find_tracked_region(base);
+	if (region != nullptr)
+	{
+		std::size_t page_size = get_page_size();
+		std::size_t page_count = region->size / page_size;
+
+		// Lift the write protection of clean pages.
+		for (std::size_t i = 0; i < page_count; ++i)
+		{
+			if (region->page_states[i].load(std::memory_order_relaxed) == page_clean)
+			{
+				if (mprotect((char*)base + i * page_size, page_size, PROT_READ | PROT_WRITE) != 0)
+				{
+					push_exception(exception::platform, errno);
+				}
+			}
+		}
+
+		region->base.store(nullptr, std::memory_order_release);
+
+		if (munmap((void*)region->page_states, page_count) != 0)
+		{
+			push_exception(exception::platform, errno);
+		}
+		region->page_states = nullptr;
+		region->size = 0;
+	}
+
+	pthread_mutex_unlock(&tracked_regions_mutex);
+}
+
+void holo::memory_region_base::mark_pages_dirty(void* base, std::size_t index, std::size_t count)
+{
+	tracked_region* region = find_tracked_region(base);
+	holo_assert(region != nullptr);
+
+	for (std::size_t i = index; i < index + count; ++i)
+	{
+		region->page_states[i].store(page_dirty, std::memory_order_release);
+	}
+}
+
+void holo::memory_region_base::mark_pages_untracked(void* base, std::size_t index, std::size_t count)
+{
+	tracked_region* region = find_tracked_region(base);
+	holo_assert(region != nullptr);
+
+	for (std::size_t i = index; i < index + count; ++i)
+	{
+		region->page_states[i].store(page_untracked, std::memory_order_release);
+	}
+}
+
+bool holo::memory_region_base::clear_dirty_pages(void* base, std::size_t index, std::size_t count)
+{
+	tracked_region* region = find_tracked_region(base);
+	holo_assert(region != nullptr);
+
+	std::size_t page_size = get_page_size();
+	std::size_t end = index + count;
+	std::size_t i = index;
+
+	while (i < end)
+	{
+		if (region->page_states[i].load(std::memory_order_acquire) != page_dirty)
+		{
+			++i;
+			continue;
+		}
+
+		// Protect runs of dirty pages with a single call.
+		//
+		// The pages are only marked clean once protected. A write after the
+		// protection faults and marks its page dirty again, which the exchange
+		// below then leaves alone; a write before it is simply forgotten.
+		std::size_t run_end = i;
+		while (run_end < end &&
+			region->page_states[run_end].load(std::memory_order_acquire) == page_dirty)
+		{
+			region->page_states[run_end].store(page_cleaning, std::memory_order_release);
+			++run_end;
+		}
+
+		if (mprotect((char*)base + i * page_size, (run_end - i) * page_size, PROT_READ) != 0)
+		{
+			push_exception(exception::platform, errno);
+
+			for (std::size_t j = i; j < run_end; ++j)
+			{
+				region->page_states[j].store(page_dirty, std::memory_order_release);
+			}
+
+			return false;
+		}
+
+		for (std::size_t j = i; j < run_end; ++j)
+		{
+			std::uint8_t state = page_cleaning;
+			region->page_states[j].compare_exchange_strong(state, page_clean, std::memory_order_acq_rel);
+		}
+
+		i = run_end;
+	}
+
+	return true;
+}
+
+bool holo::memory_region_base::is_page_dirty(void* base, std::size_t index) const
+{
+	tracked_region* region = find_tracked_region(base);
+	holo_assert(region != nullptr);
+
+	return region->page_states[index].load(std::memory_order_acquire) == page_dirty;
+}
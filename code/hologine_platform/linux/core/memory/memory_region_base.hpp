@@ -0,0 +1,144 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#ifndef HOLOGINE_CORE_MEMORY_MEMORY_REGION_BASE_HPP_
+#define HOLOGINE_CORE_MEMORY_MEMORY_REGION_BASE_HPP_
+
+#include <cstddef>
+#include "core/memory/allocator.hpp"
+#include "core/memory/memory_region_interface.hpp"
+
+namespace holo
+{
+	// Linux implementation of a memory region, using mmap & co.
+	//
+	// Pages are reserved as an inaccessible (PROT_NONE) anonymous mapping,
+	// committed by making them readable and writable, and decommitted by
+	// discarding their contents and making them inaccessible again.
+	//
+	// A file-backed region maps the file with PROT_NONE to reserve it, and
+	// commits pages by mapping the file again over the range, read-only and
+	// shared, or writable and private. Decommitting maps the range back to
+	// PROT_NONE, dropping any private copies.
+	//
+	// A shared memory object is opened with shm_open and mapped like a file,
+	// except that committed pages are always shared, so writes reach every
+	// process mapping the object.
+	//
+	// A mirrored region is backed by an anonymous memfd, which is mapped twice
+	// and shared, back to back, in a single reservation.
+	//
+	// Writes to tracked pages are caught by write protecting clean pages. A
+	// process-wide SIGSEGV handler marks the faulting page dirty and makes it
+	// writable again; faults outside of clean tracked pages are passed on to
+	// the previously installed handler.
+	class memory_region_base : protected memory_region_interface
+	{
+		memory_region_base(const memory_region_base&) = delete;
+		memory_region_base& operator =(const memory_region_base&) = delete;
+
+		protected:
+			// Constructs a region base without a file.
+			memory_region_base();
+
+			// Move constructor; the file, if any, is moved too.
+			memory_region_base(memory_region_base&& other);
+
+			// Move assignment operator; the file, if any, is moved too.
+			memory_region_base& operator =(memory_region_base&& other);
+
+			// Closes the file, if any.
+			~memory_region_base();
+
+			// Implementation.
+			bool open_file(const char* path, bool writable, bool populate, std::size_t* size) override;
+
+			// Implementation.
+			bool open_shared_memory(const char* name, bool create, bool writable, std::size_t* size) override;
+
+			// Implementation.
+			bool is_file_open() const override;
+
+			// Implementation.
+			void* reserve_pages(std::size_t max_pages) override;
+			
+			// Implementation.
+			void* reserve_mirrored_pages(std::size_t max_pages) override;
+
+			// Implementation.
+			void release_pages(void* base, std::size_t index, std::size_t count) override;
+			
+			// Implementation.
+			bool commit_pages(void* base, std::size_t index, std::size_t count) override;
+			
+			// Implementation.
+			void decommit_pages(void* base, std::size_t index, std::size_t count) override;
+
+			// Implementation.
+			void advise_huge_pages(void* base, std::size_t index, std::size_t count) override;
+
+			// Implementation.
+			void advise_will_need(void* base, std::size_t index, std::size_t count) override;
+
+			// Implementation.
+			bool begin_tracking_pages(void* base, std::size_t max_pages) override;
+
+			// Implementation.
+			void end_tracking_pages(void* base) override;
+
+			// Implementation.
+			void mark_pages_dirty(void* base, std::size_t index, std::size_t count) override;
+
+			// Implementation.
+			void mark_pages_untracked(void* base, std::size_t index, std::size_t count) override;
+
+			// Implementation.
+			bool clear_dirty_pages(void* base, std::size_t index, std::size_t count) override;
+
+			// Implementation.
+			bool is_page_dirty(void* base, std::size_t index) const override;
+
+		public:
+			// Implementation.
+			static std::size_t get_page_size();
+
+			// Implementation.
+			static std::size_t get_granularity();
+
+			// Implementation.
+			static std::size_t get_huge_page_size();
+
+			// Implementation.
+			static bool remove_shared_memory(const char* name);
+
+		private:
+			// Maps 'count' pages of the file at 'index' over the same range of the
+			// region, with the provided protection and extra mmap flags.
+			bool map_file_pages(void* base, std::size_t index, std::size_t count, int protection, int flags);
+
+			// The file backing the region, or -1 if the region is anonymous.
+			int file_descriptor;
+
+			// Whether committed file pages are writable.
+			bool is_file_writable;
+
+			// Whether committing file pages should read them in.
+			bool is_file_populated;
+
+			// Whether the file is a shared memory object, whose pages are mapped
+			// shared even when writable.
+			bool is_file_shared;
+
+			// Size of each view of a mirrored region, or zero if the region is not
+			// mirrored. The file descriptor is then the memfd backing both views.
+			std::size_t mirror_size;
+	};
+}
+
+#endif
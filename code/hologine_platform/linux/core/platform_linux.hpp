@@ -0,0 +1,26 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#ifndef HOLOGINE_CORE_PLATFORM_LINUX_HPP_
+#define HOLOGINE_CORE_PLATFORM_LINUX_HPP_
+
+// Request the full set of POSIX and Linux extensions (MAP_ANONYMOUS,
+// MADV_DONTNEED, and so on) before any system header is included.
+#ifndef _GNU_SOURCE
+	#define _GNU_SOURCE
+#endif
+
+#include <cerrno>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#endif
@@ -0,0 +1,46 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include "core/exception.hpp"
+#include "core/threading/scoped_lock.hpp"
+#include "core/threading/condition_variable_base.hpp"
+
+bool holo::condition_variable_base::create_condition_variable()
+{
+	int result = pthread_cond_init(&pthread_condition_variable, nullptr);
+
+	if (result != 0)
+	{
+		push_exception(exception::platform, result);
+
+		return false;
+	}
+
+	return true;
+}
+
+void holo::condition_variable_base::destroy_condition_variable()
+{
+	pthread_cond_destroy(&pthread_condition_variable);
+}
+
+void holo::condition_variable_base::wait(holo::scoped_lock& lock)
+{
+	pthread_cond_wait(&pthread_condition_variable, &lock.mutex.pthread_mutex);
+}
+
+void holo::condition_variable_base::notify_one()
+{
+	pthread_cond_signal(&pthread_condition_variable);
+}
+
+void holo::condition_variable_base::notify_all()
+{
+	pthread_cond_broadcast(&pthread_condition_variable);
+}
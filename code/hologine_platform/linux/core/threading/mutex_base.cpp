@@ -0,0 +1,40 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include "core/exception.hpp"
+#include "core/threading/mutex_base.hpp"
+
+bool holo::mutex_base::create_mutex()
+{
+	int result = pthread_mutex_init(&pthread_mutex, nullptr);
+
+	if (result != 0)
+	{
+		push_exception(exception::platform, result);
+
+		return false;
+	}
+
+	return true;
+}
+
+void holo::mutex_base::destroy_mutex()
+{
+	pthread_mutex_destroy(&pthread_mutex);
+}
+
+void holo::mutex_base::lock()
+{
+	pthread_mutex_lock(&pthread_mutex);
+}
+
+void holo::mutex_base::unlock()
+{
+	pthread_mutex_unlock(&pthread_mutex);
+}
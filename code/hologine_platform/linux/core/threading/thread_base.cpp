@@ -0,0 +1,70 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include "core/exception.hpp"
+#include "core/platform_linux.hpp"
+#include "core/threading/thread.hpp"
+
+bool holo::thread_base::create_thread(thread_argument* argument)
+{
+	thread_parameter = argument;
+	
+	return true;
+}
+
+bool holo::thread_base::run_thread()
+{
+	int result = pthread_create(&thread_handle, nullptr, &posix_thread_proc, thread_parameter);
+	
+	if (result != 0)
+	{
+		push_exception(exception::platform, result);
+		
+		return false;
+	}
+	
+	return true;
+}
+
+bool holo::thread_base::join_thread()
+{
+	int result = pthread_join(thread_handle, nullptr);
+	
+	if (result != 0)
+	{
+		push_exception(exception::platform, result);
+
+		return false;
+	}
+	
+	return true;
+}
+
+void* holo::thread_base::posix_thread_proc(void* parameter)
+{
+	thread_argument* argument = (thread_argument*)parameter;
+	bool exceptions_enabled = false;
+	
+	if ((argument->flags & flag_enable_exceptions) && argument->allocator != nullptr)
+	{
+		// If the exception handler fails to be created, then don't bother disabling
+		// exceptions; the exception handler will be in a clean state on failure.
+		exceptions_enabled = enable_exceptions(argument->allocator, nullptr);
+	}
+	
+	argument->return_status = argument->callback(argument->userdata);
+	
+	// Only disable exceptions if they were enabled.
+	if (exceptions_enabled)
+	{
+		disable_exceptions();
+	}
+	
+	return nullptr;
+}
@@ -0,0 +1,46 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#ifndef HOLOGINE_CORE_THREADING_THREAD_BASE_HPP_
+#define HOLOGINE_CORE_THREADING_THREAD_BASE_HPP_
+
+#include "core/platform_linux.hpp"
+#include "core/threading/thread_interface.hpp"
+
+namespace holo
+{
+	// Linux implementation of a thread, using pthreads.
+	//
+	// pthreads cannot create a suspended thread. Instead, the argument is
+	// stored when the thread is created and the thread is spawned when it is
+	// run.
+	class thread_base : public thread_interface
+	{
+		public:
+			// Implementation.
+			bool create_thread(thread_argument* argument) override;
+			
+			// Implementation.
+			bool run_thread() override;
+			
+			// Implementation.
+			bool join_thread() override;
+			
+		private:
+			// The platform-specific thread callback.
+			static void* posix_thread_proc(void* parameter);
+			
+			// The argument to pass to the thread once it is run.
+			thread_argument* thread_parameter;
+
+			pthread_t thread_handle;
+	};
+}
+
+#endif
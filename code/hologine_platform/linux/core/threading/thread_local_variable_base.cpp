@@ -0,0 +1,64 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include "core/platform_linux.hpp"
+#include "core/threading/thread_local_variable_base.hpp"
+
+holo::thread_local_variable_base::thread_local_variable_base()
+{
+	// Values are owned by the user of the variable, so there is no destructor.
+	int result = pthread_key_create(&key, nullptr);
+	
+	if (result != 0)
+	{
+		initialized = false;
+		exception = result;
+	}
+	else
+	{
+		initialized = true;
+		exception = 0;
+	}
+}
+
+holo::thread_local_variable_base::~thread_local_variable_base()
+{
+	if (initialized)
+	{
+		pthread_key_delete(key);
+	}
+}
+
+void* holo::thread_local_variable_base::get() const
+{
+	if (initialized)
+	{
+		return pthread_getspecific(key);
+	}
+	
+	return nullptr;
+}
+
+void holo::thread_local_variable_base::set(void* value) const
+{
+	if (initialized)
+	{
+		pthread_setspecific(key, value);
+	}
+}
+
+bool holo::thread_local_variable_base::is_valid() const
+{
+	return initialized;
+}
+
+holo::platform_exception_code holo::thread_local_variable_base::get_platform_exception_code() const
+{
+	return exception;
+}
@@ -11,6 +11,25 @@
 #include "core/platform_windows.hpp"
 #include "core/memory/memory_region_base.hpp"
 
+bool holo::memory_region_base::open_file(const char*, bool, bool, std::size_t*)
+{
+	push_exception(exception::unsupported);
+
+	return false;
+}
+
+bool holo::memory_region_base::open_shared_memory(const char*, bool, bool, std::size_t*)
+{
+	push_exception(exception::unsupported);
+
+	return false;
+}
+
+bool holo::memory_region_base::is_file_open() const
+{
+	return false;
+}
+
 void* holo::memory_region_base::reserve_pages(std::size_t max_pages)
 {
 	void* memory = VirtualAlloc(nullptr, max_pages * get_page_size(), MEM_RESERVE, PAGE_NOACCESS);
@@ -23,6 +42,13 @@ void* holo::memory_region_base::reserve_pages(std::size_t max_pages)
 	return memory;
 }
 
+void* holo::memory_region_base::reserve_mirrored_pages(std::size_t)
+{
+	push_exception(exception::unsupported);
+
+	return nullptr;
+}
+
 void holo::memory_region_base::release_pages(void* base, std::size_t index, std::size_t count)
 {
 	if (!VirtualFree(
@@ -61,6 +87,60 @@ void holo::memory_region_base::decommit_pages(void* base, std::size_t index, std
 	}
 }
 
+void holo::memory_region_base::advise_huge_pages(void*, std::size_t, std::size_t)
+{
+	// Nothing.
+	//
+	// Large pages on Windows must be requested with MEM_LARGE_PAGES when the
+	// region is reserved *and* committed in one call, and require the
+	// SeLockMemoryPrivilege. That does not fit a region that commits lazily,
+	// so the hint is ignored.
+}
+
+void holo::memory_region_base::advise_will_need(void*, std::size_t, std::size_t)
+{
+	// Nothing.
+	//
+	// PrefetchVirtualMemory is only available from Windows 8 onwards, and the
+	// hint matters most for file-backed pages, which aren't supported.
+}
+
+bool holo::memory_region_base::begin_tracking_pages(void*, std::size_t)
+{
+	push_exception(exception::unsupported);
+
+	return false;
+}
+
+void holo::memory_region_base::end_tracking_pages(void*)
+{
+	// Nothing.
+	//
+	// Tracking never begins, so there is nothing to end.
+}
+
+void holo::memory_region_base::mark_pages_dirty(void*, std::size_t, std::size_t)
+{
+	// Nothing.
+}
+
+void holo::memory_region_base::mark_pages_untracked(void*, std::size_t, std::size_t)
+{
+	// Nothing.
+}
+
+bool holo::memory_region_base::clear_dirty_pages(void*, std::size_t, std::size_t)
+{
+	push_exception(exception::unsupported);
+
+	return false;
+}
+
+bool holo::memory_region_base::is_page_dirty(void*, std::size_t) const
+{
+	return false;
+}
+
 std::size_t holo::memory_region_base::get_page_size()
 {
 	// On Windows (32-bit and 64-bit, x86), the page size is a constant number:
@@ -76,3 +156,24 @@ std::size_t holo::memory_region_base::get_granularity()
 	// must be on 64kb boundaries.
 	return 0x10000u;
 }
+
+std::size_t holo::memory_region_base::get_huge_page_size()
+{
+	// GetLargePageMinimum returns 0 if large pages are unsupported; assume the
+	// x86 2mb large page in such a case so callers can still align on it.
+	std::size_t large_page_size = GetLargePageMinimum();
+
+	if (large_page_size == 0)
+	{
+		return 0x200000u;
+	}
+
+	return large_page_size;
+}
+
+bool holo::memory_region_base::remove_shared_memory(const char*)
+{
+	push_exception(exception::unsupported);
+
+	return false;
+}
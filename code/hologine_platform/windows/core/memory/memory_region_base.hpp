@@ -17,11 +17,40 @@
 namespace holo
 {
 	// Windows implementation of a memory region, using VirtualAlloc & co.
+	//
+	// File-backed regions are not supported: views of a file mapping can't be
+	// mapped into pages reserved by VirtualAlloc, so opening a file pushes
+	// holo::exception::unsupported.
+	//
+	// Shared memory objects are not supported either, for the same reason, so
+	// opening one pushes holo::exception::unsupported.
+	//
+	// Mirrored regions are not supported: placing two views back to back
+	// needs placeholders (VirtualAlloc2 and MapViewOfFile3), which are only
+	// available from Windows 10 onwards, so reserving mirrored pages pushes
+	// holo::exception::unsupported.
+	//
+	// Dirty page tracking is not supported: write watches (MEM_WRITE_WATCH)
+	// must be requested when the pages are reserved, before the region starts
+	// tracking them, so beginning to track pages pushes
+	// holo::exception::unsupported.
 	class memory_region_base : protected memory_region_interface
 	{
 		protected:
+			// Implementation.
+			bool open_file(const char* path, bool writable, bool populate, std::size_t* size) override;
+
+			// Implementation.
+			bool open_shared_memory(const char* name, bool create, bool writable, std::size_t* size) override;
+
+			// Implementation.
+			bool is_file_open() const override;
+
 			// Implementation.
 			void* reserve_pages(std::size_t max_pages) override;
+
+			// Implementation.
+			void* reserve_mirrored_pages(std::size_t max_pages) override;
 			
 			// Implementation.
 			void release_pages(void* base, std::size_t index, std::size_t count) override;
@@ -32,12 +61,42 @@ namespace holo
 			// Implementation.
 			void decommit_pages(void* base, std::size_t index, std::size_t count) override;
 
+			// Implementation.
+			void advise_huge_pages(void* base, std::size_t index, std::size_t count) override;
+
+			// Implementation.
+			void advise_will_need(void* base, std::size_t index, std::size_t count) override;
+
+			// Implementation.
+			bool begin_tracking_pages(void* base, std::size_t max_pages) override;
+
+			// Implementation.
+			void end_tracking_pages(void* base) override;
+
+			// Implementation.
+			void mark_pages_dirty(void* base, std::size_t index, std::size_t count) override;
+
+			// Implementation.
+			void mark_pages_untracked(void* base, std::size_t index, std::size_t count) override;
+
+			// Implementation.
+			bool clear_dirty_pages(void* base, std::size_t index, std::size_t count) override;
+
+			// Implementation.
+			bool is_page_dirty(void* base, std::size_t index) const override;
+
 		public:
 			// Implementation.
 			static std::size_t get_page_size();
 
 			// Implementation.
 			static std::size_t get_granularity();
+
+			// Implementation.
+			static std::size_t get_huge_page_size();
+
+			// Implementation.
+			static bool remove_shared_memory(const char* name);
 	};
 }
 
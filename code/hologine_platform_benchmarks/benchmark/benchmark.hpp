@@ -0,0 +1,75 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#ifndef HOLOGINE_PLATFORM_BENCHMARK_BENCHMARK_HPP_
+#define HOLOGINE_PLATFORM_BENCHMARK_BENCHMARK_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace benchmark
+{
+	// Signature of a benchmark.
+	//
+	// Benchmarks print their own results; there's little in common between a
+	// throughput and a latency measurement.
+	typedef void (* benchmark_callback)();
+
+	// A registered benchmark.
+	//
+	// Benchmarks are registered at startup by HOLOGINE_BENCHMARK and run in
+	// order of registration by the benchmark driver.
+	struct registration
+	{
+		// Registers the benchmark.
+		registration(const char* name, benchmark_callback callback);
+
+		// Name of the benchmark.
+		const char* name;
+
+		// The benchmark itself.
+		benchmark_callback callback;
+
+		// Next registered benchmark.
+		registration* next;
+	};
+
+	// Gets the first registered benchmark.
+	registration* get_first_registration();
+
+	// Measures elapsed wall time.
+	class stopwatch
+	{
+		public:
+			// Creates and starts the stopwatch.
+			stopwatch();
+
+			// Restarts the stopwatch.
+			void reset();
+
+			// Gets the time elapsed since the stopwatch was started, in seconds.
+			double get_elapsed_seconds() const;
+
+			// Gets the time elapsed since the stopwatch was started, in
+			// nanoseconds.
+			std::uint64_t get_elapsed_nanoseconds() const;
+
+		private:
+			std::chrono::steady_clock::time_point start;
+	};
+}
+
+// Defines and registers a benchmark named 'name'.
+#define HOLOGINE_BENCHMARK(name) \
+	static void name(); \
+	static benchmark::registration name##_registration(#name, &name); \
+	static void name()
+
+#endif
@@ -0,0 +1,458 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+#include "benchmark/benchmark.hpp"
+#include "core/io/memory_stream.hpp"
+#include "core/memory/allocation_trace.hpp"
+#include "core/memory/heap_allocator.hpp"
+#include "core/memory/memory_region.hpp"
+#include "core/memory/tlsf_allocator.hpp"
+#include "core/memory/tracing_allocator_proxy.hpp"
+
+namespace config
+{
+	// Environment variable holding the path of a trace to replay.
+	//
+	// Traces are written by holo::tracing_allocator_proxy. Without one, a
+	// synthetic trace is recorded first.
+	const static char* trace_path_variable = "HOLOGINE_ALLOCATION_TRACE";
+
+	// Number of operations in the synthetic trace.
+	const static std::size_t synthetic_operation_count = 0x80000u;
+
+	// Number of objects the synthetic workload keeps alive at once.
+	const static std::size_t synthetic_live_object_count = 0x2000u;
+
+	// Size of the buffer the synthetic trace is recorded to.
+	const static std::size_t synthetic_trace_size = 0x2000000u;
+
+	// Size of the TLSF allocator's region; it is committed lazily.
+	const static std::size_t tlsf_allocator_size = 0x40000000u;
+
+	// Parameters of the heap allocators to compare; see
+	// holo::heap_allocator::heap_allocator().
+	struct heap_parameters
+	{
+		std::size_t arena_size;
+		std::size_t arena_count;
+		std::size_t pool_start;
+		std::size_t pool_end;
+	};
+
+	const static heap_parameters heap_variants[] =
+	{
+		{ 0x40000u, 0x100u, 0x20u, 0x10000u },
+		{ 0x100000u, 0x100u, 0x20u, 0x4000u }
+	};
+}
+
+namespace
+{
+	// Marks a replayed allocation that failed when traced, or a deallocation of
+	// a pointer the trace never saw allocated.
+	const std::size_t no_slot = (std::size_t)-1;
+
+	// A trace event, resolved for replay.
+	//
+	// Addresses in the trace are only meaningful within the trace, so each
+	// live allocation is given a slot instead; slots are reused once freed.
+	struct replay_operation
+	{
+		int kind;
+		std::size_t slot;
+		std::size_t size;
+		std::size_t alignment;
+	};
+
+	// The operations of a trace, ready for replay.
+	struct replay_trace
+	{
+		std::vector<replay_operation> operations;
+
+		// Number of slots used by the operations.
+		std::size_t slot_count;
+
+		// The largest number of bytes requested by live allocations at once.
+		std::size_t peak_live_bytes;
+
+		// Number of threads in the trace.
+		std::size_t thread_count;
+	};
+
+	// Records a synthetic workload: a working set of objects of mostly small
+	// sizes, with the occasional large one, replaced at random.
+	std::size_t record_synthetic_trace(std::uint8_t* buffer, std::size_t size)
+	{
+		holo::heap_allocator heap_allocator;
+		holo::memory_stream stream(buffer, size, false, true);
+		holo::tracing_allocator_proxy proxy(&heap_allocator, &stream);
+
+		std::uint32_t state = 0x9e3779b9u;
+		auto next_random = [&state]()
+		{
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+
+			return state;
+		};
+
+		auto next_size = [&next_random]() -> std::size_t
+		{
+			std::uint32_t roll = next_random() % 100;
+			if (roll < 80)
+			{
+				return 8 + next_random() % 0x100u;
+			}
+			else if (roll < 98)
+			{
+				return 0x100u + next_random() % 0x2000u;
+			}
+
+			return 0x2000u + next_random() % 0x40000u;
+		};
+
+		std::vector<void*> objects(config::synthetic_live_object_count);
+		for (void*& object : objects)
+		{
+			object = proxy.allocate(next_size());
+		}
+
+		for (std::size_t i = 0; i < config::synthetic_operation_count; ++i)
+		{
+			void*& object = objects[next_random() % objects.size()];
+
+			proxy.deallocate(object);
+			object = proxy.allocate(next_size());
+		}
+
+		for (void* object : objects)
+		{
+			proxy.deallocate(object);
+		}
+
+		proxy.flush();
+
+		return (std::size_t)stream.get_position();
+	}
+
+	// Decodes a trace and assigns slots to its allocations.
+	//
+	// Returns false if the trace is invalid, truncated or otherwise corrupt.
+	bool prepare_trace(std::uint8_t* data, std::size_t size, replay_trace* trace)
+	{
+		holo::memory_stream stream(data, size, true, false);
+		holo::allocation_trace_reader reader(&stream);
+		if (!reader.is_valid())
+		{
+			return false;
+		}
+
+		std::unordered_map<std::uint64_t, std::size_t> live_slots;
+		std::vector<std::size_t> live_sizes;
+		std::vector<std::size_t> free_slots;
+		std::size_t live_bytes = 0;
+
+		trace->operations.clear();
+		trace->slot_count = 0;
+		trace->peak_live_bytes = 0;
+		trace->thread_count = 0;
+
+		holo::allocation_event event;
+		while (reader.read(&event))
+		{
+			replay_operation operation;
+			operation.kind = event.kind;
+			operation.size = event.size;
+			operation.alignment = event.alignment;
+			operation.slot = no_slot;
+
+			if (event.thread >= trace->thread_count)
+			{
+				trace->thread_count = event.thread + 1;
+			}
+
+			if (event.kind == holo::allocation_event::kind_allocate)
+			{
+				if (event.address != 0)
+				{
+					if (free_slots.empty())
+					{
+						operation.slot = trace->slot_count++;
+						live_sizes.push_back(0);
+					}
+					else
+					{
+						operation.slot = free_slots.back();
+						free_slots.pop_back();
+					}
+
+					live_slots[event.address] = operation.slot;
+					live_sizes[operation.slot] = event.size;
+					live_bytes += event.size;
+
+					if (live_bytes > trace->peak_live_bytes)
+					{
+						trace->peak_live_bytes = live_bytes;
+					}
+				}
+			}
+			else
+			{
+				auto live_slot = live_slots.find(event.address);
+				if (live_slot != live_slots.end())
+				{
+					operation.slot = live_slot->second;
+					live_slots.erase(live_slot);
+
+					live_bytes -= live_sizes[operation.slot];
+					free_slots.push_back(operation.slot);
+				}
+			}
+
+			trace->operations.push_back(operation);
+		}
+
+		// Replaying part of a trace would skew every figure.
+		return !reader.is_corrupt();
+	}
+
+	// Reads a field of /proc/self/status, in kilobytes, or returns zero if the
+	// field is not available.
+	std::size_t read_memory_status(const char* field)
+	{
+		std::FILE* file = std::fopen("/proc/self/status", "r");
+		if (file == nullptr)
+		{
+			return 0;
+		}
+
+		std::size_t field_length = std::strlen(field);
+		unsigned long long value = 0;
+		char line[256];
+
+		while (std::fgets(line, sizeof(line), file) != nullptr)
+		{
+			if (std::strncmp(line, field, field_length) == 0 && line[field_length] == ':')
+			{
+				value = std::strtoull(line + field_length + 1, nullptr, 10);
+				break;
+			}
+		}
+
+		std::fclose(file);
+
+		return (std::size_t)value;
+	}
+
+	// Resets the peak resident set size to the current one.
+	//
+	// Returns false if the platform doesn't support it.
+	bool reset_peak_resident_size()
+	{
+		std::FILE* file = std::fopen("/proc/self/clear_refs", "w");
+		if (file == nullptr)
+		{
+			return false;
+		}
+
+		bool success = std::fputs("5", file) >= 0;
+		success = std::fclose(file) == 0 && success;
+
+		return success;
+	}
+
+	// Writes a byte to every page spanned by an allocation, like the traced
+	// program presumably did, so that the pages count towards the resident set.
+	void touch_pages(void* pointer, std::size_t size, std::size_t page_size)
+	{
+		char* begin = (char*)pointer;
+		for (std::size_t offset = 0; offset < size; offset += page_size)
+		{
+			begin[offset] = 1;
+		}
+
+		if (size > 0)
+		{
+			begin[size - 1] = 1;
+		}
+	}
+
+	// Replays 'trace' against 'allocator' on the calling thread and prints the
+	// throughput, the peak resident set growth, and the fragmentation (the
+	// portion of that growth not taken by live requested bytes).
+	//
+	// Events are replayed in the order they were traced, regardless of the
+	// thread that made them.
+	void replay(const replay_trace& trace, holo::allocator* allocator, const char* name)
+	{
+		std::vector<void*> slots(trace.slot_count, nullptr);
+		std::size_t page_size = holo::memory_region::get_page_size();
+
+		bool is_peak_reset = reset_peak_resident_size();
+		std::size_t base_resident_size = read_memory_status("VmRSS");
+
+		benchmark::stopwatch stopwatch;
+		for (const replay_operation& operation : trace.operations)
+		{
+			switch (operation.kind)
+			{
+				case holo::allocation_event::kind_allocate:
+					{
+						void* pointer = allocator->allocate(operation.size, operation.alignment);
+
+						if (operation.slot != no_slot)
+						{
+							slots[operation.slot] = pointer;
+
+							if (pointer != nullptr)
+							{
+								touch_pages(pointer, operation.size, page_size);
+							}
+						}
+						else if (pointer != nullptr)
+						{
+							// The allocation failed when traced, so it's never freed.
+							allocator->deallocate(pointer);
+						}
+					}
+					break;
+
+				case holo::allocation_event::kind_deallocate:
+					if (operation.slot != no_slot)
+					{
+						allocator->deallocate(slots[operation.slot]);
+					}
+					break;
+
+				case holo::allocation_event::kind_sized_deallocate:
+					if (operation.slot != no_slot)
+					{
+						allocator->deallocate(slots[operation.slot], operation.size, operation.alignment);
+					}
+					break;
+			}
+		}
+		double elapsed = stopwatch.get_elapsed_seconds();
+
+		std::size_t peak_resident_size = read_memory_status("VmHWM");
+		std::size_t resident_growth = 0;
+		if (is_peak_reset && peak_resident_size > base_resident_size)
+		{
+			resident_growth = (peak_resident_size - base_resident_size) * 1024;
+		}
+
+		double fragmentation = 0.0;
+		if (resident_growth > trace.peak_live_bytes)
+		{
+			fragmentation = 1.0 - (double)trace.peak_live_bytes / resident_growth;
+		}
+
+		std::printf(
+			"  %-28s %12.2f %10.1f %14llu %13.1f%%\n",
+			name,
+			trace.operations.size() / elapsed / 1000000.0,
+			elapsed * 1000000000.0 / trace.operations.size(),
+			(unsigned long long)(resident_growth / 1024),
+			fragmentation * 100.0);
+
+		// Anything still live when the trace ended was leaked by the traced
+		// program; clean it up anyway, since the allocator may be reused.
+		std::vector<bool> is_live(trace.slot_count, false);
+		for (const replay_operation& operation : trace.operations)
+		{
+			if (operation.slot != no_slot)
+			{
+				is_live[operation.slot] = operation.kind == holo::allocation_event::kind_allocate;
+			}
+		}
+
+		for (std::size_t i = 0; i < trace.slot_count; ++i)
+		{
+			if (is_live[i] && slots[i] != nullptr)
+			{
+				allocator->deallocate(slots[i]);
+			}
+		}
+	}
+}
+
+HOLOGINE_BENCHMARK(allocation_trace_replay)
+{
+	replay_trace trace;
+
+	const char* trace_path = std::getenv(config::trace_path_variable);
+	if (trace_path != nullptr)
+	{
+		holo::memory_region trace_region(trace_path, holo::memory_region::flag_populate_pages);
+		std::uint8_t* data = (std::uint8_t*)trace_region.claim();
+
+		if (data == nullptr || !prepare_trace(data, trace_region.get_file_size(), &trace))
+		{
+			std::printf("  could not read trace '%s'\n", trace_path);
+
+			return;
+		}
+
+		std::printf("  trace: %s\n", trace_path);
+	}
+	else
+	{
+		std::vector<std::uint8_t> buffer(config::synthetic_trace_size);
+		std::size_t size = record_synthetic_trace(buffer.data(), buffer.size());
+
+		if (!prepare_trace(buffer.data(), size, &trace))
+		{
+			std::printf("  could not read synthetic trace\n");
+
+			return;
+		}
+
+		std::printf("  trace: synthetic (set %s to replay a recorded trace)\n", config::trace_path_variable);
+	}
+
+	std::printf(
+		"  %llu operations, %llu threads, %llu kb peak live\n",
+		(unsigned long long)trace.operations.size(),
+		(unsigned long long)trace.thread_count,
+		(unsigned long long)(trace.peak_live_bytes / 1024));
+	std::printf("  %-28s %12s %10s %14s %14s\n", "", "Mops/s", "ns/op", "peak rss (kb)", "fragmentation");
+
+	for (const config::heap_parameters& parameters : config::heap_variants)
+	{
+		char name[64];
+		std::snprintf(
+			name, sizeof(name),
+			"heap %zx/%zx/%zx-%zx",
+			parameters.arena_size,
+			parameters.arena_count,
+			parameters.pool_start,
+			parameters.pool_end);
+
+		holo::heap_allocator heap_allocator(
+			parameters.arena_size,
+			parameters.arena_count,
+			parameters.pool_start,
+			parameters.pool_end);
+		replay(trace, &heap_allocator, name);
+	}
+
+	{
+		holo::tlsf_allocator tlsf_allocator(
+			config::tlsf_allocator_size,
+			holo::tlsf_allocator::flag_commit_lazily);
+		replay(trace, &tlsf_allocator, "tlsf");
+	}
+}
@@ -0,0 +1,147 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include "benchmark/benchmark.hpp"
+#include "core/memory/blocking_allocator_proxy.hpp"
+#include "core/memory/caching_allocator_proxy.hpp"
+#include "core/memory/heap_allocator.hpp"
+#include "core/threading/thread.hpp"
+
+namespace config
+{
+	// Number of objects each thread keeps alive per round.
+	const static std::size_t objects_per_round = 256;
+
+	// Number of rounds each thread performs.
+	const static std::size_t round_count = 2000;
+
+	// Largest allocation made, in bytes.
+	const static std::size_t maximum_object_size = 512;
+
+	// Thread counts to measure.
+	const static std::size_t thread_counts[] = { 1, 2, 4, 8 };
+}
+
+namespace
+{
+	// State shared by the worker threads of a single run.
+	struct contention_run
+	{
+		holo::allocator* allocator;
+
+		// Set when the workers should begin, so thread creation isn't timed.
+		std::atomic<bool> go;
+
+		// Whether to release the worker's thread cache on exit.
+		holo::caching_allocator_proxy* caching_allocator;
+	};
+
+	holo::thread_return_status contention_worker(void* userdata)
+	{
+		contention_run* run = (contention_run*)userdata;
+		void* objects[config::objects_per_round];
+
+		// Cheap deterministic sizes; xorshift is plenty.
+		std::uint32_t state = 0x9e3779b9u;
+
+		while (!run->go.load(std::memory_order_acquire))
+		{
+			// Spin.
+		}
+
+		for (std::size_t round = 0; round < config::round_count; ++round)
+		{
+			for (std::size_t i = 0; i < config::objects_per_round; ++i)
+			{
+				state ^= state << 13;
+				state ^= state >> 17;
+				state ^= state << 5;
+
+				std::size_t size = 16 + state % (config::maximum_object_size - 16);
+				objects[i] = run->allocator->allocate(size);
+
+				// Touch the memory, like a real caller would.
+				*(char*)objects[i] = (char)i;
+			}
+
+			for (std::size_t i = 0; i < config::objects_per_round; ++i)
+			{
+				run->allocator->deallocate(objects[config::objects_per_round - i - 1]);
+			}
+		}
+
+		if (run->caching_allocator != nullptr)
+		{
+			run->caching_allocator->release_thread_cache();
+		}
+
+		return holo::thread_return_status_ok;
+	}
+
+	// Runs the workload on 'thread_count' threads and returns the throughput, in
+	// millions of operations per second.
+	double measure_contention(
+		holo::allocator* allocator,
+		holo::caching_allocator_proxy* caching_allocator,
+		std::size_t thread_count)
+	{
+		contention_run run;
+		run.allocator = allocator;
+		run.caching_allocator = caching_allocator;
+		run.go.store(false);
+
+		holo::thread threads[8];
+		for (std::size_t i = 0; i < thread_count; ++i)
+		{
+			threads[i].start(&contention_worker, &run);
+		}
+
+		benchmark::stopwatch stopwatch;
+		run.go.store(true, std::memory_order_release);
+
+		for (std::size_t i = 0; i < thread_count; ++i)
+		{
+			threads[i].join();
+		}
+
+		double seconds = stopwatch.get_elapsed_seconds();
+		double operations = 2.0 * config::objects_per_round * config::round_count * thread_count;
+
+		return operations / seconds / 1000000.0;
+	}
+}
+
+HOLOGINE_BENCHMARK(caching_allocator_proxy_contention)
+{
+	std::printf("  %-8s %12s %12s\n", "threads", "mutex Mop/s", "cache Mop/s");
+
+	for (std::size_t thread_count : config::thread_counts)
+	{
+		double blocking_throughput;
+		{
+			holo::heap_allocator heap_allocator;
+			holo::blocking_allocator_proxy blocking_allocator(&heap_allocator);
+
+			blocking_throughput = measure_contention(&blocking_allocator, nullptr, thread_count);
+		}
+
+		double caching_throughput;
+		{
+			holo::heap_allocator heap_allocator;
+			holo::caching_allocator_proxy caching_allocator(&heap_allocator);
+
+			caching_throughput = measure_contention(&caching_allocator, &caching_allocator, thread_count);
+		}
+
+		std::printf("  %-8zu %12.2f %12.2f\n", thread_count, blocking_throughput, caching_throughput);
+	}
+}
@@ -0,0 +1,99 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include <cstdio>
+#include <cstring>
+#include "benchmark/benchmark.hpp"
+
+// Head and tail of the registered benchmarks. The list is built during static
+// initialization, hence the function-local statics.
+static benchmark::registration*& get_registration_head()
+{
+	static benchmark::registration* head = nullptr;
+
+	return head;
+}
+
+static benchmark::registration*& get_registration_tail()
+{
+	static benchmark::registration* tail = nullptr;
+
+	return tail;
+}
+
+benchmark::registration::registration(const char* name, benchmark_callback callback) :
+	name(name),
+	callback(callback),
+	next(nullptr)
+{
+	if (get_registration_tail() == nullptr)
+	{
+		get_registration_head() = this;
+	}
+	else
+	{
+		get_registration_tail()->next = this;
+	}
+
+	get_registration_tail() = this;
+}
+
+benchmark::registration* benchmark::get_first_registration()
+{
+	return get_registration_head();
+}
+
+benchmark::stopwatch::stopwatch() :
+	start(std::chrono::steady_clock::now())
+{
+	// Nothing.
+}
+
+void benchmark::stopwatch::reset()
+{
+	start = std::chrono::steady_clock::now();
+}
+
+double benchmark::stopwatch::get_elapsed_seconds() const
+{
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	return elapsed.count();
+}
+
+std::uint64_t benchmark::stopwatch::get_elapsed_nanoseconds() const
+{
+	return (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - start).count();
+}
+
+// Runs every benchmark, or only those whose name contains one of the
+// arguments.
+int main(int argc, char** argv)
+{
+	for (benchmark::registration* current = benchmark::get_first_registration();
+		current != nullptr;
+		current = current->next)
+	{
+		bool selected = argc < 2;
+		for (int i = 1; i < argc && !selected; ++i)
+		{
+			selected = std::strstr(current->name, argv[i]) != nullptr;
+		}
+
+		if (selected)
+		{
+			std::printf("%s\n", current->name);
+			current->callback();
+			std::printf("\n");
+		}
+	}
+
+	return 0;
+}
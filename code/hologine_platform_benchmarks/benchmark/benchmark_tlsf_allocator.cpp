@@ -0,0 +1,147 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include "benchmark/benchmark.hpp"
+#include "core/memory/heap_allocator.hpp"
+#include "core/memory/tlsf_allocator.hpp"
+
+namespace config
+{
+	// Number of objects kept alive at once.
+	const static std::size_t live_object_count = 0x1000u;
+
+	// Number of times an object is replaced with a new one.
+	const static std::size_t operation_count = 0x80000u;
+
+	// Size range of allocations, in bytes.
+	const static std::size_t minimum_object_size = 16;
+	const static std::size_t maximum_object_size = 0x2000u;
+
+	// Size of the TLSF allocator's region.
+	const static std::size_t tlsf_allocator_size = 0x4000000u;
+}
+
+namespace
+{
+	// Latencies of a single kind of operation, in nanoseconds.
+	struct latency_summary
+	{
+		double mean;
+		std::uint64_t median;
+		std::uint64_t percentile_999;
+		std::uint64_t maximum;
+	};
+
+	void summarize(std::vector<std::uint64_t>& latencies, latency_summary* summary)
+	{
+		std::sort(latencies.begin(), latencies.end());
+
+		double total = 0.0;
+		for (std::uint64_t latency : latencies)
+		{
+			total += latency;
+		}
+
+		summary->mean = total / latencies.size();
+		summary->median = latencies[latencies.size() / 2];
+		summary->percentile_999 = latencies[latencies.size() * 999 / 1000];
+		summary->maximum = latencies.back();
+	}
+
+	void print_summary(const char* name, const latency_summary& summary)
+	{
+		std::printf(
+			"  %-20s %10.1f %10llu %10llu %10llu\n",
+			name,
+			summary.mean,
+			(unsigned long long)summary.median,
+			(unsigned long long)summary.percentile_999,
+			(unsigned long long)summary.maximum);
+	}
+
+	// Keeps a working set of objects with random sizes alive, replacing a
+	// random object with a new one each step, and times every allocation and
+	// deallocation on its own.
+	void measure_latency(holo::allocator* allocator, const char* name)
+	{
+		std::vector<void*> objects(config::live_object_count);
+		std::vector<std::uint64_t> allocation_latencies;
+		std::vector<std::uint64_t> deallocation_latencies;
+		allocation_latencies.reserve(config::operation_count);
+		deallocation_latencies.reserve(config::operation_count);
+
+		// Cheap deterministic sizes; xorshift is plenty.
+		std::uint32_t state = 0x9e3779b9u;
+		auto next_random = [&state]()
+		{
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+
+			return state;
+		};
+
+		std::size_t size_range = config::maximum_object_size - config::minimum_object_size;
+		for (void*& object : objects)
+		{
+			object = allocator->allocate(config::minimum_object_size + next_random() % size_range);
+		}
+
+		for (std::size_t i = 0; i < config::operation_count; ++i)
+		{
+			void*& object = objects[next_random() % config::live_object_count];
+			std::size_t size = config::minimum_object_size + next_random() % size_range;
+
+			benchmark::stopwatch stopwatch;
+			allocator->deallocate(object);
+			deallocation_latencies.push_back(stopwatch.get_elapsed_nanoseconds());
+
+			stopwatch.reset();
+			object = allocator->allocate(size);
+			allocation_latencies.push_back(stopwatch.get_elapsed_nanoseconds());
+
+			// Touch the memory, like a real caller would.
+			*(char*)object = (char)i;
+		}
+
+		for (void* object : objects)
+		{
+			allocator->deallocate(object);
+		}
+
+		latency_summary allocation_summary;
+		summarize(allocation_latencies, &allocation_summary);
+
+		latency_summary deallocation_summary;
+		summarize(deallocation_latencies, &deallocation_summary);
+
+		std::printf("%s\n", name);
+		print_summary("allocate", allocation_summary);
+		print_summary("deallocate", deallocation_summary);
+	}
+}
+
+HOLOGINE_BENCHMARK(tlsf_allocator_latency)
+{
+	std::printf("  %-20s %10s %10s %10s %10s\n", "ns", "mean", "median", "99.9%", "max");
+
+	{
+		holo::heap_allocator heap_allocator;
+		measure_latency(&heap_allocator, "heap_allocator");
+	}
+
+	{
+		holo::tlsf_allocator tlsf_allocator(config::tlsf_allocator_size);
+		measure_latency(&tlsf_allocator, "tlsf_allocator");
+	}
+}
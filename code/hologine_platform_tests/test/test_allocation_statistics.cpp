@@ -0,0 +1,123 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include <boost/test/unit_test.hpp>
+#include "core/platform.hpp"
+#include "core/memory/allocation_statistics.hpp"
+#include "core/memory/fixed_allocator.hpp"
+#include "core/memory/linear_allocator.hpp"
+
+namespace config
+{
+	const static std::size_t statistics_region_size = 0x10000u;
+	const static std::size_t statistics_object_size = 0x30u;
+}
+
+struct allocation_statistics_test
+{
+	allocation_statistics_test();
+	~allocation_statistics_test();
+
+	holo::allocation_statistics statistics;
+};
+
+allocation_statistics_test::allocation_statistics_test()
+{
+	// Nothing.
+}
+
+allocation_statistics_test::~allocation_statistics_test()
+{
+	// Nothing.
+}
+
+BOOST_FIXTURE_TEST_SUITE(allocation_statistics_test_suite, allocation_statistics_test)
+
+BOOST_AUTO_TEST_CASE(counter)
+{
+	holo::allocation_counter counter;
+
+	// Nothing is recorded until enabled...
+	counter.record_allocation(10, 16);
+	counter.get_statistics(&statistics);
+	BOOST_REQUIRE(statistics.allocation_count == 0);
+
+	// ...except for memory usage.
+	counter.record_memory(0x1000u, 0x4000u);
+	counter.get_statistics(&statistics);
+	BOOST_REQUIRE(statistics.committed_bytes == 0x1000u);
+	BOOST_REQUIRE(statistics.reserved_bytes == 0x4000u);
+
+	counter.set_enabled(true);
+	counter.record_allocation(10, 16);
+	counter.record_allocation(30, 32);
+	counter.record_deallocation(16);
+
+	counter.get_statistics(&statistics);
+	BOOST_REQUIRE(statistics.live_objects == 1);
+	BOOST_REQUIRE(statistics.live_bytes == 32);
+	BOOST_REQUIRE(statistics.peak_objects == 2);
+	BOOST_REQUIRE(statistics.peak_bytes == 48);
+	BOOST_REQUIRE(statistics.allocation_count == 2);
+	BOOST_REQUIRE(statistics.deallocation_count == 1);
+	BOOST_REQUIRE(statistics.requested_bytes == 40);
+	BOOST_REQUIRE(statistics.allocated_bytes == 48);
+
+	// 8 out of 48 bytes were padding.
+	double fragmentation = holo::get_internal_fragmentation(statistics);
+	BOOST_REQUIRE(fragmentation > 0.166 && fragmentation < 0.167);
+
+	// Objects allocated before enabling statistics must not underflow.
+	counter.record_deallocation(64, 4);
+	counter.get_statistics(&statistics);
+	BOOST_REQUIRE(statistics.live_objects == 0);
+	BOOST_REQUIRE(statistics.live_bytes == 0);
+}
+
+BOOST_AUTO_TEST_CASE(linear_allocator)
+{
+	holo::linear_allocator allocator(config::statistics_region_size);
+	allocator.set_statistics_enabled(true);
+
+	BOOST_REQUIRE(allocator.allocate(1) != nullptr);
+	BOOST_REQUIRE(allocator.allocate(config::statistics_object_size) != nullptr);
+
+	// The second allocation was padded to the default alignment.
+	allocator.get_statistics(&statistics);
+	BOOST_REQUIRE(statistics.live_objects == 2);
+	BOOST_REQUIRE(statistics.live_bytes == holo::allocator::default_alignment + config::statistics_object_size);
+	BOOST_REQUIRE(statistics.requested_bytes == 1 + config::statistics_object_size);
+	BOOST_REQUIRE(statistics.committed_bytes == allocator.get_size());
+
+	allocator.reset();
+	allocator.get_statistics(&statistics);
+	BOOST_REQUIRE(statistics.live_objects == 0);
+	BOOST_REQUIRE(statistics.live_bytes == 0);
+	BOOST_REQUIRE(statistics.peak_bytes == holo::allocator::default_alignment + config::statistics_object_size);
+}
+
+BOOST_AUTO_TEST_CASE(fixed_allocator)
+{
+	holo::fixed_allocator allocator(config::statistics_region_size, config::statistics_object_size);
+	allocator.set_statistics_enabled(true);
+
+	void* first = allocator.allocate(config::statistics_object_size);
+	void* second = allocator.allocate(config::statistics_object_size / 2);
+	BOOST_REQUIRE(first != nullptr && second != nullptr && first != second);
+
+	allocator.deallocate(first);
+
+	allocator.get_statistics(&statistics);
+	BOOST_REQUIRE(statistics.live_objects == 1);
+	BOOST_REQUIRE(statistics.live_bytes == config::statistics_object_size);
+	BOOST_REQUIRE(statistics.peak_objects == 2);
+	BOOST_REQUIRE(statistics.reserved_bytes >= config::statistics_region_size);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
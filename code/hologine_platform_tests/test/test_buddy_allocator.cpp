@@ -0,0 +1,135 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+#include "core/platform.hpp"
+#include "core/memory/buddy_allocator.hpp"
+#include "core/memory/memory_arena_pool.hpp"
+
+namespace config
+{
+	const static std::size_t arena_size = 0x40000u;
+	const static std::size_t arena_count = 4;
+	const static std::size_t min_block_size = 0x1000u;
+}
+
+struct buddy_allocator_test
+{
+	buddy_allocator_test();
+	~buddy_allocator_test();
+
+	holo::memory_arena_pool arena_pool;
+	holo::buddy_allocator allocator;
+};
+
+buddy_allocator_test::buddy_allocator_test() :
+	arena_pool(config::arena_size, config::arena_count),
+	allocator(&arena_pool, config::min_block_size)
+{
+	// Nothing.
+}
+
+buddy_allocator_test::~buddy_allocator_test()
+{
+	// Nothing.
+}
+
+BOOST_FIXTURE_TEST_SUITE(buddy_allocator_test_suite, buddy_allocator_test)
+
+BOOST_AUTO_TEST_CASE(splitting_and_merging)
+{
+	const std::size_t order_count = allocator.get_order_count();
+	BOOST_REQUIRE(allocator.get_min_block_size() == config::min_block_size);
+	BOOST_REQUIRE(allocator.get_max_block_size() == config::arena_size);
+
+	// The smallest block splits the arena all the way down, leaving one free
+	// buddy of every order but the largest.
+	void* first = allocator.allocate(1);
+	BOOST_REQUIRE(first != nullptr);
+	BOOST_REQUIRE(allocator.get_arena_count() == 1);
+	BOOST_REQUIRE(allocator.get_usable_size(first) == config::min_block_size);
+	for (std::size_t i = 0; i + 1 < order_count; ++i)
+	{
+		BOOST_REQUIRE(allocator.get_free_block_count(i) == 1);
+	}
+
+	// Its buddy is next.
+	void* second = allocator.allocate(config::min_block_size);
+	BOOST_REQUIRE((char*)second == (char*)first + config::min_block_size);
+	BOOST_REQUIRE(allocator.get_free_block_count(0) == 0);
+
+	// Sizes round up to the next power of two, and blocks are aligned on their
+	// size.
+	const std::size_t medium_size = config::min_block_size * 3;
+	void* third = allocator.allocate(medium_size);
+	BOOST_REQUIRE(third != nullptr);
+	BOOST_REQUIRE(allocator.get_usable_size(third) == config::min_block_size * 4);
+	BOOST_REQUIRE(((holo::unsigned_pointer)third & (config::min_block_size * 4 - 1)) == 0);
+	std::memset(third, 0xaa, medium_size);
+
+	// Interior pointers find their block.
+	BOOST_REQUIRE(allocator.get_block((char*)third + medium_size - 1) == third);
+
+	// Freeing everything merges the arena back together and gives it back.
+	allocator.deallocate(first);
+	BOOST_REQUIRE(allocator.get_free_block_count(0) == 1);
+
+	allocator.deallocate(third, medium_size);
+	allocator.deallocate(second);
+	BOOST_REQUIRE(allocator.get_arena_count() == 0);
+	for (std::size_t i = 0; i < order_count; ++i)
+	{
+		BOOST_REQUIRE(allocator.get_free_block_count(i) == 0);
+	}
+
+	holo::memory_arena_pool::statistics statistics;
+	arena_pool.get_statistics(&statistics);
+	BOOST_REQUIRE(statistics.arenas_in_use == 0);
+}
+
+BOOST_AUTO_TEST_CASE(whole_arena_blocks)
+{
+	void* blocks[config::arena_count];
+
+	for (std::size_t i = 0; i < config::arena_count; ++i)
+	{
+		blocks[i] = allocator.allocate(config::arena_size);
+		BOOST_REQUIRE(blocks[i] != nullptr);
+		std::memset(blocks[i], 0x55, config::arena_size);
+	}
+	BOOST_REQUIRE(allocator.get_arena_count() == config::arena_count);
+
+	// The arena pool is exhausted, and nothing larger than an arena fits.
+	BOOST_REQUIRE(allocator.allocate(1) == nullptr);
+	BOOST_REQUIRE(allocator.allocate(config::arena_size + 1) == nullptr);
+
+	for (std::size_t i = 0; i < config::arena_count; ++i)
+	{
+		allocator.deallocate(blocks[i]);
+	}
+	BOOST_REQUIRE(allocator.get_arena_count() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(aligned_blocks)
+{
+	const std::size_t alignment = config::min_block_size * 8;
+
+	void* small = allocator.allocate(1);
+	void* aligned = allocator.allocate(1, alignment);
+	BOOST_REQUIRE(aligned != nullptr);
+	BOOST_REQUIRE(((holo::unsigned_pointer)aligned & (alignment - 1)) == 0);
+	BOOST_REQUIRE(allocator.get_usable_size(aligned) == alignment);
+
+	allocator.deallocate(aligned, 1, alignment);
+	allocator.deallocate(small);
+	BOOST_REQUIRE(allocator.get_arena_count() == 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,302 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include "core/memory/allocation_statistics.hpp"
+#include "core/memory/caching_allocator_proxy.hpp"
+#include "core/memory/heap_allocator.hpp"
+#include "core/threading/thread.hpp"
+
+namespace config
+{
+	const static std::size_t heap_arena_size = 0x40000u;
+	const static std::size_t heap_arena_count = 0x20u;
+	const static std::size_t heap_pool_start = 0x20u;
+	const static std::size_t heap_pool_end = 0x1000u;
+	const static std::size_t batch_size = 0x400u;
+	const static std::size_t large_batch_size = 0x4000u;
+	const static std::size_t object_size = 0x40u;
+	const static std::size_t max_object_count = 0x100u;
+	const static std::size_t strict_alignment = 0x100u;
+}
+
+namespace
+{
+	struct remote_objects
+	{
+		holo::caching_allocator_proxy* proxy;
+		std::size_t size_class;
+		void* objects[config::max_object_count];
+		std::size_t count;
+
+		// Blocks cached by the other thread before and after releasing its
+		// cache.
+		std::size_t cached_count;
+		std::size_t released_count;
+	};
+
+	holo::thread_return_status deallocate_remote_objects(void* userdata)
+	{
+		remote_objects* remote = (remote_objects*)userdata;
+
+		for (std::size_t i = 0; i < remote->count; ++i)
+		{
+			remote->proxy->deallocate(remote->objects[i]);
+		}
+		remote->cached_count = remote->proxy->get_cached_count(remote->size_class);
+
+		remote->proxy->release_thread_cache();
+		remote->released_count = remote->proxy->get_cached_count(remote->size_class);
+
+		return holo::thread_return_status_ok;
+	}
+}
+
+struct caching_allocator_proxy_test
+{
+	caching_allocator_proxy_test();
+	~caching_allocator_proxy_test();
+
+	// Gets the number of blocks of a size class taken from the heap, whether
+	// they're cached or handed out.
+	std::size_t get_live_objects(std::size_t size_class);
+
+	// Gets the number of blocks taken from the heap across every size class,
+	// medium and large allocations.
+	std::size_t get_total_live_objects();
+
+	holo::heap_allocator heap_allocator;
+	holo::caching_allocator_proxy proxy;
+
+	std::size_t size_class;
+	std::size_t batch_count;
+};
+
+caching_allocator_proxy_test::caching_allocator_proxy_test() :
+	heap_allocator(
+		config::heap_arena_size,
+		config::heap_arena_count,
+		config::heap_pool_start,
+		config::heap_pool_end),
+	proxy(&heap_allocator, config::batch_size)
+{
+	heap_allocator.set_statistics_enabled(true);
+
+	size_class = heap_allocator.get_size_class(config::object_size);
+	batch_count = config::batch_size / heap_allocator.get_size_class_size(size_class);
+}
+
+caching_allocator_proxy_test::~caching_allocator_proxy_test()
+{
+	// Nothing.
+}
+
+std::size_t caching_allocator_proxy_test::get_live_objects(std::size_t size_class)
+{
+	holo::allocation_statistics statistics;
+	heap_allocator.get_size_class_statistics(size_class, &statistics);
+
+	return statistics.live_objects;
+}
+
+std::size_t caching_allocator_proxy_test::get_total_live_objects()
+{
+	std::size_t live_objects = 0;
+	for (std::size_t i = 0; i <= heap_allocator.get_size_class_count(); ++i)
+	{
+		live_objects += get_live_objects(i);
+	}
+
+	holo::allocation_statistics statistics;
+	heap_allocator.get_medium_allocation_statistics(&statistics);
+
+	return live_objects + statistics.live_objects;
+}
+
+BOOST_FIXTURE_TEST_SUITE(caching_allocator_proxy_test_suite, caching_allocator_proxy_test)
+
+BOOST_AUTO_TEST_CASE(caching_freed_blocks)
+{
+	BOOST_REQUIRE(batch_count > 2);
+
+	void* first = proxy.allocate(config::object_size);
+	void* second = proxy.allocate(config::object_size);
+	BOOST_REQUIRE(first != nullptr && second != nullptr && first != second);
+	BOOST_REQUIRE(proxy.get_cached_count(size_class) == batch_count - 2);
+
+	std::size_t live_objects = get_live_objects(size_class);
+
+	// The most recently freed block is handed out first, without going back
+	// to the heap.
+	proxy.deallocate(first);
+	proxy.deallocate(second, config::object_size);
+	BOOST_REQUIRE(proxy.get_cached_count(size_class) == batch_count);
+	BOOST_REQUIRE(proxy.allocate(config::object_size) == second);
+	BOOST_REQUIRE(proxy.allocate(config::object_size) == first);
+	BOOST_REQUIRE(proxy.get_cached_count(size_class) == batch_count - 2);
+	BOOST_REQUIRE(get_live_objects(size_class) == live_objects);
+
+	proxy.deallocate(first);
+	proxy.deallocate(second);
+}
+
+BOOST_AUTO_TEST_CASE(refilling_and_flushing)
+{
+	void* objects[config::max_object_count];
+	std::size_t count = batch_count * 3;
+	BOOST_REQUIRE(count <= config::max_object_count);
+
+	// An empty magazine is refilled with a whole batch at once.
+	objects[0] = proxy.allocate(config::object_size);
+	BOOST_REQUIRE(objects[0] != nullptr);
+	BOOST_REQUIRE(proxy.get_cached_count(size_class) == batch_count - 1);
+	BOOST_REQUIRE(get_live_objects(size_class) == batch_count);
+
+	for (std::size_t i = 1; i < batch_count; ++i)
+	{
+		objects[i] = proxy.allocate(config::object_size);
+	}
+	BOOST_REQUIRE(proxy.get_cached_count(size_class) == 0);
+	BOOST_REQUIRE(get_live_objects(size_class) == batch_count);
+
+	objects[batch_count] = proxy.allocate(config::object_size);
+	BOOST_REQUIRE(proxy.get_cached_count(size_class) == batch_count - 1);
+
+	for (std::size_t i = batch_count + 1; i < count; ++i)
+	{
+		objects[i] = proxy.allocate(config::object_size);
+		BOOST_REQUIRE(objects[i] != nullptr);
+	}
+	BOOST_REQUIRE(proxy.get_cached_count(size_class) == 0);
+	BOOST_REQUIRE(get_live_objects(size_class) == count);
+
+	// The magazine holds up to two batches; one more flushes a batch.
+	for (std::size_t i = 0; i < batch_count * 2; ++i)
+	{
+		proxy.deallocate(objects[i]);
+	}
+	BOOST_REQUIRE(proxy.get_cached_count(size_class) == batch_count * 2);
+	BOOST_REQUIRE(get_live_objects(size_class) == count);
+
+	proxy.deallocate(objects[batch_count * 2]);
+	BOOST_REQUIRE(proxy.get_cached_count(size_class) == batch_count + 1);
+	BOOST_REQUIRE(get_live_objects(size_class) == count - batch_count);
+
+	for (std::size_t i = batch_count * 2 + 1; i < count; ++i)
+	{
+		proxy.deallocate(objects[i]);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(refilling_large_batches)
+{
+	// Batches larger than a single transfer to or from the heap are moved in
+	// several steps.
+	holo::caching_allocator_proxy large_batch_proxy(&heap_allocator, config::large_batch_size);
+	std::size_t large_batch_count =
+		config::large_batch_size / heap_allocator.get_size_class_size(size_class);
+
+	void* object = large_batch_proxy.allocate(config::object_size);
+	BOOST_REQUIRE(object != nullptr);
+	BOOST_REQUIRE(large_batch_proxy.get_cached_count(size_class) == large_batch_count - 1);
+	BOOST_REQUIRE(get_live_objects(size_class) == large_batch_count);
+
+	large_batch_proxy.deallocate(object);
+	large_batch_proxy.release_thread_cache();
+	BOOST_REQUIRE(get_live_objects(size_class) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(releasing_thread_cache)
+{
+	void* object = proxy.allocate(config::object_size);
+	BOOST_REQUIRE(object != nullptr);
+	proxy.deallocate(object);
+	BOOST_REQUIRE(proxy.get_cached_count(size_class) == batch_count);
+	BOOST_REQUIRE(get_live_objects(size_class) == batch_count);
+
+	proxy.release_thread_cache();
+	BOOST_REQUIRE(proxy.get_cached_count(size_class) == 0);
+	BOOST_REQUIRE(get_live_objects(size_class) == 0);
+
+	// The thread can keep using the proxy with a new cache.
+	object = proxy.allocate(config::object_size);
+	BOOST_REQUIRE(object != nullptr);
+	BOOST_REQUIRE(proxy.get_cached_count(size_class) == batch_count - 1);
+	BOOST_REQUIRE(get_live_objects(size_class) == batch_count);
+
+	proxy.deallocate(object);
+}
+
+BOOST_AUTO_TEST_CASE(remote_deallocation)
+{
+	remote_objects remote;
+	remote.proxy = &proxy;
+	remote.size_class = size_class;
+	remote.count = batch_count;
+
+	for (std::size_t i = 0; i < remote.count; ++i)
+	{
+		remote.objects[i] = proxy.allocate(config::object_size);
+		BOOST_REQUIRE(remote.objects[i] != nullptr);
+	}
+	BOOST_REQUIRE(proxy.get_cached_count(size_class) == 0);
+	BOOST_REQUIRE(get_live_objects(size_class) == batch_count);
+
+	// The blocks end up in the other thread's cache, which it returns to the
+	// heap before exiting.
+	holo::thread thread;
+	thread.start(&deallocate_remote_objects, &remote);
+	BOOST_REQUIRE(thread.join() == holo::thread_return_status_ok);
+
+	BOOST_REQUIRE(remote.cached_count == batch_count);
+	BOOST_REQUIRE(remote.released_count == 0);
+	BOOST_REQUIRE(proxy.get_cached_count(size_class) == 0);
+	BOOST_REQUIRE(get_live_objects(size_class) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(passing_through)
+{
+	// Stricter alignments go straight to the heap, a single block at a time,
+	// without touching the cache.
+	std::size_t aligned_size_class =
+		heap_allocator.get_size_class(config::object_size, config::strict_alignment);
+
+	std::size_t live_objects = get_total_live_objects();
+	void* aligned = proxy.allocate(config::object_size, config::strict_alignment);
+	BOOST_REQUIRE(aligned != nullptr);
+	BOOST_REQUIRE((std::uintptr_t)aligned % config::strict_alignment == 0);
+	BOOST_REQUIRE(get_total_live_objects() == live_objects + 1);
+	BOOST_REQUIRE(proxy.get_cached_count(aligned_size_class) == 0);
+
+	// So do allocations too large for any size class.
+	holo::allocation_statistics statistics;
+	void* medium = proxy.allocate(config::heap_pool_end * 2);
+	BOOST_REQUIRE(medium != nullptr);
+	heap_allocator.get_medium_allocation_statistics(&statistics);
+	BOOST_REQUIRE(statistics.live_objects == 1);
+
+	void* large = proxy.allocate(config::heap_arena_size * 2);
+	BOOST_REQUIRE(large != nullptr);
+	BOOST_REQUIRE(heap_allocator.get_large_allocation_count() == 1);
+
+	proxy.deallocate(large);
+	BOOST_REQUIRE(heap_allocator.get_large_allocation_count() == 0);
+
+	proxy.deallocate(medium);
+	heap_allocator.get_medium_allocation_statistics(&statistics);
+	BOOST_REQUIRE(statistics.live_objects == 0);
+
+	// The block an aligned allocation comes from is cached like any other
+	// once freed.
+	proxy.deallocate(aligned);
+	BOOST_REQUIRE(proxy.get_cached_count(aligned_size_class) == 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
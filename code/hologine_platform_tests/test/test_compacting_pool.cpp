@@ -0,0 +1,143 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include <boost/test/unit_test.hpp>
+#include "core/platform.hpp"
+#include "core/memory/compacting_pool.hpp"
+#include "core/memory/memory_arena_pool.hpp"
+
+namespace config
+{
+	const static std::size_t arena_size = 0x8000u;
+	const static std::size_t arena_count = 8;
+	const static std::size_t object_size = 0x100u;
+	const static std::size_t max_object_count = 0x400u;
+}
+
+struct compacting_pool_test
+{
+	compacting_pool_test();
+	~compacting_pool_test();
+
+	holo::memory_arena_pool arena_pool;
+	holo::compacting_pool pool;
+};
+
+compacting_pool_test::compacting_pool_test() :
+	arena_pool(config::arena_size, config::arena_count),
+	pool(&arena_pool, config::object_size, config::max_object_count)
+{
+	// Nothing.
+}
+
+compacting_pool_test::~compacting_pool_test()
+{
+	// Nothing.
+}
+
+BOOST_FIXTURE_TEST_SUITE(compacting_pool_test_suite, compacting_pool_test)
+
+BOOST_AUTO_TEST_CASE(stale_handles)
+{
+	holo::handle handle = pool.allocate();
+	BOOST_REQUIRE(handle != 0);
+	BOOST_REQUIRE(holo::compacting_pool::handle_definition::is_type(handle));
+	BOOST_REQUIRE(pool.get(handle) != nullptr);
+	BOOST_REQUIRE(pool.get_live_count() == 1);
+
+	pool.deallocate(handle);
+	BOOST_REQUIRE(!pool.is_valid(handle));
+	BOOST_REQUIRE(pool.get_arena_count() == 0);
+
+	// The table entry is reused, but with a new age.
+	holo::handle reused = pool.allocate();
+	BOOST_REQUIRE(reused != handle);
+	BOOST_REQUIRE(
+		holo::compacting_pool::handle_definition::decode_index(reused) ==
+		holo::compacting_pool::handle_definition::decode_index(handle));
+	BOOST_REQUIRE(!pool.is_valid(handle));
+	BOOST_REQUIRE(pool.is_valid(reused));
+
+	pool.deallocate(reused);
+}
+
+BOOST_AUTO_TEST_CASE(compacting_sparse_arenas)
+{
+	const std::size_t arena_object_count = pool.get_object_count();
+	const std::size_t count = arena_object_count * 4;
+	holo::handle handles[config::max_object_count];
+	BOOST_REQUIRE(count <= config::max_object_count);
+
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		handles[i] = pool.allocate();
+		BOOST_REQUIRE(handles[i] != 0);
+
+		*(std::size_t*)pool.get(handles[i]) = i;
+	}
+	BOOST_REQUIRE(pool.get_arena_count() == 4);
+
+	// Leave one object in four pinning each arena.
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		if (i % 4 != 0)
+		{
+			pool.deallocate(handles[i]);
+			handles[i] = 0;
+		}
+	}
+	BOOST_REQUIRE(pool.get_arena_count() == 4);
+
+	// Compaction is incremental.
+	BOOST_REQUIRE(pool.defragment(1) == 1);
+
+	std::size_t step;
+	while ((step = pool.defragment(4)) > 0)
+	{
+		BOOST_REQUIRE(step <= 4);
+	}
+
+	// A quarter of the objects now fit in a single arena; the emptied arenas
+	// went back to the arena pool.
+	BOOST_REQUIRE(pool.get_arena_count() == 1);
+
+	holo::memory_arena_pool::statistics statistics;
+	arena_pool.get_statistics(&statistics);
+	BOOST_REQUIRE(statistics.arenas_in_use == 1);
+
+	// Every handle still refers to its own object.
+	for (std::size_t i = 0; i < count; i += 4)
+	{
+		std::size_t* object = (std::size_t*)pool.get(handles[i]);
+		BOOST_REQUIRE(object != nullptr);
+		BOOST_REQUIRE(*object == i);
+	}
+
+	for (std::size_t i = 0; i < count; i += 4)
+	{
+		pool.deallocate(handles[i]);
+	}
+	BOOST_REQUIRE(pool.get_arena_count() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(defragmenting_dense_pool)
+{
+	holo::handle first = pool.allocate();
+	holo::handle second = pool.allocate();
+	void* object = pool.get(first);
+
+	// A single arena can't be compacted any further.
+	BOOST_REQUIRE(pool.defragment(0x10u) == 0);
+	BOOST_REQUIRE(pool.get(first) == object);
+
+	pool.deallocate(first);
+	pool.deallocate(second);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,91 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include <boost/test/unit_test.hpp>
+#include "core/platform.hpp"
+#include "core/memory/fixed_allocator.hpp"
+
+namespace config
+{
+	const static std::size_t fixed_region_size = 0x1000u;
+	const static std::size_t fixed_object_size = 0x40u;
+}
+
+struct fixed_allocator_test
+{
+	fixed_allocator_test();
+	~fixed_allocator_test();
+
+	holo::fixed_allocator allocator;
+};
+
+fixed_allocator_test::fixed_allocator_test() :
+	allocator(config::fixed_region_size, config::fixed_object_size)
+{
+	// Nothing.
+}
+
+fixed_allocator_test::~fixed_allocator_test()
+{
+	// Nothing.
+}
+
+BOOST_FIXTURE_TEST_SUITE(fixed_allocator_test_suite, fixed_allocator_test)
+
+BOOST_AUTO_TEST_CASE(exhausting)
+{
+	std::size_t object_count = config::fixed_region_size / config::fixed_object_size;
+
+	// Objects are handed out from low to high addresses.
+	char* previous = nullptr;
+	for (std::size_t i = 0; i < object_count; ++i)
+	{
+		char* pointer = (char*)allocator.allocate(config::fixed_object_size);
+
+		BOOST_REQUIRE(pointer != nullptr);
+		BOOST_REQUIRE(previous == nullptr || pointer == previous + config::fixed_object_size);
+
+		previous = pointer;
+	}
+
+	BOOST_REQUIRE(allocator.allocate(config::fixed_object_size) == nullptr);
+
+	allocator.deallocate(previous);
+	BOOST_REQUIRE(allocator.allocate(config::fixed_object_size) == previous);
+}
+
+BOOST_AUTO_TEST_CASE(batch_allocation_deallocation)
+{
+	const std::size_t batch_size = 8;
+	std::size_t object_count = config::fixed_region_size / config::fixed_object_size;
+	void* pointers[batch_size];
+
+	BOOST_REQUIRE(allocator.allocate_batch(config::fixed_object_size, batch_size, pointers) == batch_size);
+	for (std::size_t i = 1; i < batch_size; ++i)
+	{
+		BOOST_REQUIRE((char*)pointers[i] == (char*)pointers[i - 1] + config::fixed_object_size);
+	}
+
+	// A batch larger than the remaining objects is only partially satisfied.
+	void* remaining[0x100];
+	std::size_t remaining_count = object_count - batch_size;
+	BOOST_REQUIRE(allocator.allocate_batch(1, remaining_count + 1, remaining) == remaining_count);
+
+	// Freed batches are reused in order.
+	allocator.deallocate_batch(pointers, batch_size);
+
+	void* reused[batch_size];
+	BOOST_REQUIRE(allocator.allocate_batch(1, batch_size, reused) == batch_size);
+	for (std::size_t i = 0; i < batch_size; ++i)
+	{
+		BOOST_REQUIRE(reused[i] == pointers[i]);
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
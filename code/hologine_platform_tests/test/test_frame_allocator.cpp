@@ -0,0 +1,148 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include <boost/test/unit_test.hpp>
+#include "core/platform.hpp"
+#include "core/memory/frame_allocator.hpp"
+#include "core/threading/thread.hpp"
+
+namespace config
+{
+	const static std::size_t frame_size = 0x10000u;
+	const static std::size_t frame_count = 3;
+
+	// Number of frames produced while another thread completes them.
+	const static std::size_t fenced_frame_count = 200;
+}
+
+namespace
+{
+	struct frame_consumer
+	{
+		holo::frame_allocator* allocator;
+	};
+
+	// Completes frames one at a time, after checking the producer did not reuse
+	// the buffer of a frame that wasn't yet completed.
+	holo::thread_return_status consume_frames(void* userdata)
+	{
+		frame_consumer* consumer = (frame_consumer*)userdata;
+		bool success = true;
+
+		for (std::uint64_t frame = 0; frame < config::fenced_frame_count; ++frame)
+		{
+			// Wait for the producer to reach the frame.
+			while (consumer->allocator->get_current_frame() < frame)
+			{
+				// Nothing.
+			}
+
+			if (consumer->allocator->is_frame_complete(frame))
+			{
+				success = false;
+			}
+
+			consumer->allocator->complete_frame(frame);
+		}
+
+		return success ? holo::thread_return_status_ok : 1;
+	}
+}
+
+struct frame_allocator_test
+{
+	frame_allocator_test();
+	~frame_allocator_test();
+
+	holo::frame_allocator allocator;
+};
+
+frame_allocator_test::frame_allocator_test() :
+	allocator(config::frame_size, config::frame_count)
+{
+	// Nothing.
+}
+
+frame_allocator_test::~frame_allocator_test()
+{
+	// Nothing.
+}
+
+BOOST_FIXTURE_TEST_SUITE(frame_allocator_test_suite, frame_allocator_test)
+
+BOOST_AUTO_TEST_CASE(rotating_frames)
+{
+	BOOST_REQUIRE(allocator.get_current_frame() == 0);
+	BOOST_REQUIRE(allocator.get_frame_count() == config::frame_count);
+
+	void* first_pointers[config::frame_count];
+	for (std::size_t i = 0; i < config::frame_count; ++i)
+	{
+		if (i > 0)
+		{
+			BOOST_REQUIRE(allocator.begin_frame() == i);
+		}
+
+		first_pointers[i] = allocator.allocate(0x100u);
+		BOOST_REQUIRE(first_pointers[i] != nullptr);
+
+		// Allocations within a frame are bumped from the same buffer.
+		void* second_pointer = allocator.allocate(0x100u);
+		BOOST_REQUIRE(second_pointer == (char*)first_pointers[i] + 0x100u);
+
+		// Each frame has its own buffer.
+		for (std::size_t j = 0; j < i; ++j)
+		{
+			BOOST_REQUIRE(first_pointers[i] != first_pointers[j]);
+		}
+	}
+
+	BOOST_REQUIRE(!allocator.is_frame_complete(0));
+
+	// Completing the second frame completes the first as well.
+	allocator.complete_frame(1);
+	BOOST_REQUIRE(allocator.is_frame_complete(0));
+	BOOST_REQUIRE(allocator.is_frame_complete(1));
+	BOOST_REQUIRE(!allocator.is_frame_complete(2));
+
+	// The first frame's buffer is reset and reused.
+	BOOST_REQUIRE(allocator.begin_frame() == config::frame_count);
+	BOOST_REQUIRE(allocator.allocate(0x100u) == first_pointers[0]);
+
+	// Frames larger than the buffer fail.
+	BOOST_REQUIRE(allocator.allocate(config::frame_size * 2) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(fenced_by_another_thread)
+{
+	frame_consumer consumer = { &allocator };
+	holo::thread thread;
+	thread.start(&consume_frames, &consumer);
+
+	for (std::size_t frame = 0; frame < config::fenced_frame_count; ++frame)
+	{
+		if (frame > 0)
+		{
+			// Blocks until the frame that last used the buffer is complete.
+			BOOST_REQUIRE(allocator.begin_frame() == frame);
+
+			if (frame >= config::frame_count)
+			{
+				BOOST_REQUIRE(allocator.is_frame_complete(frame - config::frame_count));
+			}
+		}
+
+		BOOST_REQUIRE(allocator.allocate(0x40u) != nullptr);
+	}
+
+	BOOST_REQUIRE(thread.join() == holo::thread_return_status_ok);
+	BOOST_REQUIRE(allocator.is_frame_complete(config::fenced_frame_count - 1));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
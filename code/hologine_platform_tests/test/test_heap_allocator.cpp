@@ -0,0 +1,375 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+#include "core/platform.hpp"
+#include "core/io/binary_reader.hpp"
+#include "core/io/endianness.hpp"
+#include "core/io/memory_stream.hpp"
+#include "core/memory/heap_allocator.hpp"
+
+namespace config
+{
+	const static std::size_t heap_arena_size = 0x40000u;
+	const static std::size_t heap_arena_count = 0x20u;
+	const static std::size_t heap_pool_start = 0x20u;
+	const static std::size_t heap_pool_end = 0x10000u;
+	const static std::size_t statistics_buffer_size = 0x1000u;
+}
+
+struct heap_allocator_test
+{
+	heap_allocator_test();
+	~heap_allocator_test();
+
+	holo::heap_allocator allocator;
+};
+
+heap_allocator_test::heap_allocator_test() :
+	allocator(
+		config::heap_arena_size,
+		config::heap_arena_count,
+		config::heap_pool_start,
+		config::heap_pool_end)
+{
+	// Nothing.
+}
+
+heap_allocator_test::~heap_allocator_test()
+{
+	// Nothing.
+}
+
+BOOST_FIXTURE_TEST_SUITE(heap_allocator_test_suite, heap_allocator_test)
+
+BOOST_AUTO_TEST_CASE(size_classes)
+{
+	std::size_t count = allocator.get_size_class_count();
+	BOOST_REQUIRE(count > 0);
+
+	BOOST_REQUIRE(allocator.get_size_class_size(0) >= config::heap_pool_start);
+	BOOST_REQUIRE(allocator.get_size_class_size(count - 1) == config::heap_pool_end);
+
+	// Every size should map to the smallest class it fits in.
+	for (std::size_t size = 1; size <= config::heap_pool_end; size += 7)
+	{
+		std::size_t size_class = allocator.get_size_class(size);
+
+		BOOST_REQUIRE(size_class < count);
+		BOOST_REQUIRE(allocator.get_size_class_size(size_class) >= size);
+		BOOST_REQUIRE(size_class == 0 || allocator.get_size_class_size(size_class - 1) < size);
+	}
+
+	BOOST_REQUIRE(allocator.get_size_class(config::heap_pool_end + 1) == count);
+
+	// Size classes are multiples of the default alignment, and past the linear
+	// classes, rounding up wastes less than a fifth of a block.
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		std::size_t size = allocator.get_size_class_size(i);
+		BOOST_REQUIRE(size % holo::allocator::default_alignment == 0);
+		BOOST_REQUIRE(i == 0 || size > allocator.get_size_class_size(i - 1));
+
+		if (i > 0 && allocator.get_size_class_size(i - 1) >= 64)
+		{
+			std::size_t smallest_size = allocator.get_size_class_size(i - 1) + 1;
+			BOOST_REQUIRE((size - smallest_size) * 5 < size);
+		}
+	}
+
+	// Some known boundaries.
+	BOOST_REQUIRE(allocator.get_size_class_size(allocator.get_size_class(33)) == 48);
+	BOOST_REQUIRE(allocator.get_size_class_size(allocator.get_size_class(65)) == 80);
+	BOOST_REQUIRE(allocator.get_size_class_size(allocator.get_size_class(4097)) == 5120);
+}
+
+BOOST_AUTO_TEST_CASE(allocations_do_not_overlap)
+{
+	const std::size_t object_count = 64;
+	const std::size_t object_size = 0x30u;
+	unsigned char* objects[object_count];
+
+	for (std::size_t i = 0; i < object_count; ++i)
+	{
+		objects[i] = (unsigned char*)allocator.allocate(object_size);
+
+		BOOST_REQUIRE(objects[i] != nullptr);
+		BOOST_REQUIRE(((holo::unsigned_pointer)objects[i] & (holo::allocator::default_alignment - 1)) == 0);
+
+		std::memset(objects[i], (int)i, object_size);
+	}
+
+	for (std::size_t i = 0; i < object_count; ++i)
+	{
+		for (std::size_t j = 0; j < object_size; ++j)
+		{
+			BOOST_REQUIRE(objects[i][j] == (unsigned char)i);
+		}
+	}
+
+	// Free every other object, then reallocate; the freed blocks should be
+	// reused without corrupting their neighbors.
+	for (std::size_t i = 0; i < object_count; i += 2)
+	{
+		allocator.deallocate(objects[i]);
+	}
+
+	for (std::size_t i = 0; i < object_count; i += 2)
+	{
+		objects[i] = (unsigned char*)allocator.allocate(object_size);
+		std::memset(objects[i], 0xff, object_size);
+	}
+
+	for (std::size_t i = 1; i < object_count; i += 2)
+	{
+		BOOST_REQUIRE(objects[i][0] == (unsigned char)i);
+		BOOST_REQUIRE(objects[i][object_size - 1] == (unsigned char)i);
+	}
+
+	for (std::size_t i = 0; i < object_count; ++i)
+	{
+		allocator.deallocate(objects[i]);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(aligned_allocation)
+{
+	const std::size_t alignment = 0x100u;
+
+	void* pointer = allocator.allocate(0x40u, alignment);
+	BOOST_REQUIRE(pointer != nullptr);
+	BOOST_REQUIRE(((holo::unsigned_pointer)pointer & (alignment - 1)) == 0);
+
+	std::size_t size_class;
+	void* block = allocator.get_block(pointer, &size_class);
+	BOOST_REQUIRE(block <= pointer);
+	BOOST_REQUIRE((char*)pointer + 0x40u <= (char*)block + allocator.get_size_class_size(size_class));
+
+	allocator.deallocate(pointer);
+}
+
+BOOST_AUTO_TEST_CASE(large_allocation)
+{
+	const std::size_t large_size = config::heap_pool_end * 4 + 1;
+	const std::size_t large_alignment = 0x1000u;
+
+	unsigned char* first = (unsigned char*)allocator.allocate(large_size);
+	unsigned char* second = (unsigned char*)allocator.allocate(large_size, large_alignment);
+
+	BOOST_REQUIRE(first != nullptr && second != nullptr);
+	BOOST_REQUIRE(((holo::unsigned_pointer)first & (holo::allocator::default_alignment - 1)) == 0);
+	BOOST_REQUIRE(((holo::unsigned_pointer)second & (large_alignment - 1)) == 0);
+
+	BOOST_REQUIRE(allocator.get_large_allocation_count() == 2);
+	BOOST_REQUIRE(allocator.get_large_allocation_size() >= large_size * 2);
+
+	// The entire allocation must be usable.
+	std::memset(first, 0xaa, large_size);
+	std::memset(second, 0x55, large_size);
+
+	std::size_t size_class;
+	BOOST_REQUIRE(allocator.get_block(first, &size_class) == nullptr);
+	BOOST_REQUIRE(size_class == allocator.get_size_class_count());
+
+	allocator.deallocate(first);
+	BOOST_REQUIRE(allocator.get_large_allocation_count() == 1);
+	BOOST_REQUIRE(second[0] == 0x55 && second[large_size - 1] == 0x55);
+
+	allocator.deallocate(second);
+	BOOST_REQUIRE(allocator.get_large_allocation_count() == 0);
+	BOOST_REQUIRE(allocator.get_large_allocation_size() == 0);
+
+	// Large allocations left alive are released by the destructor.
+	BOOST_REQUIRE(allocator.allocate(large_size) != nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(medium_allocation)
+{
+	const std::size_t medium_size = config::heap_pool_end + 1;
+
+	BOOST_REQUIRE(allocator.get_medium_allocation_limit() == config::heap_arena_size);
+
+	// Allocations past the largest size class but within an arena are split
+	// out of arenas rather than mapped on their own.
+	unsigned char* first = (unsigned char*)allocator.allocate(medium_size);
+	unsigned char* second = (unsigned char*)allocator.allocate(config::heap_arena_size);
+	BOOST_REQUIRE(first != nullptr && second != nullptr);
+	BOOST_REQUIRE(allocator.get_large_allocation_count() == 0);
+
+	std::memset(first, 0xaa, medium_size);
+	std::memset(second, 0x55, config::heap_arena_size);
+
+	std::size_t size_class;
+	BOOST_REQUIRE(allocator.get_block(first, &size_class) == nullptr);
+	BOOST_REQUIRE(size_class == allocator.get_size_class_count());
+	BOOST_REQUIRE(allocator.get_usable_size(first) >= medium_size);
+
+	holo::memory_arena_pool::statistics statistics;
+	allocator.get_arena_pool_statistics(&statistics);
+	BOOST_REQUIRE(statistics.arenas_in_use == 2);
+
+	allocator.deallocate(first);
+	allocator.deallocate(second, config::heap_arena_size);
+
+	allocator.get_arena_pool_statistics(&statistics);
+	BOOST_REQUIRE(statistics.arenas_in_use == 0);
+}
+
+BOOST_AUTO_TEST_CASE(batch_allocation)
+{
+	const std::size_t object_count = 48;
+	const std::size_t alignment = 0x40u;
+	void* pointers[object_count];
+
+	// Mix two size classes and a large allocation in one batch to free.
+	BOOST_REQUIRE(allocator.allocate_batch(0x20u, 16, pointers) == 16);
+	BOOST_REQUIRE(allocator.allocate_batch(0x30u, 16, pointers + 16, alignment) == 16);
+	BOOST_REQUIRE(allocator.allocate_batch(0x80u, 15, pointers + 32) == 15);
+	BOOST_REQUIRE(allocator.allocate_batch(config::heap_pool_end + 1, 1, pointers + 47) == 1);
+
+	for (std::size_t i = 16; i < 32; ++i)
+	{
+		BOOST_REQUIRE(((holo::unsigned_pointer)pointers[i] & (alignment - 1)) == 0);
+	}
+
+	for (std::size_t i = 0; i < object_count; ++i)
+	{
+		BOOST_REQUIRE(pointers[i] != nullptr);
+		for (std::size_t j = 0; j < i; ++j)
+		{
+			BOOST_REQUIRE(pointers[i] != pointers[j]);
+		}
+	}
+
+	allocator.set_statistics_enabled(true);
+	allocator.deallocate_batch(pointers, object_count);
+	BOOST_REQUIRE(allocator.get_large_allocation_count() == 0);
+
+	holo::allocation_statistics statistics;
+	allocator.get_size_class_statistics(allocator.get_size_class(0x20u), &statistics);
+	BOOST_REQUIRE(statistics.deallocation_count == 16);
+}
+
+BOOST_AUTO_TEST_CASE(sized_deallocation)
+{
+	const std::size_t sizes[] = { 1, 48, 200, 0x1001u, config::heap_pool_end * 2 };
+	const std::size_t alignment = 0x40u;
+
+	for (std::size_t size : sizes)
+	{
+		void* pointer = allocator.allocate(size);
+		BOOST_REQUIRE(pointer != nullptr);
+
+		// The usable size covers the request and stays within the size class.
+		std::size_t usable_size = allocator.get_usable_size(pointer);
+		BOOST_REQUIRE(usable_size >= size);
+
+		std::size_t size_class = allocator.get_size_class(size);
+		if (size_class < allocator.get_size_class_count())
+		{
+			BOOST_REQUIRE(usable_size == allocator.get_size_class_size(size_class));
+		}
+
+		std::memset(pointer, 0xff, usable_size);
+		allocator.deallocate(pointer, size);
+
+		// Aligned allocations are offset into their block, so less of it is
+		// usable.
+		void* aligned_pointer = allocator.allocate(size, alignment);
+		BOOST_REQUIRE(aligned_pointer != nullptr);
+
+		usable_size = allocator.get_usable_size(aligned_pointer);
+		BOOST_REQUIRE(usable_size >= size);
+
+		std::memset(aligned_pointer, 0xff, usable_size);
+		allocator.deallocate(aligned_pointer, size, alignment);
+	}
+
+	BOOST_REQUIRE(allocator.get_large_allocation_count() == 0);
+
+	// A block returned with its size is reused like any other.
+	void* pointer = allocator.allocate(0x100u);
+	allocator.deallocate(pointer, 0x100u);
+	BOOST_REQUIRE(allocator.allocate(0x100u) == pointer);
+}
+
+BOOST_AUTO_TEST_CASE(statistics)
+{
+	const std::size_t object_size = 0x28u;
+	const std::size_t object_count = 16;
+	void* objects[object_count];
+
+	holo::allocation_statistics statistics;
+	std::size_t size_class = allocator.get_size_class(object_size);
+
+	// Statistics are opt-in.
+	allocator.allocate(object_size);
+	allocator.get_size_class_statistics(size_class, &statistics);
+	BOOST_REQUIRE(statistics.allocation_count == 0);
+
+	allocator.set_statistics_enabled(true);
+
+	for (std::size_t i = 0; i < object_count; ++i)
+	{
+		objects[i] = allocator.allocate(object_size);
+	}
+	allocator.deallocate(objects[0]);
+
+	std::size_t block_size = allocator.get_size_class_size(size_class);
+	allocator.get_size_class_statistics(size_class, &statistics);
+	BOOST_REQUIRE(statistics.allocation_count == object_count);
+	BOOST_REQUIRE(statistics.deallocation_count == 1);
+	BOOST_REQUIRE(statistics.live_objects == object_count - 1);
+	BOOST_REQUIRE(statistics.live_bytes == (object_count - 1) * block_size);
+	BOOST_REQUIRE(statistics.peak_objects == object_count);
+	BOOST_REQUIRE(statistics.committed_bytes == config::heap_arena_size);
+
+	double expected_fragmentation = 1.0 - (double)object_size / block_size;
+	double fragmentation = holo::get_internal_fragmentation(statistics);
+	BOOST_REQUIRE(fragmentation > expected_fragmentation - 0.001);
+	BOOST_REQUIRE(fragmentation < expected_fragmentation + 0.001);
+
+	holo::memory_arena_pool::statistics arena_pool_statistics;
+	allocator.get_arena_pool_statistics(&arena_pool_statistics);
+	BOOST_REQUIRE(arena_pool_statistics.arenas_in_use == 1);
+	BOOST_REQUIRE(arena_pool_statistics.reserved_arenas == config::heap_arena_count);
+	BOOST_REQUIRE(arena_pool_statistics.committed_bytes >= config::heap_arena_size);
+	BOOST_REQUIRE(arena_pool_statistics.reserved_bytes >= arena_pool_statistics.committed_bytes);
+
+	// Export the snapshot and read back the size class.
+	std::uint8_t buffer[config::statistics_buffer_size];
+	holo::memory_stream stream(buffer, config::statistics_buffer_size);
+	BOOST_REQUIRE(allocator.write_statistics(&stream));
+
+	holo::memory_stream input_stream(buffer, stream.get_position());
+	holo::binary_reader reader(&input_stream, holo::endianness::little);
+
+	std::uint64_t value;
+	for (int i = 0; i < 8; ++i)
+	{
+		BOOST_REQUIRE(reader.read_ulong(value));
+	}
+	BOOST_REQUIRE(value == arena_pool_statistics.committed_bytes);
+
+	std::uint32_t size_class_count;
+	BOOST_REQUIRE(reader.read_uint(size_class_count));
+	BOOST_REQUIRE(size_class_count == allocator.get_size_class_count() + 1);
+
+	// Skip to the size class; each one is its size followed by ten fields.
+	for (std::size_t i = 0; i < size_class * 11; ++i)
+	{
+		BOOST_REQUIRE(reader.read_ulong(value));
+	}
+
+	BOOST_REQUIRE(reader.read_ulong(value) && value == block_size);
+	BOOST_REQUIRE(reader.read_ulong(value) && value == object_count - 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
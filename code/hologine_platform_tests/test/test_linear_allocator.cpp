@@ -0,0 +1,154 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include <cstring>
+#include "core/platform.hpp"
+#include "core/memory/linear_allocator.hpp"
+#include "core/memory/memory_region.hpp"
+
+namespace config
+{
+	const static std::size_t linear_size = 0x1000000u;
+	const static std::size_t linear_chunk_size = 0x10000u;
+	const static std::size_t shared_size = 0x100000u;
+	const static char* shared_memory_name = "/hologine_test_linear_allocator";
+}
+
+struct linear_allocator_test
+{
+	linear_allocator_test();
+	~linear_allocator_test();
+
+	holo::linear_allocator allocator;
+};
+
+linear_allocator_test::linear_allocator_test() :
+	allocator(
+		config::linear_size,
+		holo::linear_allocator::flag_commit_lazily,
+		config::linear_chunk_size)
+{
+	// Nothing.
+}
+
+linear_allocator_test::~linear_allocator_test()
+{
+	// Nothing.
+}
+
+BOOST_FIXTURE_TEST_SUITE(linear_allocator_test_suite, linear_allocator_test)
+
+BOOST_AUTO_TEST_CASE(committing_eagerly)
+{
+	holo::linear_allocator eager_allocator(config::linear_chunk_size);
+
+	BOOST_REQUIRE(eager_allocator.get_size() >= config::linear_chunk_size);
+	BOOST_REQUIRE(eager_allocator.get_committed_size() == eager_allocator.get_size());
+
+	char* first = (char*)eager_allocator.allocate(0x10u);
+	char* second = (char*)eager_allocator.allocate(0x10u);
+	BOOST_REQUIRE(first != nullptr && second == first + 0x10u);
+
+	BOOST_REQUIRE(eager_allocator.allocate(eager_allocator.get_size()) == nullptr);
+
+	eager_allocator.reset();
+	BOOST_REQUIRE(eager_allocator.allocate(0x10u) == first);
+}
+
+BOOST_AUTO_TEST_CASE(committing_lazily)
+{
+	// Only the reservation is made up front.
+	BOOST_REQUIRE(allocator.get_size() >= config::linear_size);
+	BOOST_REQUIRE(allocator.get_committed_size() == 0);
+
+	char* base = (char*)allocator.allocate(1);
+	BOOST_REQUIRE(base != nullptr);
+	BOOST_REQUIRE(allocator.get_committed_size() == config::linear_chunk_size);
+
+	// Allocations are still contiguous across chunks.
+	char* pointer = (char*)allocator.allocate(config::linear_chunk_size * 2, 1);
+	BOOST_REQUIRE(pointer == base + 1);
+	BOOST_REQUIRE(allocator.get_committed_size() == config::linear_chunk_size * 3);
+	std::memset(pointer, 0xcd, config::linear_chunk_size * 2);
+
+	// The whole reservation can be used.
+	allocator.reset();
+	std::size_t size = allocator.get_size();
+	BOOST_REQUIRE(allocator.allocate(size, 1) == base);
+	BOOST_REQUIRE(allocator.get_committed_size() == size);
+	BOOST_REQUIRE(allocator.allocate(1) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(decommitting_past_high_water_mark)
+{
+	allocator.set_high_water_mark(config::linear_chunk_size * 2);
+
+	char* base = (char*)allocator.allocate(config::linear_chunk_size * 4);
+	BOOST_REQUIRE(base != nullptr);
+	std::memset(base, 0xcd, config::linear_chunk_size * 4);
+	BOOST_REQUIRE(allocator.get_committed_size() == config::linear_chunk_size * 4);
+
+	// Memory up to the mark stays committed (and keeps its contents).
+	allocator.reset();
+	BOOST_REQUIRE(allocator.get_committed_size() == config::linear_chunk_size * 2);
+	BOOST_REQUIRE(base[config::linear_chunk_size * 2 - 1] == (char)0xcd);
+
+	// Resetting below the mark changes nothing.
+	BOOST_REQUIRE(allocator.allocate(config::linear_chunk_size) == base);
+	allocator.reset();
+	BOOST_REQUIRE(allocator.get_committed_size() == config::linear_chunk_size * 2);
+
+	// Decommitted memory comes back zeroed.
+	BOOST_REQUIRE(allocator.allocate(config::linear_chunk_size * 3) == base);
+	BOOST_REQUIRE(base[config::linear_chunk_size * 2] == 0);
+}
+
+BOOST_AUTO_TEST_CASE(allocating_shared_memory)
+{
+	struct counters
+	{
+		std::uint64_t frame_count;
+		std::uint64_t entity_count;
+	};
+
+	// A failed run may have left the name behind.
+	holo::memory_region::remove_shared_memory(config::shared_memory_name);
+
+	holo::linear_allocator shared_allocator(
+		holo::memory_region::create_shared_memory(config::shared_memory_name, config::shared_size),
+		holo::linear_allocator::flag_commit_lazily);
+	BOOST_REQUIRE(shared_allocator.get_size() == config::shared_size);
+
+	// Lay out some data, and publish where it is by offset.
+	shared_allocator.allocate(0x100);
+	counters* writer_counters = (counters*)shared_allocator.allocate(sizeof(counters));
+	BOOST_REQUIRE(writer_counters != nullptr);
+	writer_counters->frame_count = 60;
+	writer_counters->entity_count = 1024;
+
+	std::size_t offset = shared_allocator.get_offset(writer_counters);
+	BOOST_REQUIRE(shared_allocator.get_pointer(offset) == writer_counters);
+
+	// A reader maps the same object elsewhere and finds the data by offset.
+	holo::memory_region reader_region(config::shared_memory_name, holo::memory_region::flag_shared_memory);
+	BOOST_REQUIRE(reader_region.grow(offset + sizeof(counters)) != nullptr);
+
+	const counters* reader_counters = (const counters*)reader_region.get_pointer(offset);
+	BOOST_REQUIRE(reader_counters != writer_counters);
+	BOOST_REQUIRE(reader_counters->frame_count == 60);
+
+	++writer_counters->entity_count;
+	BOOST_REQUIRE(reader_counters->entity_count == 1025);
+
+	BOOST_REQUIRE(holo::memory_region::remove_shared_memory(config::shared_memory_name));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,221 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include <boost/test/unit_test.hpp>
+#include "core/platform.hpp"
+#include "core/math/util.hpp"
+#include "core/memory/memory_arena_pool.hpp"
+#include "core/threading/thread.hpp"
+
+namespace config
+{
+	// Deliberately not a power of two.
+	const static std::size_t arena_size_hint = 0x6000u;
+	const static std::size_t arena_count = 8;
+
+	// Number of threads sharing a single arena pool.
+	const static std::size_t shared_thread_count = 4;
+
+	// Number of times each thread takes and gives back its arenas.
+	const static std::size_t shared_round_count = 2000;
+}
+
+namespace
+{
+	holo::thread_return_status take_and_give_arenas(void* userdata)
+	{
+		holo::memory_arena_pool* arena_pool = (holo::memory_arena_pool*)userdata;
+		holo::memory_arena_pool::arena_record* records[2];
+		bool success = true;
+
+		for (std::size_t i = 0; i < config::shared_round_count; ++i)
+		{
+			records[0] = arena_pool->take_arena();
+			records[1] = arena_pool->take_arena();
+
+			// Each thread writes its own mark to the arenas it holds; seeing
+			// another thread's mark means an arena was handed out twice.
+			for (std::size_t j = 0; j < 2; ++j)
+			{
+				if (records[j] == nullptr)
+				{
+					success = false;
+					continue;
+				}
+
+				records[j]->allocator = (holo::allocator*)&records;
+				*(void**)records[j]->base = &records;
+			}
+
+			for (std::size_t j = 0; j < 2; ++j)
+			{
+				if (records[j] == nullptr)
+					continue;
+
+				if (records[j]->allocator != (holo::allocator*)&records ||
+					*(void**)records[j]->base != &records)
+				{
+					success = false;
+				}
+
+				arena_pool->give_arena(records[j]);
+			}
+		}
+
+		return success ? holo::thread_return_status_ok : 1;
+	}
+}
+
+struct memory_arena_pool_test
+{
+	memory_arena_pool_test();
+	~memory_arena_pool_test();
+
+	holo::memory_arena_pool arena_pool;
+};
+
+memory_arena_pool_test::memory_arena_pool_test() :
+	arena_pool(config::arena_size_hint, config::arena_count)
+{
+	// Nothing.
+}
+
+memory_arena_pool_test::~memory_arena_pool_test()
+{
+	// Nothing.
+}
+
+BOOST_FIXTURE_TEST_SUITE(memory_arena_pool_test_suite, memory_arena_pool_test)
+
+BOOST_AUTO_TEST_CASE(arena_size_power_of_two)
+{
+	BOOST_REQUIRE(holo::math::is_power_of_two(arena_pool.get_arena_size()));
+	BOOST_REQUIRE(arena_pool.get_arena_size() >= config::arena_size_hint);
+}
+
+BOOST_AUTO_TEST_CASE(arena_lookup)
+{
+	holo::memory_arena_pool::arena_record* first = arena_pool.take_arena();
+	holo::memory_arena_pool::arena_record* second = arena_pool.take_arena();
+
+	BOOST_REQUIRE(first != nullptr && second != nullptr);
+	BOOST_REQUIRE(first != second);
+	BOOST_REQUIRE(arena_pool.get_arena_count() == 2);
+
+	// Arenas are aligned on their size.
+	std::size_t mask = arena_pool.get_arena_size() - 1;
+	BOOST_REQUIRE(((holo::unsigned_pointer)first->base & mask) == 0);
+
+	// Any pointer inside an arena should map back to it.
+	char* base = (char*)second->base;
+	BOOST_REQUIRE(arena_pool.get_arena(base) == second);
+	BOOST_REQUIRE(arena_pool.get_arena(base + arena_pool.get_arena_size() - 1) == second);
+	BOOST_REQUIRE(arena_pool.get_arena(first->base) == first);
+
+	// ...while pointers outside of the allocated arenas should not.
+	BOOST_REQUIRE(arena_pool.get_arena((char*)first->base - 1) == nullptr);
+	BOOST_REQUIRE(arena_pool.get_arena(&mask) == nullptr);
+
+	arena_pool.give_arena(second);
+	arena_pool.give_arena(first);
+
+	// Returned arenas are reused before new ones are allocated.
+	BOOST_REQUIRE(arena_pool.take_arena() == first);
+	BOOST_REQUIRE(arena_pool.take_arena() == second);
+	BOOST_REQUIRE(arena_pool.get_arena_count() == 2);
+}
+
+BOOST_AUTO_TEST_CASE(huge_page_arenas)
+{
+	holo::memory_arena_pool huge_arena_pool(
+		config::arena_size_hint,
+		config::arena_count,
+		holo::memory_arena_pool::flag_huge_pages);
+
+	holo::memory_arena_pool::arena_record* record = huge_arena_pool.take_arena();
+	BOOST_REQUIRE(record != nullptr);
+
+	// The span of arenas begins on a huge page boundary.
+	std::size_t huge_page_mask = holo::memory_region::get_huge_page_size() - 1;
+	BOOST_REQUIRE(((holo::unsigned_pointer)record->base & huge_page_mask) == 0);
+
+	// The entire committed huge page should be usable.
+	char* base = (char*)record->base;
+	base[huge_page_mask] = 1;
+	BOOST_REQUIRE(huge_arena_pool.get_arena(base) == record);
+}
+
+BOOST_AUTO_TEST_CASE(scavenging)
+{
+	const std::size_t idle_ticks = 2;
+	const std::size_t free_arena_watermark = 1;
+	holo::memory_arena_pool::arena_record* records[config::arena_count];
+
+	arena_pool.set_scavenge_policy(idle_ticks, free_arena_watermark);
+
+	for (std::size_t i = 0; i < config::arena_count; ++i)
+	{
+		records[i] = arena_pool.take_arena();
+		BOOST_REQUIRE(records[i] != nullptr);
+	}
+
+	// Arenas in use are never scavenged.
+	BOOST_REQUIRE(arena_pool.scavenge() == 0);
+
+	for (std::size_t i = 0; i < config::arena_count; ++i)
+	{
+		arena_pool.give_arena(records[i]);
+	}
+
+	// None of the arenas are idle yet, but only the watermark is kept.
+	BOOST_REQUIRE(arena_pool.scavenge() == config::arena_count - free_arena_watermark);
+	BOOST_REQUIRE(arena_pool.get_decommitted_arena_count() == config::arena_count - free_arena_watermark);
+
+	// The last arena is decommitted once it has been idle long enough.
+	BOOST_REQUIRE(arena_pool.scavenge() == 1);
+	BOOST_REQUIRE(arena_pool.get_decommitted_arena_count() == config::arena_count);
+
+	// Taking the arenas commits them again, without allocating new ones.
+	for (std::size_t i = 0; i < config::arena_count; ++i)
+	{
+		records[i] = arena_pool.take_arena();
+		BOOST_REQUIRE(records[i] != nullptr);
+
+		char* base = (char*)records[i]->base;
+		base[0] = 1;
+		base[arena_pool.get_arena_size() - 1] = 1;
+	}
+
+	BOOST_REQUIRE(arena_pool.get_decommitted_arena_count() == 0);
+	BOOST_REQUIRE(arena_pool.get_arena_count() == config::arena_count);
+}
+
+BOOST_AUTO_TEST_CASE(shared_between_threads)
+{
+	// Every thread holds at most two arenas at once, so the pool never needs
+	// more than this many.
+	holo::memory_arena_pool shared_arena_pool(
+		config::arena_size_hint,
+		config::shared_thread_count * 2);
+	holo::thread threads[config::shared_thread_count];
+
+	for (std::size_t i = 0; i < config::shared_thread_count; ++i)
+	{
+		threads[i].start(&take_and_give_arenas, &shared_arena_pool);
+	}
+
+	for (std::size_t i = 0; i < config::shared_thread_count; ++i)
+	{
+		BOOST_REQUIRE(threads[i].join() == holo::thread_return_status_ok);
+	}
+
+	BOOST_REQUIRE(shared_arena_pool.get_arena_count() <= config::shared_thread_count * 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,293 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include "core/io/memory_stream.hpp"
+#include "core/math/util.hpp"
+#include "core/memory/memory_region.hpp"
+
+namespace config
+{
+	const static std::size_t region_size = 0x100000u;
+	const static std::size_t snapshot_buffer_size = 0x40000u;
+	const static char* mapped_file_path = "test_memory_region_mapped_file.bin";
+	const static char* shared_memory_name = "/hologine_test_memory_region";
+}
+
+struct memory_region_test
+{
+	memory_region_test();
+	~memory_region_test();
+
+	holo::memory_region region;
+};
+
+memory_region_test::memory_region_test() :
+	region(config::region_size)
+{
+	// Nothing.
+}
+
+memory_region_test::~memory_region_test()
+{
+	// Nothing.
+}
+
+BOOST_FIXTURE_TEST_SUITE(memory_region_test_suite, memory_region_test)
+
+BOOST_AUTO_TEST_CASE(page_size_valid)
+{
+	std::size_t page_size = holo::memory_region::get_page_size();
+
+	BOOST_REQUIRE(holo::math::is_power_of_two(page_size));
+	BOOST_REQUIRE(holo::memory_region::get_granularity() >= page_size);
+	BOOST_REQUIRE(holo::memory_region::get_minimum_size(1) >= page_size);
+}
+
+BOOST_AUTO_TEST_CASE(growing)
+{
+	std::size_t page_size = holo::memory_region::get_page_size();
+
+	// Nothing should be committed until the region grows.
+	BOOST_REQUIRE(region.get_current_size() == 0);
+	BOOST_REQUIRE(region.get_reserved_size() >= config::region_size);
+
+	char* base = (char*)region.grow(1);
+	BOOST_REQUIRE(base != nullptr);
+	BOOST_REQUIRE(region.get_current_size() == page_size);
+
+	// Growing within the committed page should not commit more pages, and should
+	// return the same base.
+	BOOST_REQUIRE(region.grow(page_size - 1) == base);
+	BOOST_REQUIRE(region.get_current_size() == page_size);
+
+	BOOST_REQUIRE(region.grow(1) == base);
+	BOOST_REQUIRE(region.get_current_size() == page_size * 2);
+
+	// Committed memory must be usable.
+	std::memset(base, 0xcd, page_size * 2);
+	BOOST_REQUIRE(base[page_size * 2 - 1] == (char)0xcd);
+}
+
+BOOST_AUTO_TEST_CASE(claiming)
+{
+	char* base = (char*)region.claim();
+	BOOST_REQUIRE(base != nullptr);
+	BOOST_REQUIRE(region.get_current_size() == region.get_reserved_size());
+
+	// The region is exhausted.
+	BOOST_REQUIRE(region.grow(1) == nullptr);
+	BOOST_REQUIRE(region.claim() == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(resetting)
+{
+	char* base = (char*)region.grow(0x1000u);
+	BOOST_REQUIRE(base != nullptr);
+	base[0] = 1;
+
+	// Resetting without releasing keeps the reservation; recommitted pages must
+	// be zeroed, just like freshly committed pages.
+	region.reset(false);
+	BOOST_REQUIRE(region.get_current_size() == 0);
+	BOOST_REQUIRE(region.grow(0x1000u) == base);
+	BOOST_REQUIRE(base[0] == 0);
+
+	region.reset(true);
+	BOOST_REQUIRE(region.get_current_size() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(shrinking)
+{
+	std::size_t page_size = holo::memory_region::get_page_size();
+
+	char* base = (char*)region.grow(page_size * 3);
+	BOOST_REQUIRE(base != nullptr);
+	base[0] = 1;
+	base[page_size * 2] = 1;
+
+	// Shrinking within a page keeps it committed.
+	region.shrink(page_size / 2);
+	BOOST_REQUIRE(region.get_current_size() == page_size * 3);
+	BOOST_REQUIRE(base[page_size * 2] == 1);
+
+	// Shrinking past a page decommits it; growing again brings it back zeroed.
+	region.shrink(page_size * 2);
+	BOOST_REQUIRE(region.get_current_size() == page_size);
+	BOOST_REQUIRE(base[0] == 1);
+
+	BOOST_REQUIRE(region.grow(page_size * 2) == base);
+	BOOST_REQUIRE(base[page_size * 2] == 0);
+}
+
+BOOST_AUTO_TEST_CASE(incremental_snapshots)
+{
+	std::size_t page_size = holo::memory_region::get_page_size();
+	holo::memory_region tracked_region(config::region_size, holo::memory_region::flag_track_dirty_pages);
+	holo::memory_region restored_region(config::region_size);
+
+	char* base = (char*)tracked_region.grow(page_size * 8);
+	BOOST_REQUIRE(base != nullptr);
+	std::memset(base, 0x11, page_size * 8);
+
+	// The first snapshot holds every committed page.
+	static std::uint8_t buffer[config::snapshot_buffer_size];
+	BOOST_REQUIRE(tracked_region.get_dirty_size() == page_size * 8);
+	{
+		holo::memory_stream stream(buffer, sizeof(buffer));
+		BOOST_REQUIRE(tracked_region.write_snapshot(&stream));
+		BOOST_REQUIRE(stream.get_position() > page_size * 8);
+	}
+	BOOST_REQUIRE(tracked_region.get_dirty_size() == 0);
+	{
+		holo::memory_stream stream(buffer, sizeof(buffer));
+		BOOST_REQUIRE(restored_region.read_snapshot(&stream));
+	}
+
+	// Writes to clean pages are caught.
+	base[page_size * 2 + 5] = 0x22;
+	base[page_size * 6] = 0x33;
+	BOOST_REQUIRE(!tracked_region.is_page_dirty(0));
+	BOOST_REQUIRE(tracked_region.is_page_dirty(page_size * 2));
+	BOOST_REQUIRE(tracked_region.is_page_dirty(page_size * 6));
+	BOOST_REQUIRE(tracked_region.get_dirty_size() == page_size * 2);
+
+	// Only those pages (plus the new one) go into the next snapshot.
+	BOOST_REQUIRE(tracked_region.grow(page_size) != nullptr);
+	base[page_size * 8] = 0x44;
+	{
+		holo::memory_stream stream(buffer, sizeof(buffer));
+		BOOST_REQUIRE(tracked_region.write_snapshot(&stream));
+		BOOST_REQUIRE(stream.get_position() < page_size * 4);
+	}
+	{
+		holo::memory_stream stream(buffer, sizeof(buffer));
+		BOOST_REQUIRE(restored_region.read_snapshot(&stream));
+	}
+
+	char* restored_base = (char*)restored_region.grow(0);
+	BOOST_REQUIRE(restored_region.get_current_size() == page_size * 9);
+	BOOST_REQUIRE(std::memcmp(restored_base, base, page_size * 9) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(mapping_files)
+{
+	std::size_t page_size = holo::memory_region::get_page_size();
+	std::size_t file_size = page_size * 3 + 0x10u;
+
+	std::FILE* file = std::fopen(config::mapped_file_path, "wb");
+	BOOST_REQUIRE(file != nullptr);
+	for (std::size_t i = 0; i < file_size; ++i)
+	{
+		std::fputc((int)(i % 0xfb), file);
+	}
+	std::fclose(file);
+
+	{
+		holo::memory_region mapped_region(config::mapped_file_path, holo::memory_region::flag_populate_pages);
+		BOOST_REQUIRE(mapped_region.is_file_backed());
+		BOOST_REQUIRE(mapped_region.get_file_size() == file_size);
+
+		// The file is mapped page by page as the region grows.
+		unsigned char* base = (unsigned char*)mapped_region.grow(page_size);
+		BOOST_REQUIRE(base != nullptr);
+		BOOST_REQUIRE(base[page_size - 1] == (page_size - 1) % 0xfb);
+
+		BOOST_REQUIRE(mapped_region.claim() == base);
+		BOOST_REQUIRE(mapped_region.get_current_size() == page_size * 4);
+		mapped_region.prefetch(0, file_size);
+
+		BOOST_REQUIRE(base[file_size - 1] == (file_size - 1) % 0xfb);
+		BOOST_REQUIRE(base[file_size] == 0);
+	}
+
+	{
+		holo::memory_region copied_region(config::mapped_file_path, holo::memory_region::flag_copy_on_write);
+		unsigned char* base = (unsigned char*)copied_region.claim();
+		BOOST_REQUIRE(base != nullptr);
+
+		std::memset(base, 0xcd, page_size * 2);
+		BOOST_REQUIRE(base[page_size] == 0xcd);
+
+		// Decommitting drops the private copies.
+		copied_region.reset(false);
+		BOOST_REQUIRE(copied_region.grow(file_size) == base);
+		BOOST_REQUIRE(base[page_size] == page_size % 0xfb);
+	}
+
+	// The file itself is untouched.
+	file = std::fopen(config::mapped_file_path, "rb");
+	BOOST_REQUIRE(file != nullptr);
+	BOOST_REQUIRE(std::fgetc(file) == 0);
+	std::fclose(file);
+
+	std::remove(config::mapped_file_path);
+
+	holo::memory_region missing_region(config::mapped_file_path);
+	BOOST_REQUIRE(!missing_region.is_file_backed());
+	BOOST_REQUIRE(missing_region.grow(0) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(sharing_memory)
+{
+	std::size_t page_size = holo::memory_region::get_page_size();
+
+	// A failed run may have left the name behind.
+	holo::memory_region::remove_shared_memory(config::shared_memory_name);
+
+	{
+		holo::memory_region created_region(
+			holo::memory_region::create_shared_memory(config::shared_memory_name, page_size * 2 + 1));
+		BOOST_REQUIRE(created_region.is_shared_memory());
+		BOOST_REQUIRE(created_region.get_reserved_size() == page_size * 3);
+
+		// The name is taken as long as the object exists.
+		holo::memory_region duplicate_region(
+			holo::memory_region::create_shared_memory(config::shared_memory_name, page_size));
+		BOOST_REQUIRE(!duplicate_region.is_shared_memory());
+
+		unsigned char* writer_base = (unsigned char*)created_region.claim();
+		BOOST_REQUIRE(writer_base != nullptr);
+
+		holo::memory_region reader_region(config::shared_memory_name, holo::memory_region::flag_shared_memory);
+		BOOST_REQUIRE(reader_region.is_shared_memory());
+		BOOST_REQUIRE(reader_region.get_file_size() == page_size * 3);
+
+		unsigned char* reader_base = (unsigned char*)reader_region.claim();
+		BOOST_REQUIRE(reader_base != nullptr);
+		BOOST_REQUIRE(reader_base != writer_base);
+
+		// Writes show up in the other mapping without copying anything, at the
+		// same offset.
+		writer_base[page_size + 0x10] = 0xab;
+		std::size_t offset = created_region.get_offset(writer_base + page_size + 0x10);
+		BOOST_REQUIRE(offset == page_size + 0x10);
+		BOOST_REQUIRE(*(unsigned char*)reader_region.get_pointer(offset) == 0xab);
+
+		// Decommitting only unmaps the pages; the object keeps its contents.
+		created_region.reset(false);
+		BOOST_REQUIRE(created_region.grow(page_size * 2) == writer_base);
+		BOOST_REQUIRE(writer_base[page_size + 0x10] == 0xab);
+
+		BOOST_REQUIRE(holo::memory_region::remove_shared_memory(config::shared_memory_name));
+
+		// Existing mappings outlive the name.
+		writer_base[0] = 0xcd;
+		BOOST_REQUIRE(reader_base[0] == 0xcd);
+	}
+
+	holo::memory_region missing_region(config::shared_memory_name, holo::memory_region::flag_shared_memory);
+	BOOST_REQUIRE(!missing_region.is_shared_memory());
+	BOOST_REQUIRE(!holo::memory_region::remove_shared_memory(config::shared_memory_name));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,175 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include <boost/test/unit_test.hpp>
+#include "core/platform.hpp"
+#include "core/memory/memory_arena_pool.hpp"
+#include "core/memory/object_cache.hpp"
+#include "core/threading/mutex.hpp"
+
+namespace config
+{
+	const static std::size_t arena_size = 0x8000u;
+	const static std::size_t arena_count = 4;
+}
+
+namespace
+{
+	// An object with an expensive constructed state.
+	struct session
+	{
+		session();
+		~session();
+
+		holo::mutex mutex;
+		unsigned char buffer[0x100];
+		bool in_use;
+
+		static std::size_t construct_count;
+		static std::size_t destruct_count;
+	};
+
+	std::size_t session::construct_count = 0;
+	std::size_t session::destruct_count = 0;
+
+	session::session() :
+		in_use(false)
+	{
+		for (std::size_t i = 0; i < sizeof(buffer); ++i)
+		{
+			buffer[i] = (unsigned char)i;
+		}
+
+		++construct_count;
+	}
+
+	session::~session()
+	{
+		++destruct_count;
+	}
+}
+
+struct object_cache_test
+{
+	object_cache_test();
+	~object_cache_test();
+
+	holo::memory_arena_pool arena_pool;
+	holo::typed_object_cache<session> cache;
+};
+
+object_cache_test::object_cache_test() :
+	arena_pool(config::arena_size, config::arena_count),
+	cache(&arena_pool)
+{
+	session::construct_count = 0;
+	session::destruct_count = 0;
+}
+
+object_cache_test::~object_cache_test()
+{
+	// Nothing.
+}
+
+BOOST_FIXTURE_TEST_SUITE(object_cache_test_suite, object_cache_test)
+
+BOOST_AUTO_TEST_CASE(reusing_constructed_objects)
+{
+	session* object = cache.allocate();
+	BOOST_REQUIRE(object != nullptr);
+	BOOST_REQUIRE(session::construct_count == 1);
+	BOOST_REQUIRE(object->buffer[0x10] == 0x10);
+
+	object->in_use = true;
+	object->in_use = false;
+	cache.deallocate(object);
+
+	// The freed object comes back without being constructed again.
+	BOOST_REQUIRE(cache.allocate() == object);
+	BOOST_REQUIRE(session::construct_count == 1);
+	BOOST_REQUIRE(session::destruct_count == 0);
+	BOOST_REQUIRE(object->buffer[0xff] == 0xff);
+
+	cache.deallocate(object);
+
+	holo::object_cache::statistics statistics;
+	cache.get_statistics(&statistics);
+	BOOST_REQUIRE(statistics.arena_count == 1);
+	BOOST_REQUIRE(statistics.cached_objects == 1);
+	BOOST_REQUIRE(statistics.construct_count == 1);
+	BOOST_REQUIRE(statistics.destruct_count == 0);
+	BOOST_REQUIRE(statistics.allocations.committed_bytes == arena_pool.get_arena_size());
+}
+
+BOOST_AUTO_TEST_CASE(filling_arenas)
+{
+	std::size_t object_count = cache.get_object_count();
+	BOOST_REQUIRE(object_count > 1);
+
+	const std::size_t total_count = object_count * 2 + 1;
+	session* objects[0x100];
+	BOOST_REQUIRE(total_count <= 0x100);
+
+	cache.set_statistics_enabled(true);
+
+	for (std::size_t i = 0; i < total_count; ++i)
+	{
+		objects[i] = cache.allocate();
+		BOOST_REQUIRE(objects[i] != nullptr);
+		BOOST_REQUIRE(!objects[i]->in_use);
+
+		objects[i]->in_use = true;
+	}
+
+	holo::object_cache::statistics statistics;
+	cache.get_statistics(&statistics);
+	BOOST_REQUIRE(statistics.arena_count == 3);
+	BOOST_REQUIRE(statistics.allocations.live_objects == total_count);
+	BOOST_REQUIRE(session::construct_count == total_count);
+
+	// Reaping keeps arenas with live objects.
+	objects[0]->in_use = false;
+	cache.deallocate(objects[0]);
+	BOOST_REQUIRE(cache.reap() == 0);
+
+	for (std::size_t i = 1; i < total_count; ++i)
+	{
+		objects[i]->in_use = false;
+		cache.deallocate(objects[i]);
+	}
+
+	BOOST_REQUIRE(session::destruct_count == 0);
+
+	// Now every arena is empty; reaping destroys the cached objects.
+	BOOST_REQUIRE(cache.reap() == 3);
+	BOOST_REQUIRE(session::destruct_count == total_count);
+
+	cache.get_statistics(&statistics);
+	BOOST_REQUIRE(statistics.arena_count == 0);
+	BOOST_REQUIRE(statistics.cached_objects == 0);
+	BOOST_REQUIRE(statistics.destruct_count == total_count);
+	BOOST_REQUIRE(statistics.allocations.live_objects == 0);
+	BOOST_REQUIRE(statistics.allocations.committed_bytes == 0);
+}
+
+BOOST_AUTO_TEST_CASE(destroying_cache)
+{
+	{
+		holo::typed_object_cache<session> local_cache(&arena_pool);
+
+		session* object = local_cache.allocate();
+		BOOST_REQUIRE(object != nullptr);
+		local_cache.deallocate(object);
+	}
+
+	BOOST_REQUIRE(session::construct_count == 1);
+	BOOST_REQUIRE(session::destruct_count == 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
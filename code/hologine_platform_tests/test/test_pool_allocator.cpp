@@ -8,14 +8,40 @@
 // For licensing information, review the LICENSE file located at the root
 // directory of the source package.
 #include <boost/test/unit_test.hpp>
+#include <algorithm>
 #include "core/memory/memory_arena_pool.hpp"
 #include "core/memory/pool_allocator.hpp"
+#include "core/threading/thread.hpp"
 
 namespace config
 {
 	const static std::size_t arena_size = 0x8000u;
 	const static std::size_t arena_count = 4;
 	const static std::size_t pool_object_size = 0x200u;
+
+	// Number of objects freed by another thread.
+	const static std::size_t remote_object_count = 0x60u;
+}
+
+namespace
+{
+	struct remote_objects
+	{
+		holo::pool_allocator* allocator;
+		void* objects[config::remote_object_count];
+	};
+
+	holo::thread_return_status deallocate_remote_objects(void* userdata)
+	{
+		remote_objects* remote = (remote_objects*)userdata;
+
+		for (std::size_t i = 0; i < config::remote_object_count; ++i)
+		{
+			remote->allocator->deallocate_remote(remote->objects[i]);
+		}
+
+		return holo::thread_return_status_ok;
+	}
 }
 
 struct pool_allocator_test
@@ -91,4 +117,125 @@ BOOST_AUTO_TEST_CASE(requesting_new_memory_region)
 	BOOST_REQUIRE(arena_pool.get_arena_count() == 2);
 }
 
+BOOST_AUTO_TEST_CASE(batch_allocation_deallocation)
+{
+	// Span more than one arena.
+	std::size_t count = allocator.get_object_count() + allocator.get_object_count() / 2;
+	void* pointers[0x100];
+	BOOST_REQUIRE(count <= sizeof(pointers) / sizeof(void*));
+
+	BOOST_REQUIRE(allocator.allocate_batch(config::pool_object_size, count, pointers) == count);
+	BOOST_REQUIRE(arena_pool.get_arena_count() == 2);
+
+	// Every object should be distinct and belong to the allocator.
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		holo::memory_arena_pool::arena_record* record = arena_pool.get_arena(pointers[i]);
+		BOOST_REQUIRE(record != nullptr && record->allocator == &allocator);
+
+		*(std::size_t*)pointers[i] = i;
+	}
+
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		BOOST_REQUIRE(*(std::size_t*)pointers[i] == i);
+	}
+
+	// Recently freed objects are reused by the next batch.
+	allocator.deallocate_batch(pointers + count - 2, 2);
+	void* reused[2];
+	BOOST_REQUIRE(allocator.allocate_batch(1, 2, reused) == 2);
+	BOOST_REQUIRE(reused[0] != reused[1]);
+	BOOST_REQUIRE(reused[0] == pointers[count - 2] || reused[0] == pointers[count - 1]);
+	BOOST_REQUIRE(reused[1] == pointers[count - 2] || reused[1] == pointers[count - 1]);
+
+	// Freeing everything returns the arenas.
+	allocator.deallocate_batch(reused, 2);
+	allocator.deallocate(pointers[0]);
+	allocator.deallocate_batch(pointers + 1, count - 3);
+
+	holo::memory_arena_pool::arena_record* record = arena_pool.take_arena();
+	BOOST_REQUIRE(record != nullptr && record->allocator == nullptr);
+	BOOST_REQUIRE(arena_pool.get_arena_count() == 2);
+}
+
+BOOST_AUTO_TEST_CASE(sized_deallocation)
+{
+	void* pointer = allocator.allocate(0x100u);
+	BOOST_REQUIRE(pointer != nullptr);
+
+	// The entire object is usable, even past the requested size.
+	BOOST_REQUIRE(allocator.get_usable_size(pointer) == allocator.get_object_size());
+	BOOST_REQUIRE(allocator.get_usable_size((char*)pointer + 0x10u) == allocator.get_object_size() - 0x10u);
+
+	allocator.deallocate(pointer, 0x100u);
+
+	// Freeing the only object returns the arena to the pool.
+	holo::memory_arena_pool::arena_record* record = arena_pool.take_arena();
+	BOOST_REQUIRE(record != nullptr && record->allocator == nullptr);
+	BOOST_REQUIRE(arena_pool.get_arena_count() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(remote_deallocation)
+{
+	remote_objects remote;
+	remote.allocator = &allocator;
+	BOOST_REQUIRE(allocator.allocate_batch(1, config::remote_object_count, remote.objects) == config::remote_object_count);
+
+	// Keep allocating on this thread while the objects are freed on another.
+	holo::thread thread;
+	thread.start(&deallocate_remote_objects, &remote);
+
+	void* local_objects[config::remote_object_count];
+	for (std::size_t i = 0; i < config::remote_object_count; ++i)
+	{
+		local_objects[i] = allocator.allocate(1);
+		BOOST_REQUIRE(local_objects[i] != nullptr);
+	}
+
+	BOOST_REQUIRE(thread.join() == holo::thread_return_status_ok);
+
+	allocator.collect_remote_objects();
+	BOOST_REQUIRE(allocator.collect_remote_objects() == 0);
+
+	// Every remote object was reclaimed, so freeing the local objects empties
+	// the pool.
+	allocator.deallocate_batch(local_objects, config::remote_object_count);
+
+	holo::memory_arena_pool::statistics statistics;
+	arena_pool.get_statistics(&statistics);
+	BOOST_REQUIRE(statistics.arenas_in_use == 0);
+}
+
+BOOST_AUTO_TEST_CASE(iterating_live_objects)
+{
+	std::size_t count = allocator.get_object_count() + 2;
+	void* pointers[0x100];
+	BOOST_REQUIRE(count <= sizeof(pointers) / sizeof(void*));
+	BOOST_REQUIRE(allocator.allocate_batch(1, count, pointers) == count);
+
+	// Free every other object.
+	for (std::size_t i = 0; i < count; i += 2)
+	{
+		allocator.deallocate(pointers[i]);
+	}
+
+	// Live objects are visited in address order, across arenas.
+	std::size_t live_count = 0;
+	void* previous = nullptr;
+	for (holo::pool_allocator::object_iterator i = allocator.begin(); i != allocator.end(); ++i)
+	{
+		BOOST_REQUIRE(*i > previous);
+		BOOST_REQUIRE(arena_pool.get_arena(*i)->allocator == &allocator);
+
+		previous = *i;
+		++live_count;
+	}
+	BOOST_REQUIRE(live_count == count / 2);
+
+	// The lowest free object is reused first.
+	void* lowest = std::min(pointers[0], pointers[count - 2]);
+	BOOST_REQUIRE(allocator.allocate(1) == lowest);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
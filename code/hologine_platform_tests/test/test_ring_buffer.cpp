@@ -0,0 +1,137 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include <cstring>
+#include "core/io/binary_reader.hpp"
+#include "core/io/binary_writer.hpp"
+#include "core/io/endianness.hpp"
+#include "core/io/ring_buffer.hpp"
+#include "core/io/ring_buffer_stream.hpp"
+
+namespace config
+{
+	const static std::size_t buffer_capacity = 0x1000u;
+	const static std::size_t wrap_offset = 0x20u;
+	const static std::size_t wrap_size = 0x40u;
+}
+
+struct ring_buffer_test
+{
+	ring_buffer_test();
+	~ring_buffer_test();
+
+	holo::ring_buffer buffer;
+};
+
+ring_buffer_test::ring_buffer_test() :
+	buffer(config::buffer_capacity)
+{
+	// Nothing.
+}
+
+ring_buffer_test::~ring_buffer_test()
+{
+	// Nothing.
+}
+
+BOOST_FIXTURE_TEST_SUITE(ring_buffer_test_suite, ring_buffer_test)
+
+BOOST_AUTO_TEST_CASE(creating)
+{
+	BOOST_REQUIRE(buffer.get_capacity() >= config::buffer_capacity);
+	BOOST_REQUIRE(buffer.get_readable_size() == 0);
+	BOOST_REQUIRE(buffer.get_writable_size() == buffer.get_capacity());
+}
+
+BOOST_AUTO_TEST_CASE(filling)
+{
+	std::uint8_t value = 0xaa;
+	std::size_t written = 0;
+	while (buffer.write(&value, 1) == 1)
+	{
+		++written;
+	}
+
+	BOOST_REQUIRE(written == buffer.get_capacity());
+	BOOST_REQUIRE(buffer.get_writable_size() == 0);
+	BOOST_REQUIRE(buffer.get_readable_size() == buffer.get_capacity());
+}
+
+BOOST_AUTO_TEST_CASE(wrapping_around)
+{
+	// Move the positions close to the end, so the next write wraps around.
+	std::size_t lead = buffer.get_capacity() - config::wrap_offset;
+	std::size_t size;
+	buffer.begin_write(&size);
+	buffer.end_write(lead);
+	buffer.skip(lead);
+
+	std::uint8_t data[config::wrap_size];
+	for (std::size_t i = 0; i < config::wrap_size; ++i)
+	{
+		data[i] = (std::uint8_t)i;
+	}
+
+	// The writable span is contiguous through the wraparound.
+	std::uint8_t* span = buffer.begin_write(&size);
+	BOOST_REQUIRE(size == buffer.get_capacity());
+	std::memcpy(span, data, config::wrap_size);
+	buffer.end_write(config::wrap_size);
+
+	// The mirror maps the wrapped bytes to the beginning of the buffer.
+	std::uint8_t* base = span - lead;
+	BOOST_REQUIRE(std::memcmp(base, data + config::wrap_offset, config::wrap_size - config::wrap_offset) == 0);
+
+	const std::uint8_t* readable = buffer.begin_read(&size);
+	BOOST_REQUIRE(readable == span);
+	BOOST_REQUIRE(size == config::wrap_size);
+	buffer.end_read(size);
+
+	std::uint8_t result[config::wrap_size];
+	BOOST_REQUIRE(buffer.write(data, config::wrap_size) == config::wrap_size);
+	BOOST_REQUIRE(buffer.read(result, config::wrap_size) == config::wrap_size);
+	BOOST_REQUIRE(std::memcmp(result, data, config::wrap_size) == 0);
+	BOOST_REQUIRE(buffer.get_read_position() == lead + 2 * config::wrap_size);
+	BOOST_REQUIRE(buffer.get_readable_size() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(streaming)
+{
+	holo::ring_buffer_stream producer(&buffer, false, true);
+	holo::ring_buffer_stream consumer(&buffer, true, false);
+	holo::binary_writer writer(&producer, holo::endianness::little);
+	holo::binary_reader reader(&consumer, holo::endianness::little);
+
+	std::uint32_t count = (std::uint32_t)(buffer.get_capacity() / sizeof(std::uint32_t));
+	for (std::uint32_t i = 0; i < count * 3; ++i)
+	{
+		BOOST_REQUIRE(writer.write_uint(i));
+
+		std::uint32_t value;
+		BOOST_REQUIRE(reader.read_uint(value));
+		BOOST_REQUIRE(value == i);
+	}
+
+	BOOST_REQUIRE(producer.get_position() == count * 3 * sizeof(std::uint32_t));
+	BOOST_REQUIRE(consumer.get_position() == producer.get_position());
+
+	std::uint8_t byte = 0;
+	BOOST_REQUIRE(consumer.write(&byte, 1) == 0);
+	BOOST_REQUIRE(producer.read(&byte, 1) == 0);
+	BOOST_REQUIRE(!producer.seek(0, holo::seek_flags::forward_relative));
+
+	BOOST_REQUIRE(writer.write_uint(0xdeadbeef));
+	BOOST_REQUIRE(consumer.seek(sizeof(std::uint32_t), holo::seek_flags::forward_relative));
+	BOOST_REQUIRE(!consumer.seek(1, holo::seek_flags::forward_relative));
+	BOOST_REQUIRE(!consumer.seek(0, holo::seek_flags::absolute));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,232 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include <boost/test/unit_test.hpp>
+#include <map>
+#include <vector>
+#include "core/platform.hpp"
+#include "core/memory/heap_allocator.hpp"
+#include "core/memory/standard_allocator_proxy.hpp"
+
+#if __cplusplus >= 201703L
+#include <memory_resource>
+#include <unordered_map>
+#include "core/memory/linear_allocator.hpp"
+#include "core/memory/memory_resource_proxy.hpp"
+#endif
+
+namespace config
+{
+	const static std::size_t heap_arena_size = 0x40000u;
+	const static std::size_t heap_arena_count = 0x20u;
+	const static std::size_t heap_pool_start = 0x20u;
+	const static std::size_t heap_pool_end = 0x10000u;
+	const static std::size_t element_count = 0x1000u;
+	const static std::size_t linear_size = 0x100000u;
+}
+
+namespace
+{
+	// Forwards to another allocator, keeping track of live bytes through the
+	// sized deallocation path.
+	class counting_allocator final : public holo::allocator
+	{
+		public:
+			explicit counting_allocator(holo::allocator* allocator);
+
+			using holo::allocator::deallocate;
+
+			void* allocate(std::size_t size, std::size_t alignment = default_alignment) override;
+			void deallocate(void* pointer) override;
+			void deallocate(void* pointer, std::size_t size, std::size_t alignment = default_alignment) override;
+
+			holo::allocator* allocator;
+			std::size_t live_size;
+			std::size_t unsized_deallocation_count;
+	};
+
+	counting_allocator::counting_allocator(holo::allocator* allocator) :
+		allocator(allocator),
+		live_size(0),
+		unsized_deallocation_count(0)
+	{
+		// Nothing.
+	}
+
+	void* counting_allocator::allocate(std::size_t size, std::size_t alignment)
+	{
+		live_size += size;
+
+		return allocator->allocate(size, alignment);
+	}
+
+	void counting_allocator::deallocate(void* pointer)
+	{
+		++unsized_deallocation_count;
+
+		allocator->deallocate(pointer);
+	}
+
+	void counting_allocator::deallocate(void* pointer, std::size_t size, std::size_t alignment)
+	{
+		live_size -= size;
+
+		allocator->deallocate(pointer, size, alignment);
+	}
+
+	struct aligned_element
+	{
+		alignas(0x40) int value;
+	};
+}
+
+struct standard_allocator_proxy_test
+{
+	standard_allocator_proxy_test();
+	~standard_allocator_proxy_test();
+
+	holo::heap_allocator heap;
+	counting_allocator allocator;
+};
+
+standard_allocator_proxy_test::standard_allocator_proxy_test() :
+	heap(
+		config::heap_arena_size,
+		config::heap_arena_count,
+		config::heap_pool_start,
+		config::heap_pool_end),
+	allocator(&heap)
+{
+	// Nothing.
+}
+
+standard_allocator_proxy_test::~standard_allocator_proxy_test()
+{
+	// Nothing.
+}
+
+BOOST_FIXTURE_TEST_SUITE(standard_allocator_proxy_test_suite, standard_allocator_proxy_test)
+
+BOOST_AUTO_TEST_CASE(using_containers)
+{
+	{
+		typedef holo::standard_allocator_proxy<int> int_allocator;
+		std::vector<int, int_allocator> values((int_allocator(&allocator)));
+
+		for (std::size_t i = 0; i < config::element_count; ++i)
+		{
+			values.push_back((int)i);
+		}
+
+		typedef std::pair<const int, int> pair;
+		typedef holo::standard_allocator_proxy<pair> pair_allocator;
+		std::less<int> compare;
+		std::map<int, int, std::less<int>, pair_allocator> map(compare, pair_allocator(&allocator));
+
+		for (std::size_t i = 0; i < config::element_count; ++i)
+		{
+			map[(int)i] = values[i];
+		}
+
+		BOOST_REQUIRE(values[config::element_count - 1] == (int)config::element_count - 1);
+		BOOST_REQUIRE(map[0x10] == 0x10);
+		BOOST_REQUIRE(allocator.live_size > 0);
+
+		// Rebound proxies compare equal to the original.
+		BOOST_REQUIRE(map.get_allocator() == values.get_allocator());
+	}
+
+	// Every allocation went back through the sized path.
+	BOOST_REQUIRE(allocator.live_size == 0);
+	BOOST_REQUIRE(allocator.unsized_deallocation_count == 0);
+}
+
+BOOST_AUTO_TEST_CASE(aligning_elements)
+{
+	typedef holo::standard_allocator_proxy<aligned_element> element_allocator;
+	std::vector<aligned_element, element_allocator> elements((element_allocator(&allocator)));
+
+	elements.resize(0x10u);
+	BOOST_REQUIRE(((std::size_t)elements.data() & 0x3fu) == 0);
+}
+
+#if __cplusplus >= 201703L
+
+BOOST_AUTO_TEST_CASE(using_memory_resources)
+{
+	{
+		holo::memory_resource_proxy resource(&allocator);
+
+		std::pmr::vector<int> values(&resource);
+		for (std::size_t i = 0; i < config::element_count; ++i)
+		{
+			values.push_back((int)i);
+		}
+
+		std::pmr::unordered_map<int, int> map(&resource);
+		for (std::size_t i = 0; i < config::element_count; ++i)
+		{
+			map[(int)i] = values[i];
+		}
+
+		BOOST_REQUIRE(values[config::element_count - 1] == (int)config::element_count - 1);
+		BOOST_REQUIRE(map[0x10] == 0x10);
+		BOOST_REQUIRE(allocator.live_size > 0);
+
+		// Proxies wrapping the same allocator are interchangeable.
+		holo::memory_resource_proxy other_resource(&allocator);
+		holo::memory_resource_proxy heap_resource(&heap);
+		BOOST_REQUIRE(resource == other_resource);
+		BOOST_REQUIRE(resource != heap_resource);
+
+		// Over-aligned requests keep their alignment.
+		void* aligned = resource.allocate(0x10u, 0x40u);
+		BOOST_REQUIRE(((std::size_t)aligned & 0x3fu) == 0);
+		resource.deallocate(aligned, 0x10u, 0x40u);
+	}
+
+	// Every allocation went back through the sized path.
+	BOOST_REQUIRE(allocator.live_size == 0);
+	BOOST_REQUIRE(allocator.unsized_deallocation_count == 0);
+}
+
+BOOST_AUTO_TEST_CASE(using_linear_memory_resources)
+{
+	holo::linear_allocator linear_allocator(config::linear_size);
+	counting_allocator linear_counter(&linear_allocator);
+
+	{
+		holo::memory_resource_proxy resource(&linear_counter);
+
+		std::pmr::vector<int> values(&resource);
+		for (std::size_t i = 0; i < config::element_count; ++i)
+		{
+			values.push_back((int)i);
+		}
+
+		std::pmr::unordered_map<int, int> map(&resource);
+		for (std::size_t i = 0; i < config::element_count; ++i)
+		{
+			map[(int)i] = values[i];
+		}
+
+		BOOST_REQUIRE(map[0x10] == 0x10);
+
+		// The elements live in the linear allocator's region.
+		BOOST_REQUIRE(linear_allocator.get_offset(values.data()) < linear_allocator.get_size());
+		BOOST_REQUIRE(linear_allocator.get_offset(&map[0x10]) < linear_allocator.get_size());
+	}
+
+	BOOST_REQUIRE(linear_counter.live_size == 0);
+	BOOST_REQUIRE(linear_counter.unsized_deallocation_count == 0);
+}
+
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,154 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+#include "core/platform.hpp"
+#include "core/memory/tlsf_allocator.hpp"
+
+namespace config
+{
+	const static std::size_t allocator_size = 0x100000u;
+	const static std::size_t object_count = 0x200u;
+	const static std::size_t maximum_object_size = 0x800u;
+}
+
+struct tlsf_allocator_test
+{
+	tlsf_allocator_test();
+	~tlsf_allocator_test();
+
+	holo::tlsf_allocator allocator;
+};
+
+tlsf_allocator_test::tlsf_allocator_test() :
+	allocator(config::allocator_size)
+{
+	// Nothing.
+}
+
+tlsf_allocator_test::~tlsf_allocator_test()
+{
+	// Nothing.
+}
+
+BOOST_FIXTURE_TEST_SUITE(tlsf_allocator_test_suite, tlsf_allocator_test)
+
+BOOST_AUTO_TEST_CASE(merging_free_blocks)
+{
+	const std::size_t initial_free_size = allocator.get_free_size();
+	BOOST_REQUIRE(allocator.get_free_block_count() == 1);
+	BOOST_REQUIRE(allocator.get_committed_size() == allocator.get_size());
+
+	void* first = allocator.allocate(0x100u);
+	void* second = allocator.allocate(0x100u);
+	void* third = allocator.allocate(0x100u);
+	BOOST_REQUIRE(first != nullptr && second != nullptr && third != nullptr);
+	BOOST_REQUIRE(((holo::unsigned_pointer)first & (holo::allocator::default_alignment - 1)) == 0);
+	BOOST_REQUIRE(allocator.get_usable_size(first) == 0x100u);
+
+	// Freeing a block between two allocated blocks leaves a hole.
+	allocator.deallocate(second);
+	BOOST_REQUIRE(allocator.get_free_block_count() == 2);
+
+	// The hole is reused by a request that fits.
+	BOOST_REQUIRE(allocator.allocate(0x80u) == second);
+	allocator.deallocate(second);
+
+	// Freeing the neighbors merges everything back into a single block.
+	allocator.deallocate(first);
+	BOOST_REQUIRE(allocator.get_free_block_count() == 2);
+
+	allocator.deallocate(third);
+	BOOST_REQUIRE(allocator.get_free_block_count() == 1);
+	BOOST_REQUIRE(allocator.get_free_size() == initial_free_size);
+}
+
+BOOST_AUTO_TEST_CASE(mixed_sizes)
+{
+	void* objects[config::object_count];
+	std::size_t sizes[config::object_count];
+	const std::size_t initial_free_size = allocator.get_free_size();
+
+	std::uint32_t state = 0x9e3779b9u;
+	for (std::size_t i = 0; i < config::object_count; ++i)
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+
+		sizes[i] = 1 + state % config::maximum_object_size;
+		objects[i] = allocator.allocate(sizes[i]);
+		BOOST_REQUIRE(objects[i] != nullptr);
+		BOOST_REQUIRE(allocator.get_usable_size(objects[i]) >= sizes[i]);
+
+		std::memset(objects[i], (int)(i & 0xff), sizes[i]);
+	}
+
+	// Free every other object, then the rest, checking nothing was trampled.
+	for (std::size_t i = 0; i < config::object_count; i += 2)
+	{
+		BOOST_REQUIRE(((unsigned char*)objects[i])[sizes[i] - 1] == (i & 0xff));
+		allocator.deallocate(objects[i]);
+	}
+
+	for (std::size_t i = 1; i < config::object_count; i += 2)
+	{
+		BOOST_REQUIRE(((unsigned char*)objects[i])[0] == (i & 0xff));
+		allocator.deallocate(objects[i]);
+	}
+
+	BOOST_REQUIRE(allocator.get_free_block_count() == 1);
+	BOOST_REQUIRE(allocator.get_free_size() == initial_free_size);
+}
+
+BOOST_AUTO_TEST_CASE(aligned_allocation)
+{
+	const std::size_t alignments[] = { 0x20u, 0x40u, 0x100u, 0x1000u };
+	void* padding = allocator.allocate(0x10u);
+
+	for (std::size_t alignment : alignments)
+	{
+		void* pointer = allocator.allocate(0x30u, alignment);
+		BOOST_REQUIRE(pointer != nullptr);
+		BOOST_REQUIRE(((holo::unsigned_pointer)pointer & (alignment - 1)) == 0);
+
+		std::memset(pointer, 0xaa, 0x30u);
+		allocator.deallocate(pointer);
+	}
+
+	allocator.deallocate(padding);
+	BOOST_REQUIRE(allocator.get_free_block_count() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(committing_lazily)
+{
+	holo::tlsf_allocator lazy_allocator(
+		config::allocator_size,
+		holo::tlsf_allocator::flag_commit_lazily,
+		0x10000u);
+	BOOST_REQUIRE(lazy_allocator.get_committed_size() == 0x10000u);
+
+	// A request larger than the committed memory grows the region.
+	void* first = lazy_allocator.allocate(0x8000u);
+	void* second = lazy_allocator.allocate(0x18000u);
+	BOOST_REQUIRE(first != nullptr && second != nullptr);
+	BOOST_REQUIRE(lazy_allocator.get_committed_size() > 0x10000u);
+
+	std::memset(second, 0x55, 0x18000u);
+
+	// Nothing larger than the region fits.
+	BOOST_REQUIRE(lazy_allocator.allocate(config::allocator_size * 2) == nullptr);
+
+	lazy_allocator.deallocate(first);
+	lazy_allocator.deallocate(second);
+	BOOST_REQUIRE(lazy_allocator.get_free_block_count() == 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,142 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include "core/platform.hpp"
+#include "core/io/memory_stream.hpp"
+#include "core/memory/allocation_trace.hpp"
+#include "core/memory/heap_allocator.hpp"
+#include "core/memory/tracing_allocator_proxy.hpp"
+
+namespace config
+{
+	const static std::size_t trace_buffer_size = 0x10000u;
+	const static std::size_t object_count = 0x400u;
+	const static std::size_t batch_count = 0x10u;
+}
+
+struct tracing_allocator_proxy_test
+{
+	tracing_allocator_proxy_test();
+	~tracing_allocator_proxy_test();
+
+	holo::heap_allocator allocator;
+	std::uint8_t buffer[config::trace_buffer_size];
+};
+
+tracing_allocator_proxy_test::tracing_allocator_proxy_test()
+{
+	// Nothing.
+}
+
+tracing_allocator_proxy_test::~tracing_allocator_proxy_test()
+{
+	// Nothing.
+}
+
+BOOST_FIXTURE_TEST_SUITE(tracing_allocator_proxy_test_suite, tracing_allocator_proxy_test)
+
+BOOST_AUTO_TEST_CASE(recording_and_reading)
+{
+	static void* objects[config::object_count];
+	void* batch[config::batch_count];
+
+	holo::memory_stream output(buffer, config::trace_buffer_size, false, true);
+	{
+		holo::tracing_allocator_proxy proxy(&allocator, &output);
+
+		for (std::size_t i = 0; i < config::object_count; ++i)
+		{
+			objects[i] = proxy.allocate(i + 1, (std::size_t)8 << (i % 4));
+			BOOST_REQUIRE(objects[i] != nullptr);
+		}
+
+		BOOST_REQUIRE(proxy.allocate_batch(0x20, config::batch_count, batch) == config::batch_count);
+		proxy.deallocate_batch(batch, config::batch_count);
+
+		for (std::size_t i = 0; i < config::object_count; i += 2)
+		{
+			proxy.deallocate(objects[i]);
+			proxy.deallocate(objects[i + 1], i + 2, (std::size_t)8 << ((i + 1) % 4));
+		}
+
+		BOOST_REQUIRE(proxy.get_event_count() == config::object_count * 2 + config::batch_count * 2);
+	}
+
+	// The trace is far smaller than the events themselves.
+	std::uint64_t trace_size = output.get_position();
+	std::size_t event_count = (config::object_count + config::batch_count) * 2;
+	BOOST_REQUIRE(trace_size < event_count * sizeof(holo::allocation_event) / 2);
+
+	holo::memory_stream input(buffer, trace_size, true, false);
+	holo::allocation_trace_reader reader(&input);
+	BOOST_REQUIRE(reader.is_valid());
+
+	holo::allocation_event event;
+	std::uint64_t previous_timestamp = 0;
+	for (std::size_t i = 0; i < config::object_count; ++i)
+	{
+		BOOST_REQUIRE(reader.read(&event));
+		BOOST_REQUIRE(event.kind == holo::allocation_event::kind_allocate);
+		BOOST_REQUIRE(event.thread == 0);
+		BOOST_REQUIRE(event.timestamp >= previous_timestamp);
+		BOOST_REQUIRE(event.address == (std::uint64_t)(std::uintptr_t)objects[i]);
+		BOOST_REQUIRE(event.size == i + 1);
+		BOOST_REQUIRE(event.alignment == (std::size_t)8 << (i % 4));
+
+		previous_timestamp = event.timestamp;
+	}
+
+	for (std::size_t i = 0; i < config::batch_count * 2; ++i)
+	{
+		BOOST_REQUIRE(reader.read(&event));
+		BOOST_REQUIRE(event.address == (std::uint64_t)(std::uintptr_t)batch[i % config::batch_count]);
+	}
+
+	for (std::size_t i = 0; i < config::object_count; i += 2)
+	{
+		BOOST_REQUIRE(reader.read(&event));
+		BOOST_REQUIRE(event.kind == holo::allocation_event::kind_deallocate);
+		BOOST_REQUIRE(event.address == (std::uint64_t)(std::uintptr_t)objects[i]);
+		BOOST_REQUIRE(event.size == 0);
+
+		BOOST_REQUIRE(reader.read(&event));
+		BOOST_REQUIRE(event.kind == holo::allocation_event::kind_sized_deallocate);
+		BOOST_REQUIRE(event.address == (std::uint64_t)(std::uintptr_t)objects[i + 1]);
+		BOOST_REQUIRE(event.size == i + 2);
+	}
+
+	BOOST_REQUIRE(!reader.read(&event));
+}
+
+BOOST_AUTO_TEST_CASE(reading_invalid_traces)
+{
+	buffer[0] = 'X';
+	holo::memory_stream invalid_input(buffer, 5, true, false);
+	holo::allocation_trace_reader invalid_reader(&invalid_input);
+	BOOST_REQUIRE(!invalid_reader.is_valid());
+
+	holo::memory_stream output(buffer, config::trace_buffer_size, false, true);
+	{
+		holo::tracing_allocator_proxy proxy(&allocator, &output);
+		proxy.deallocate(proxy.allocate(0x1000));
+	}
+
+	// Cut the last event short.
+	holo::memory_stream truncated_input(buffer, output.get_position() - 1, true, false);
+	holo::allocation_trace_reader truncated_reader(&truncated_input);
+	BOOST_REQUIRE(truncated_reader.is_valid());
+
+	holo::allocation_event event;
+	BOOST_REQUIRE(truncated_reader.read(&event));
+	BOOST_REQUIRE(!truncated_reader.read(&event));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,151 @@
+// This file is a part of Hologine.
+//
+// Hologine is a straight-forward framework for interactive simulations,
+// most notably video games.
+//
+// Copyright 2015 Aaron Bolyard.
+//
+// For licensing information, review the LICENSE file located at the root
+// directory of the source package.
+#include <boost/test/unit_test.hpp>
+#include <numeric>
+#include "core/platform.hpp"
+#include "core/container/virtual_array.hpp"
+
+namespace config
+{
+	const static std::size_t array_max_count = 0x100000u;
+
+	// Enough elements to span several commits.
+	const static std::size_t array_fill_count = 0x10000u;
+}
+
+namespace
+{
+	// Counts live instances, to ensure elements are destroyed.
+	struct counted_element
+	{
+		counted_element(std::size_t value = 0);
+		counted_element(const counted_element& other);
+		~counted_element();
+
+		std::size_t value;
+
+		static std::size_t live_count;
+	};
+
+	std::size_t counted_element::live_count = 0;
+
+	counted_element::counted_element(std::size_t value) :
+		value(value)
+	{
+		++live_count;
+	}
+
+	counted_element::counted_element(const counted_element& other) :
+		value(other.value)
+	{
+		++live_count;
+	}
+
+	counted_element::~counted_element()
+	{
+		--live_count;
+	}
+}
+
+struct virtual_array_test
+{
+	virtual_array_test();
+	~virtual_array_test();
+
+	holo::virtual_array<std::size_t> array;
+};
+
+virtual_array_test::virtual_array_test() :
+	array(config::array_max_count)
+{
+	// Nothing.
+}
+
+virtual_array_test::~virtual_array_test()
+{
+	// Nothing.
+}
+
+BOOST_FIXTURE_TEST_SUITE(virtual_array_test_suite, virtual_array_test)
+
+BOOST_AUTO_TEST_CASE(stable_addresses)
+{
+	BOOST_REQUIRE(array.is_empty());
+	BOOST_REQUIRE(array.get_committed_count() == 0);
+
+	std::size_t* first = array.push_back(0);
+	BOOST_REQUIRE(first != nullptr);
+
+	for (std::size_t i = 1; i < config::array_fill_count; ++i)
+	{
+		BOOST_REQUIRE(array.push_back(i) == first + i);
+	}
+
+	// Growing never moves elements.
+	BOOST_REQUIRE(array.get_data() == first);
+	BOOST_REQUIRE(array.get_count() == config::array_fill_count);
+	BOOST_REQUIRE(array.get_committed_count() >= config::array_fill_count);
+	BOOST_REQUIRE(array.get_committed_count() < config::array_max_count);
+
+	std::size_t expected_sum = config::array_fill_count * (config::array_fill_count - 1) / 2;
+	BOOST_REQUIRE(std::accumulate(array.begin(), array.end(), std::size_t(0)) == expected_sum);
+
+	array.pop_back();
+	BOOST_REQUIRE(array.get_count() == config::array_fill_count - 1);
+	BOOST_REQUIRE(array[config::array_fill_count - 2] == config::array_fill_count - 2);
+}
+
+BOOST_AUTO_TEST_CASE(bulk_append)
+{
+	std::size_t values[0x100];
+	std::iota(values, values + 0x100, 0);
+
+	std::size_t* first = array.append(values, 0x100);
+	BOOST_REQUIRE(first == array.get_data());
+
+	std::size_t* second = array.append(values, 0x100);
+	BOOST_REQUIRE(second == first + 0x100);
+	BOOST_REQUIRE(array[0x1ff] == 0xff);
+
+	// Appending past the maximum fails without appending anything.
+	BOOST_REQUIRE(array.append(config::array_max_count) == nullptr);
+	BOOST_REQUIRE(array.get_count() == 0x200);
+
+	BOOST_REQUIRE(array.reserve(config::array_max_count));
+	BOOST_REQUIRE(array.append(config::array_max_count - 0x200) == first + 0x200);
+	BOOST_REQUIRE(array.push_back(0) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(destroying_elements)
+{
+	{
+		holo::virtual_array<counted_element> elements(config::array_max_count);
+
+		BOOST_REQUIRE(elements.emplace_back(1) != nullptr);
+		BOOST_REQUIRE(elements.append(0x10) != nullptr);
+		BOOST_REQUIRE(counted_element::live_count == 0x11);
+
+		holo::virtual_array<counted_element> moved(std::move(elements));
+		BOOST_REQUIRE(elements.get_count() == 0);
+		BOOST_REQUIRE(moved.get_count() == 0x11);
+		BOOST_REQUIRE(moved[0].value == 1);
+
+		moved.pop_back();
+		BOOST_REQUIRE(counted_element::live_count == 0x10);
+
+		counted_element copied(2);
+		BOOST_REQUIRE(moved.append(&copied, 1)->value == 2);
+		BOOST_REQUIRE(counted_element::live_count == 0x12);
+	}
+
+	BOOST_REQUIRE(counted_element::live_count == 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -83,13 +83,21 @@ return function(project_name, project_target_name, root_path, platforms, deps, a
 			end
 		end
 		
+		local cpp_standard = _OPTIONS["cpp-standard"] or "11"
+
 		filter "action:gmake"
-			buildoptions { "-std=c++11" }
+			buildoptions { "-std=c++" .. cpp_standard }
 			defines { "HOLOGINE_INTRINSICS_GCC_COMPATIBLE" }
 
 		filter "action:vs*"
 			defines { "HOLOGINE_INTRINSICS_MSVC_COMPATIBLE" }
 
+		-- MSVC only reports the real standard in __cplusplus when asked to.
+		if cpp_standard ~= "11" then
+			filter "action:vs*"
+				buildoptions { "/std:c++" .. cpp_standard, "/Zc:__cplusplus" }
+		end
+
 		filter "options:enable-tests"
 			defines { "HOLOGINE_TESTING_ENABLED" }
 		
@@ -22,6 +22,11 @@ newoption {
 	description = "Enable unit testing"
 }
 
+newoption {
+	trigger = "enable-benchmarks",
+	description = "Enable benchmarks"
+}
+
 newoption {
 	trigger = "endian",
 	description = "Set endian mode of target system",
@@ -31,12 +36,29 @@ newoption {
 	}
 }
 
+newoption {
+	trigger = "cpp-standard",
+	value = "VERSION",
+	description = "Set the C++ standard to build with",
+	allowed = {
+		{ "11", "C++11 (default)" },
+		{ "17", "C++17; enables std::pmr support" }
+	}
+}
+
 newoption {
 	trigger = "prefix",
 	value = "PATH",
 	description = "Additional include and library path for dependencies"
 }
 
+-- Libraries required by the platform library on the target platform. Any
+-- project linking against the platform library must link these as well.
+local platform_lib_deps = {}
+if os.get() == "linux" then
+	table.insert(platform_lib_deps, hologine_config.make_library("pthread"))
+end
+
 hologine_config.solution = hologine_config.make_solution(HOLOGINE_SOLUTION_NAME)
 hologine_config.solution.platform_lib = hologine_config.make_project(
 	HOLOGINE_PLATFORM_LIBRARY_PROJECT_NAME, "hologine_platform", "code/hologine_platform/hologine",
@@ -58,6 +80,10 @@ if _OPTIONS["enable-tests"] then
 		-- Insert reference to Boost unit testing framework.
 		table.insert(deps, hologine_config.make_library("boost_unit_test_framework"))
 
+		for i = 1, #platform_lib_deps do
+			table.insert(deps, platform_lib_deps[i])
+		end
+
 		hologine_config.solution[name] = hologine_config.make_project(
 			name, name, "code/" .. name, nil, deps, { hologine_config.attributes.is_console_app(true) }
 		)
@@ -67,6 +93,23 @@ if _OPTIONS["enable-tests"] then
 			{ hologine_config.solution.platform_lib })
 end
 
+if _OPTIONS["enable-benchmarks"] then
+	-- Utility method to add a benchmark suite; like test suites, the benchmark
+	-- suite must be located in directory 'name' inside the code directory.
+	local function add_benchmark_suite(name, deps)
+		for i = 1, #platform_lib_deps do
+			table.insert(deps, platform_lib_deps[i])
+		end
+
+		hologine_config.solution[name] = hologine_config.make_project(
+			name, name, "code/" .. name, nil, deps, { hologine_config.attributes.is_console_app(true) }
+		)
+	end
+
+	add_benchmark_suite("hologine_platform_benchmarks",
+			{ hologine_config.solution.platform_lib })
+end
+
 newaction {
 	trigger = "import-project",
 	description = "Imports a project that depends on Hologine.",